@@ -27,6 +27,8 @@
 
 #include <mcore.h>
 #include <maligned_malloc.h>
+#include <mplatform.h>
+#include <new>
 
 namespace mst {
 
@@ -142,4 +144,79 @@ public:
 	};
 };
 
-} // namespace mst
\ No newline at end of file
+// Allocates whole pages straight from the operating system, every allocation is rounded up to and
+// aligned on platform::page_size(). With _HugePages, memory is advised to be backed by transparent
+// huge pages (Linux only, ignored elsewhere): allocations of 2MB and up are aligned on 2MB, smaller
+// ones are carved out of shared 2MB arenas. An arena is unmapped once all of its allocations are
+// freed, so long lived small allocations can keep the rest of their arena alive.
+template<typename _Ty, bool _HugePages = false>
+class page_allocator
+{
+public:
+	typedef _Ty value_type;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	typedef _Ty* pointer;
+	typedef const _Ty* const_pointer;
+	typedef _Ty& reference;
+	typedef const _Ty& const_reference;
+
+	page_allocator() = default;
+
+	template<typename T2>
+	page_allocator(const page_allocator<T2, _HugePages>&)
+	{
+		// do nothing
+	}
+
+	void deallocate(pointer ptr, size_t count)
+	{
+		::mst::_Details::free_pages_impl(ptr, _round_to_pages(count), _HugePages);
+	}
+
+	pointer allocate(size_t count)
+	{
+		void* memory = ::mst::_Details::allocate_pages_impl(_round_to_pages(count), _HugePages);
+
+		if(memory == nullptr)
+		{
+#if _MST_HAS_EXCEPTIONS
+			throw std::bad_alloc();
+#else
+			::std::abort();
+#endif
+		}
+
+		return reinterpret_cast<pointer>(memory);
+	}
+
+	template<typename T2>
+	struct rebind
+	{
+		typedef page_allocator<T2, _HugePages> other;
+	};
+
+	template<typename T2>
+	_MST_NODISCARD bool operator==(const page_allocator<T2, _HugePages>&) const noexcept
+	{
+		return true;
+	}
+
+	template<typename T2>
+	_MST_NODISCARD bool operator!=(const page_allocator<T2, _HugePages>&) const noexcept
+	{
+		return false;
+	}
+
+private:
+	static inline size_t _round_to_pages(size_t count) noexcept
+	{
+		const size_t pageSize = ::mst::platform::page_size();
+
+		const size_t size = (count == 0 ? 1 : count) * sizeof(_Ty);
+
+		return (size + pageSize - 1) & ~(pageSize - 1);
+	}
+};
+
+} // namespace mst
@@ -27,12 +27,37 @@
 
 #include <mcore.h>
 #include <vector>
+#include <algorithm>
+#include <iterator>
 #include <mdebug.h>
 #include <mx_common.h>
 #include <mx_packed_pair.h>
 #include <initializer_list>
 
+#if _MST_USING_VC_COMPILER
+#include <intrin.h>
+#endif
+
 namespace mst {
+namespace _Details {
+
+// the number of trailing one bits of value
+_MST_NODISCARD inline uint32_t _Array_map_trailing_ones(size_t value) noexcept
+{
+#if _MST_USING_VC_COMPILER
+	unsigned long index;
+#if _MST_HAS_64BIT
+	_BitScanForward64(&index, ~value);
+#else
+	_BitScanForward(&index, ~value);
+#endif
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(__builtin_ctzll(~static_cast<unsigned long long>(value)));
+#endif
+}
+
+} // namespace _Details
 
 template<typename KeyType, typename ValueType, typename ComparisonType = ::std::less<KeyType>,
 	typename ContainerType = ::std::vector<::std::pair<KeyType, ValueType>>>
@@ -59,35 +84,49 @@ public:
 
 	inline array_map(const array_map& other)
 		: _Mypair(ComparisonType(), other._Mypair._Get_second())
+		, _Myeytzinger(other._Myeytzinger)
+		, _Myeytzinger_pos(other._Myeytzinger_pos)
+		, _Mydelta_size(other._Mydelta_size)
 	{ }
 
 	inline array_map(const array_map&& other)
 		: _Mypair(ComparisonType(), std::move(other._Mypair._Get_second()))
+		, _Myeytzinger(other._Myeytzinger)
+		, _Myeytzinger_pos(other._Myeytzinger_pos)
+		, _Mydelta_size(other._Mydelta_size)
 	{ }
 
 	inline array_map& operator=(const array_map& other)
 	{
 		_Mypair._Get_second() = other._Mypair._Get_second();
+		_Myeytzinger = other._Myeytzinger;
+		_Myeytzinger_pos = other._Myeytzinger_pos;
+		_Mydelta_size = other._Mydelta_size;
 		return *this;
 	}
 
 	inline array_map& operator=(array_map&& other)
 	{
 		_Mypair._Get_second() = std::move(other._Mypair._Get_second());
+		_Myeytzinger = std::move(other._Myeytzinger);
+		_Myeytzinger_pos = std::move(other._Myeytzinger_pos);
+		_Mydelta_size = other._Mydelta_size;
+		other._Mydelta_size = 0;
 		return *this;
 	}
 
 	inline array_map(std::initializer_list<value_type> initList)
 		: _Mypair()
 	{
-		reserve(initList.size());
-
-		for(const value_type* it = initList.begin(); it != initList.end(); ++it)
-		{
-			insert(*it);
-		}
+		insert(initList.begin(), initList.end());
+	}
 
-		// insert(initList.begin(), initList.end());
+	// Takes the pairs of an unsorted container, sorting it and dropping duplicate keys once.
+	// Of duplicate keys, the first one is kept, as if the pairs were inserted in order.
+	inline explicit array_map(container_type unsortedPairs)
+		: _Mypair(ComparisonType(), std::move(unsortedPairs))
+	{
+		_Sort_unique(_Get_begin());
 	}
 
 	inline ~array_map()
@@ -110,16 +149,22 @@ public:
 
 	inline iterator begin()
 	{
+		_Assert_consolidated();
+
 		return _To_extern(_Get_begin());
 	}
 
 	inline const_iterator begin() const
 	{
+		_Assert_consolidated();
+
 		return _To_extern(_Get_begin());
 	}
 
 	inline const_iterator cbegin() const
 	{
+		_Assert_consolidated();
+
 		return _To_extern(_Get_begin());
 	}
 
@@ -156,6 +201,7 @@ public:
 
 	mapped_type& front()
 	{
+		_Assert_consolidated();
 		MST_ASSERT(!empty(), "cannot call front() on empty container");
 
 		return _Get_cont().front().second;
@@ -163,6 +209,7 @@ public:
 
 	const mapped_type& front() const
 	{
+		_Assert_consolidated();
 		MST_ASSERT(!empty(), "cannot call front() on empty container");
 
 		return _Get_cont().front().second;
@@ -170,6 +217,7 @@ public:
 
 	mapped_type& back()
 	{
+		_Assert_consolidated();
 		MST_ASSERT(!empty(), "cannot call back() on empty container");
 
 		return _Get_cont().back().second;
@@ -177,6 +225,7 @@ public:
 
 	const mapped_type& back() const
 	{
+		_Assert_consolidated();
 		MST_ASSERT(!empty(), "cannot call back() on empty container");
 
 		return _Get_cont().back().second;
@@ -186,52 +235,42 @@ public:
 	{
 		MST_ASSERT(!empty(), "cannot call at() on empty containers");
 
-		_Cont_iter it = _Lower_bound(key);
-		if(it == _Get_end() || _Get_comp()(key, it->first))
+		const size_t offset = _Find_offset(key);
+		if(offset == size())
 		{
 			MST_FATAL_ERROR("key not found");
 		}
 
-		return it->second;
+		return _Get_cont()[offset].second;
 	}
 
 	inline const mapped_type& at(const key_type& key) const
 	{
 		MST_ASSERT(!empty(), "cannot call at() on empty containers");
 
-		_Cont_const_iter it = _Lower_bound(key);
-		if(it == _Get_end() || _Get_comp()(key, it->first) /*_MST_INVALID_KEY(it, key)*/)
+		const size_t offset = _Find_offset(key);
+		if(offset == size())
 		{
 			throw std::out_of_range("key not found");
 		}
 
-		return it->second;
+		return _Get_cont()[offset].second;
 	}
 
 	inline iterator find(const key_type& key)
 	{
-		_Cont_iter it = _Lower_bound(key);
-		if(it == _Get_end() || _Get_comp()(key, it->first) /*_MST_INVALID_KEY(it, key)*/)
-		{
-			return end();
-		}
-
-		return _To_extern(it);
+		return _To_extern(_Get_begin() + (ptrdiff_t)_Find_offset(key));
 	}
 
 	inline const_iterator find(const key_type& key) const
 	{
-		_Cont_const_iter it = _Lower_bound(key);
-		if(it == _Get_end() || _Get_comp()(key, it->first) /*_MST_INVALID_KEY(it, key)*/)
-		{
-			return end();
-		}
-
-		return _To_extern(it);
+		return _To_extern(_Get_begin() + (ptrdiff_t)_Find_offset(key));
 	}
 
 	inline mapped_type& operator[](const key_type& key)
 	{
+		consolidate();
+
 		if(empty())
 		{
 			//			std::pair<key_type, mapped_type>(key, mapped_type());
@@ -253,12 +292,13 @@ public:
 
 	inline bool contains(const key_type& key) const
 	{
-		_Cont_const_iter it = _Lower_bound(key);
-		return it != _Get_end() && !_Get_comp()(key, it->first); // _MST_VALID_KEY(it, key);
+		return _Find_offset(key) != size();
 	}
 
 	inline const key_type& get_key(size_t index) const
 	{
+		_Assert_consolidated();
+
 		return _Get_cont()[index].first;
 	}
 
@@ -278,15 +318,85 @@ public:
 		_Insert(::std::forward<PairType>(keyValueTypePair));
 	}
 
+	// Inserts the pairs of [first, last) in O(n log n + size()), by appending them, sorting the
+	// new run once and merging it with the existing pairs. Like insert(), keys already in the map
+	// keep their value, and of duplicate keys in the range the first one is kept.
+	template<typename InputIt>
+	inline void insert(InputIt first, InputIt last)
+	{
+		consolidate();
+
+		const auto oldSize = size();
+		_Get_cont().insert(_Get_end(), first, last);
+
+		_Sort_unique(_Get_begin() + (ptrdiff_t)oldSize);
+	}
+
+	// Like insert(first, last), for a range that is already sorted and has unique keys
+	template<typename InputIt>
+	inline void insert_sorted_unique(InputIt first, InputIt last)
+	{
+		consolidate();
+
+		const auto oldSize = size();
+		_Get_cont().insert(_Get_end(), first, last);
+
+		const auto middle = _Get_begin() + (ptrdiff_t)oldSize;
+
+		MST_ASSERT(::std::adjacent_find(middle, _Get_end(),
+					   [&](const auto& left, const auto& right) {
+						   return !_Get_comp()(left.first, right.first);
+					   }) == _Get_end(),
+			"range is not sorted or has duplicate keys");
+
+		_Merge_unique(middle);
+	}
+
+	// Inserts into a small sorted buffer at the end of the map, instead of shifting the pairs
+	// after the key. Lookups search the buffer after the sorted pairs, and the buffer is merged in
+	// once it grows past the square root of the map's size, by consolidate(), or by any other
+	// insertion. Until then, the map can't be iterated in order. Like insert(), keys already in
+	// the map keep their value.
+	inline void insert_buffered(const value_type& keyValueTypePair)
+	{
+		_Insert_buffered(keyValueTypePair);
+	}
+
+	template<typename PairType>
+	inline void insert_buffered(PairType&& keyValueTypePair)
+	{
+		_Insert_buffered(::std::forward<PairType>(keyValueTypePair));
+	}
+
+	// merges the pairs buffered by insert_buffered() into the sorted pairs
+	inline void consolidate()
+	{
+		if(_Mydelta_size == 0)
+		{
+			return;
+		}
+
+		const auto middle = _Get_end() - (ptrdiff_t)_Mydelta_size;
+		_Mydelta_size = 0;
+
+		_Merge_unique(middle);
+	}
+
+	// the number of pairs buffered by insert_buffered(), which consolidate() merges in
+	_MST_NODISCARD inline size_t buffered_size() const
+	{
+		return _Mydelta_size;
+	}
+
 	inline void erase(const key_type& key)
 	{
 		MST_ASSERT(!empty(), "cannot call erase on empty container");
 
-		_Cont_iter it = _Lower_bound(key);
+		const size_t offset = _Find_offset(key);
 
-		MST_ASSERT(it != _Get_end() && !_Get_comp()(key, it->first), "key is not found");
+		MST_ASSERT(offset != size(), "key is not found");
 
-		erase(_To_extern(it));
+		_Erase(_To_extern(_Get_begin() + (ptrdiff_t)offset));
 	}
 
 	inline iterator erase(iterator iter)
@@ -298,23 +408,59 @@ public:
 		return _Erase(iter);
 	}
 
+	// Builds a read-optimized index over the keys. Lookups then do a branchless, prefetched
+	// search over the keys in Eytzinger (breadth first) order, instead of a binary search over
+	// the pairs. A frozen map stays frozen, every insertion or erasure rebuilds the index.
+	inline void freeze()
+	{
+		consolidate();
+
+		// the index of a frozen map is kept up to date
+		if(!is_frozen())
+		{
+			_Freeze();
+		}
+	}
+
+	// drops the index built by freeze()
+	inline void thaw()
+	{
+		_Myeytzinger.clear();
+		_Myeytzinger.shrink_to_fit();
+		_Myeytzinger_pos.clear();
+		_Myeytzinger_pos.shrink_to_fit();
+	}
+
+	_MST_NODISCARD inline bool is_frozen() const
+	{
+		return !_Myeytzinger_pos.empty();
+	}
+
 	iterator lower_bound(const key_type& key)
 	{
+		_Assert_consolidated();
+
 		return _To_extern(_Lower_bound(key));
 	}
 
 	const_iterator lower_bound(const key_type& key) const
 	{
+		_Assert_consolidated();
+
 		return _To_extern(_Lower_bound(key));
 	}
 
 	iterator upper_bound(const key_type& key)
 	{
+		_Assert_consolidated();
+
 		return _To_extern(_Upper_bound(key));
 	}
 
 	const_iterator upper_bound(const key_type& key) const
 	{
+		_Assert_consolidated();
+
 		return _To_extern(_Upper_bound(key));
 	}
 
@@ -327,10 +473,185 @@ private:
 	inline void _Tidy()
 	{
 		_Get_cont().clear();
+		_Mydelta_size = 0;
+		_Refreeze();
+	}
+
+	inline void _Assert_consolidated() const
+	{
+		MST_ASSERT(_Mydelta_size == 0, "consolidate() the buffered inserts first");
+	}
+
+	// builds the index over the sorted pairs, leaving out the buffered ones
+	inline void _Freeze()
+	{
+		const size_t count = size() - _Mydelta_size;
+
+		MST_ASSERT(count < UINT32_MAX, "too many keys to freeze");
+
+		_Myeytzinger.resize(count + 1);
+		_Myeytzinger_pos.resize(count + 1);
+
+		// node 0 is the end of the search
+		_Myeytzinger_pos[0] = static_cast<uint32_t>(count);
+
+		size_t position = 0;
+		_Build_eytzinger(position, 1);
+	}
+
+	inline void _Refreeze()
+	{
+		if(is_frozen())
+		{
+			_Freeze();
+		}
+	}
+
+	// the offset of key in the container, or size() when the map doesn't contain it
+	inline size_t _Find_offset(const key_type& key) const
+	{
+		const auto bufferBegin = _Get_end() - (ptrdiff_t)_Mydelta_size;
+
+		const size_t offset =
+			is_frozen() ? _Eytzinger_find(key) : _Find_in(_Get_begin(), bufferBegin, key);
+
+		if(offset == size() && _Mydelta_size != 0)
+		{
+			return _Find_in(bufferBegin, _Get_end(), key);
+		}
+
+		return offset;
+	}
+
+	// the offset of key in the sorted run [first, last), or size() when it's not there
+	inline size_t _Find_in(_Cont_const_iter first, _Cont_const_iter last, const key_type& key) const
+	{
+		const _Cont_const_iter it = _Lower_bound_in(first, last, key);
+		if(it == last || _Get_comp()(key, it->first))
+		{
+			return size();
+		}
+
+		return (size_t)(it - _Get_begin());
+	}
+
+	inline _Cont_const_iter _Lower_bound_in(
+		_Cont_const_iter first, _Cont_const_iter last, const key_type& key) const
+	{
+		auto range = last - first;
+
+		while(range != 0)
+		{
+			const auto halfRange = range >> 1;
+
+			const _Cont_const_iter middleIter = first + halfRange;
+
+			if(_Get_comp()(middleIter->first, key))
+			{
+				MST_ASSERT(!_Get_comp()(key, middleIter->first), "invalid comparison operations");
+				first = middleIter + 1;
+				range -= halfRange + 1;
+			}
+			else
+			{
+				range = halfRange;
+			}
+		}
+
+		return first;
+	}
+
+	template<typename PairType>
+	inline void _Insert_buffered(PairType&& keyValueTypePair)
+	{
+		if(_Find_offset(keyValueTypePair.first) != size())
+		{
+			return;
+		}
+
+		const auto it = _Lower_bound_in(
+			_Get_end() - (ptrdiff_t)_Mydelta_size, _Get_end(), keyValueTypePair.first);
+
+		_Get_cont().insert(it, ::std::forward<PairType>(keyValueTypePair));
+		++_Mydelta_size;
+
+		// merging costs O(size()), so merging every sqrt(size()) inserts balances it with the
+		// O(_Mydelta_size) shifts into the buffer
+		constexpr size_t minBufferSize = 32;
+		if(_Mydelta_size > minBufferSize &&
+			_Mydelta_size * _Mydelta_size > size() - _Mydelta_size)
+		{
+			consolidate();
+		}
+	}
+
+	// fills the subtree at node with the keys from position on, in order
+	inline void _Build_eytzinger(size_t& position, size_t node)
+	{
+		if(node >= _Myeytzinger.size())
+		{
+			return;
+		}
+
+		_Build_eytzinger(position, node * 2);
+
+		_Myeytzinger[node] = _Get_cont()[position].first;
+		_Myeytzinger_pos[node] = static_cast<uint32_t>(position);
+		++position;
+
+		_Build_eytzinger(position, node * 2 + 1);
+	}
+
+	// The position of the first key that is not less than key, or with Upper, greater than key
+	template<bool Upper>
+	inline size_t _Eytzinger_bound(const key_type& key) const
+	{
+		return _Myeytzinger_pos[_Eytzinger_node<Upper>(key)];
+	}
+
+	// the position of key, or size() when the map doesn't contain it
+	inline size_t _Eytzinger_find(const key_type& key) const
+	{
+		// the bound's node holds its key, which saves loading the pair
+		const size_t node = _Eytzinger_node<false>(key);
+		if(node == 0 || _Get_comp()(key, _Myeytzinger[node]))
+		{
+			return size();
+		}
+
+		return _Myeytzinger_pos[node];
+	}
+
+	// The node of the bound, 0 being the end. The descent always takes log2(size()) steps, and
+	// prefetches the nodes a cache line of keys deeper, so the memory loads of the next levels
+	// overlap.
+	template<bool Upper>
+	inline size_t _Eytzinger_node(const key_type& key) const
+	{
+		constexpr size_t prefetchStride = 64 / sizeof(KeyType) > 0 ? 64 / sizeof(KeyType) : 1;
+
+		const KeyType* const nodes = _Myeytzinger.data();
+		const size_t count = _Myeytzinger.size();
+
+		size_t node = 1;
+		while(node < count)
+		{
+			_MST_PREFETCH(nodes + node * prefetchStride);
+
+			if constexpr(Upper)
+				node = node * 2 + static_cast<size_t>(!_Get_comp()(key, nodes[node]));
+			else
+				node = node * 2 + static_cast<size_t>(_Get_comp()(nodes[node], key));
+		}
+
+		// undo the right turns after the last left turn, which went to the bound
+		return node >> (::mst::_Details::_Array_map_trailing_ones(node) + 1);
 	}
 
 	inline iterator _Insert(const value_type& keyValueTypePair)
 	{
+		consolidate();
+
 		if(empty())
 		{
 			return _Construct(0, keyValueTypePair);
@@ -349,14 +670,62 @@ private:
 		}
 	}
 
+	// sorts the pairs from first on by key, keeping the first of equal keys, and merges them in
+	inline void _Sort_unique(_Cont_iter first)
+	{
+		::std::stable_sort(first, _Get_end(), [&](const auto& left, const auto& right) {
+			return _Get_comp()(left.first, right.first);
+		});
+
+		_Merge_unique(first);
+	}
+
+	// merges the sorted pairs from middle on with the ones before it, where those win equal keys
+	inline void _Merge_unique(_Cont_iter middle)
+	{
+		const auto keyLess = [&](const auto& left, const auto& right) {
+			return _Get_comp()(left.first, right.first);
+		};
+
+		// appending keys past the current last key needs no merge
+		if(middle != _Get_begin() && middle != _Get_end() && !keyLess(*(middle - 1), *middle))
+		{
+			::std::inplace_merge(_Get_begin(), middle, _Get_end(), keyLess);
+		}
+
+		_Get_cont().erase(::std::unique(_Get_begin(), _Get_end(),
+							  [&](const auto& left, const auto& right) {
+								  return !keyLess(left, right);
+							  }),
+			_Get_end());
+
+		_Refreeze();
+	}
+
 	inline iterator _Erase(iterator eraseIterator)
 	{
-		return _To_extern(_Get_cont().erase(_From_extern(eraseIterator)));
+		const auto offset = _From_extern(eraseIterator) - _Get_begin();
+		const bool isBuffered = (size_t)offset >= size() - _Mydelta_size;
+		_Get_cont().erase(_From_extern(eraseIterator));
+
+		// the index only covers the sorted pairs before the buffer
+		if(isBuffered)
+		{
+			--_Mydelta_size;
+		}
+		else
+		{
+			_Refreeze();
+		}
+
+		return _To_extern(_Get_begin() + offset);
 	}
 
 	template<typename PairType>
 	inline iterator _Insert(PairType&& keyValueTypePair)
 	{
+		consolidate();
+
 		if(empty())
 		{
 			return _Construct(0, ::std::forward<PairType>(keyValueTypePair));
@@ -380,8 +749,10 @@ private:
 		//::std::memmove(_Mybegin + offset + 1, _Mybegin + offset, (size() - offset - 1) *
 		// sizeof(value_type));
 
-		return _To_extern(
-			_Get_cont().insert(_Get_cbegin() + offset, ::std::forward<PairType>(keyValueTypePair)));
+		_Get_cont().insert(_Get_cbegin() + offset, ::std::forward<PairType>(keyValueTypePair));
+		_Refreeze();
+
+		return _To_extern(_Get_begin() + offset);
 
 		// new (_Mybegin + offset) value_type(::std::forward<PairType>(keyValueTypePair));
 	}
@@ -415,6 +786,11 @@ private:
 
 	inline _Cont_iter _Lower_bound(const key_type& key)
 	{
+		if(is_frozen())
+		{
+			return _Get_begin() + (ptrdiff_t)_Eytzinger_bound<false>(key);
+		}
+
 		auto range = (ptrdiff_t)size();
 
 		_Cont_iter beginIter = _Get_begin();
@@ -442,6 +818,11 @@ private:
 
 	inline _Cont_iter _Upper_bound(const key_type& key)
 	{
+		if(is_frozen())
+		{
+			return _Get_begin() + (ptrdiff_t)_Eytzinger_bound<true>(key);
+		}
+
 		auto range = (ptrdiff_t)size();
 
 		_Cont_iter beginIter = _Get_begin();
@@ -469,6 +850,11 @@ private:
 
 	inline _Cont_const_iter _Lower_bound(const key_type& key) const
 	{
+		if(is_frozen())
+		{
+			return _Get_begin() + (ptrdiff_t)_Eytzinger_bound<false>(key);
+		}
+
 		auto range = (ptrdiff_t)size();
 
 		_Cont_const_iter beginIter = _Get_begin();
@@ -496,6 +882,11 @@ private:
 
 	inline _Cont_const_iter _Upper_bound(const key_type& key) const
 	{
+		if(is_frozen())
+		{
+			return _Get_begin() + (ptrdiff_t)_Eytzinger_bound<true>(key);
+		}
+
 		auto range = (ptrdiff_t)size();
 
 		_Cont_const_iter beginIter = _Get_begin();
@@ -578,17 +969,24 @@ private:
 
 	inline _Cont_iter _From_extern(iterator iter)
 	{
-		return _Get_begin() + (iter - begin());
+		return _Get_begin() + (iter - _To_extern(_Get_begin()));
 	}
 
 	inline _Cont_const_iter _From_extern(const_iterator iter) const
 	{
-		return _Get_begin() + (iter - begin());
+		return _Get_begin() + (iter - _To_extern(_Get_begin()));
 	}
 
 private:
 	::mst::_Details::_Packed_pair<ComparisonType, container_type> _Mypair;
 
+	// the keys in Eytzinger order and their positions in the container, see freeze()
+	::std::vector<KeyType> _Myeytzinger;
+	::std::vector<uint32_t> _Myeytzinger_pos;
+
+	// the number of pairs at the end of the container buffered by insert_buffered()
+	size_t _Mydelta_size = 0;
+
 }; // class array_map<KeyType, ValueType, ComparisonType, AllocatorType>
 
 
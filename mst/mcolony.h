@@ -28,11 +28,24 @@
 #include <mcore.h>
 #include <mdebug.h>
 #include <cstring>
+#include <array>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <memory>
 
 #if _MST_HAS_INVOKE
 #include <functional>
 #endif
 
+#if _MST_HAS_AVX2
+#include <immintrin.h>
+#endif
+
+#if _MST_USING_VC_COMPILER
+#include <intrin.h>
+#endif
+
 #ifndef MST_DEFAULT_COLONY_PAGE_SIZE
 #define MST_DEFAULT_COLONY_PAGE_SIZE 8192
 #endif // !MST_DEFAULT_COLONY_PAGE_SIZE
@@ -41,207 +54,1371 @@
 
 namespace mst {
 
-template<typename T>
+template<typename T, int32_t ElementsPerPage = MST_DEFAULT_COLONY_PAGE_SIZE,
+	typename Allocator = std::allocator<T>>
+class colony;
+
+template<typename T, int32_t ElementsPerPage = MST_DEFAULT_COLONY_PAGE_SIZE,
+	typename Allocator = std::allocator<T>>
 class colony_iterator;
 
-template<typename T>
+template<typename T, int32_t ElementsPerPage = MST_DEFAULT_COLONY_PAGE_SIZE,
+	typename Allocator = std::allocator<T>>
 class colony_const_iterator;
 
-template<typename T>
+template<typename T, int32_t ElementsPerPage = MST_DEFAULT_COLONY_PAGE_SIZE,
+	typename Allocator = std::allocator<T>>
 class colony_reverse_iterator;
 
-template<typename T>
+template<typename T, int32_t ElementsPerPage = MST_DEFAULT_COLONY_PAGE_SIZE,
+	typename Allocator = std::allocator<T>>
 class colony_const_reverse_iterator;
 
-template<typename T, int32_t ElementsPerPage = MST_DEFAULT_COLONY_PAGE_SIZE>
-class colony
+namespace _Details {
+
+template<int32_t ElementsPerPage>
+struct colony_released_page
 {
-	static_assert(ElementsPerPage > 0 && (ElementsPerPage & (ElementsPerPage - 1)) == 0,
-		"ElementsPerPage must be a power of two");
+	// skip field shared by all released pages: a single free block spanning the whole page
+	_MST_NODISCARD static const int32_t* skips() noexcept
+	{
+		static const std::array<int32_t, ElementsPerPage> values = [] {
+			std::array<int32_t, ElementsPerPage> retval;
+			retval.fill(1);
+			retval.front() = ElementsPerPage;
+			retval.back() = ElementsPerPage;
+			return retval;
+		}();
+
+		return values.data();
+	}
+};
 
-	struct FreeListNode
+// number of skip field entries inspected at once by colony_live_mask()
+constexpr int32_t colony_scan_width = 16;
+
+// Returns a mask with bit i set when skips[i] is 0, i.e. when slot i holds a live element.
+// The slots inside a free block are never 0, so the mask is exact without following any skips.
+_MST_NODISCARD inline uint32_t colony_live_mask(const int32_t* skips) noexcept
+{
+#if _MST_HAS_AVX2
+	const auto zero = _mm256_setzero_si256();
+	const auto low = _mm256_cmpeq_epi32(
+		_mm256_loadu_si256(reinterpret_cast<const __m256i*>(skips)), zero);
+	const auto high = _mm256_cmpeq_epi32(
+		_mm256_loadu_si256(reinterpret_cast<const __m256i*>(skips + 8)), zero);
+
+	return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(low))) |
+		(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(high))) << 8);
+#else
+	uint32_t mask = 0;
+	for(int32_t i = 0; i < colony_scan_width; ++i)
 	{
-		int32_t prev, next;
-	};
+		mask |= static_cast<uint32_t>(skips[i] == 0) << i;
+	}
+	return mask;
+#endif
+}
 
-	union ElemType
+// colony_live_mask() for the first count (< colony_scan_width) entries
+_MST_NODISCARD inline uint32_t colony_live_mask(const int32_t* skips, int32_t count) noexcept
+{
+	uint32_t mask = 0;
+	for(int32_t i = 0; i < count; ++i)
 	{
-		typename std::aligned_storage<sizeof(T), alignof(T)>::type elem;
-		FreeListNode node;
-	};
+		mask |= static_cast<uint32_t>(skips[i] == 0) << i;
+	}
+	return mask;
+}
 
-	static_assert(std::is_trivially_destructible<FreeListNode>::value,
-		"FreeListNode must be trivially destructible");
+// index of the lowest set bit, mask must not be 0
+_MST_NODISCARD inline int32_t colony_lowest_bit(uint32_t mask) noexcept
+{
+#if _MST_USING_VC_COMPILER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<int32_t>(index);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+// index of the highest set bit plus one, mask must not be 0
+_MST_NODISCARD inline int32_t colony_bit_width(uint32_t mask) noexcept
+{
+#if _MST_USING_VC_COMPILER
+	unsigned long index;
+	_BitScanReverse(&index, mask);
+	return static_cast<int32_t>(index) + 1;
+#else
+	return 32 - __builtin_clz(mask);
+#endif
+}
+
+struct colony_free_list_node
+{
+	int32_t prev, next;
+};
 
-	friend class colony_iterator<T>;
-	friend class colony_const_iterator<T>;
-	friend class colony_reverse_iterator<T>;
-	friend class colony_const_reverse_iterator<T>;
+// The page header shared by the colonies. skips is the skip field of the page: 0 for a live
+// element, or the size of the free block at the first and last slot of a run of free slots.
+// Free blocks never cross a page boundary. emptyRun is non-zero for the pages of a run of empty
+// pages and holds the length of the run at its first and last page, see colony_empty_pages. The
+// run fields are only used by the containers that keep runs of empty pages.
+struct colony_page_header
+{
+	int32_t* skips;
+	int32_t size;
+	int32_t emptyRun;
+	// links in the list of empty runs, only valid at the first page of a run
+	int32_t runPrev, runNext;
+};
 
+// The free list of the colonies: a doubly linked list of the free blocks, through a node in the
+// first slot of every block. Layout gives access to the pages of a colony:
+//   colony_page_header& page(int32_t pageIndex) const
+//   colony_free_list_node* node(int32_t index) const, the storage for the node of a free slot
+template<int32_t ElementsPerPage, typename Layout>
+class colony_free_list
+{
 public:
-	typedef colony_iterator<T> iterator;
-	typedef colony_const_iterator<T> const_iterator;
+	inline colony_free_list(const Layout& layout, int32_t& head) noexcept
+		: m_layout(layout)
+		, m_head(head)
+	{ }
 
-	typedef colony_reverse_iterator<T> reverse_iterator;
-	typedef colony_const_reverse_iterator<T> const_reverse_iterator;
+	// Marks the whole page as a single free block, without linking it
+	inline void clear_page(int32_t pageIndex) noexcept
+	{
+		auto& page = m_layout.page(pageIndex);
 
-	inline colony() noexcept
-		: m_pages(nullptr)
-		, m_elementCount(0)
-		, m_capacity(0)
-		, m_freeListHead(-1)
-		, m_skips(&m_capacity)
+		page.size = 0;
+
+		if(ElementsPerPage > 2)
+		{
+			memset(page.skips + 1, 1, size_t(ElementsPerPage - 2) * sizeof(int32_t));
+		}
+
+		page.skips[0] = ElementsPerPage;
+		page.skips[ElementsPerPage - 1] = ElementsPerPage;
+	}
+
+	// clear_page(), and links the page after freeListPrev, see link_free_run()
+	inline int32_t reset_page(int32_t pageIndex, int32_t freeListPrev = -1) noexcept
+	{
+		clear_page(pageIndex);
+
+		return link_free_run(pageIndex << _MST_GET_SHIFT(ElementsPerPage), ElementsPerPage,
+			freeListPrev);
+	}
+
+	// writes the skip field of a free block within a single page and links it into the free
+	// list after freeListPrev, or at the front when freeListPrev is -1. Returns blockStart.
+	inline int32_t link_free_block(
+		int32_t blockStart, int32_t blockSize, int32_t freeListPrev) noexcept
+	{
+		if(blockSize > 2)
+		{
+			memset(&skip(blockStart + 1), 1, size_t(blockSize - 2) * sizeof(int32_t));
+		}
+
+		return link_free_run(blockStart, blockSize, freeListPrev);
+	}
+
+	// link_free_block() for a run of slots that are all non-zero in the skip field already
+	inline int32_t link_free_run(
+		int32_t blockStart, int32_t blockSize, int32_t freeListPrev) noexcept
+	{
+		skip(blockStart) = blockSize;
+		skip(blockStart + blockSize - 1) = blockSize;
+
+		const auto freeListNext = freeListPrev == -1 ? m_head : node(freeListPrev).next;
+
+		new(m_layout.node(blockStart)) colony_free_list_node{ freeListPrev, freeListNext };
+
+		if(freeListNext != -1)
+		{
+			node(freeListNext).prev = blockStart;
+		}
+
+		if(freeListPrev == -1)
+		{
+			m_head = blockStart;
+		}
+		else
+		{
+			node(freeListPrev).next = blockStart;
+		}
+
+		return blockStart;
+	}
+
+	inline void unlink_free_block(int32_t blockStart) noexcept
+	{
+		const auto blockNode = node(blockStart);
+
+		if(blockNode.prev != -1)
+		{
+			node(blockNode.prev).next = blockNode.next;
+		}
+		else
+		{
+			m_head = blockNode.next;
+		}
+
+		if(blockNode.next != -1)
+		{
+			node(blockNode.next).prev = blockNode.prev;
+		}
+	}
+
+	// Takes up to maxCount slots from the front of the first free block, the rest of the block
+	// stays at the head of the free list. The slots are taken out of the block, but not marked
+	// as live yet, see set_live(). Returns the number of slots, which start at the old head.
+	_MST_NODISCARD inline int32_t take_front(int32_t maxCount) noexcept
+	{
+		MST_ASSERT(m_head != -1, "no free list elements");
+
+		const auto first = m_head;
+		const auto freeBlockSize = skip(first);
+		const auto freeNext = node(first).next;
+		const auto taken = std::min(freeBlockSize, maxCount);
+
+		if(taken == freeBlockSize)
+		{
+			m_head = freeNext;
+			if(freeNext != -1)
+			{
+				node(freeNext).prev = -1;
+			}
+		}
+		else
+		{
+			const auto newHead = first + taken;
+			const auto newBlockSize = freeBlockSize - taken;
+
+			skip(newHead) = newBlockSize;
+			skip(first + freeBlockSize - 1) = newBlockSize;
+
+			new(m_layout.node(newHead)) colony_free_list_node{ -1, freeNext };
+
+			if(freeNext != -1)
+			{
+				node(freeNext).prev = newHead;
+			}
+
+			m_head = newHead;
+		}
+
+		return taken;
+	}
+
+	// marks a slot taken by take_front() as live
+	inline void set_live(int32_t index) noexcept
+	{
+		skip(index) = 0;
+		++m_layout.page(index >> _MST_GET_SHIFT(ElementsPerPage)).size;
+	}
+
+	// takes the first free slot and marks it as live
+	_MST_NODISCARD inline int32_t pop() noexcept
+	{
+		const auto index = m_head;
+
+		// shrinking the block from the front keeps it at the head, so a page is filled in order
+		(void)take_front(1);
+		set_live(index);
+
+		return index;
+	}
+
+	// Adds a live slot to the free list, merging it with the free blocks next to it within its
+	// page. Returns the index after the free block that holds the slot.
+	_MST_NODISCARD inline int32_t push(int32_t index) noexcept
+	{
+		--m_layout.page(index >> _MST_GET_SHIFT(ElementsPerPage)).size;
+
+		const auto elemIndex = index & (ElementsPerPage - 1);
+
+		const auto leftIndex = index - 1;
+		const auto rightIndex = index + 1;
+
+		const uint8_t leftIsDestroyed = elemIndex != 0 && skip(leftIndex) != 0;
+		const uint8_t rightIsDestroyed =
+			elemIndex != ElementsPerPage - 1 && skip(rightIndex) != 0;
+
+		switch(leftIsDestroyed | (rightIsDestroyed << 1))
+		{
+		case 0: // none
+			return link_free_run(index, 1, -1) + 1;
+		case 1: // end
+		{
+			const auto skipBlockSize = skip(leftIndex);
+			skip(index - skipBlockSize) = skipBlockSize + 1;
+			skip(index) = skipBlockSize + 1;
+			return index + 1;
+		}
+		case 2: // begin
+		{
+			const auto skipBlockSize = skip(rightIndex);
+			skip(index + skipBlockSize) = skipBlockSize + 1;
+			skip(index) = skipBlockSize + 1;
+
+			// the block starts one slot earlier now, move its free list node along
+			const auto blockNode = node(rightIndex);
+			new(m_layout.node(index)) colony_free_list_node{ blockNode };
+
+			if(blockNode.prev != -1)
+			{
+				node(blockNode.prev).next = index;
+			}
+			else
+			{
+				m_head = index;
+			}
+
+			if(blockNode.next != -1)
+			{
+				node(blockNode.next).prev = index;
+			}
+
+			return index + skipBlockSize + 1;
+		}
+		// case 3: // both
+		default: {
+			const auto skipBlockSizeLeft = skip(leftIndex);
+			const auto skipBlockSizeRight = skip(rightIndex);
+
+			skip(index) = 1;
+			skip(index - skipBlockSizeLeft) = skipBlockSizeLeft + skipBlockSizeRight + 1;
+			skip(index + skipBlockSizeRight) = skipBlockSizeLeft + skipBlockSizeRight + 1;
+
+			// the right block is absorbed by the left one
+			unlink_free_block(rightIndex);
+
+			return index + skipBlockSizeRight + 1;
+		}
+		}
+	}
+
+private:
+	_MST_NODISCARD inline int32_t& skip(int32_t index) const noexcept
+	{
+		return m_layout.page(index >> _MST_GET_SHIFT(ElementsPerPage))
+			.skips[index & (ElementsPerPage - 1)];
+	}
+
+	_MST_NODISCARD inline colony_free_list_node& node(int32_t index) const noexcept
+	{
+		return *m_layout.node(index);
+	}
+
+	Layout m_layout;
+	int32_t& m_head;
+};
+
+// The runs of empty pages of colony. An empty page is kept out of the free list, every run of
+// empty pages is an entry in a list of runs instead, with its length at its first and last page:
+// a skip field one level up. Iteration crosses a run in a single jump, and pages are only taken
+// from the front of a run, so taking and returning a page are O(1) too.
+// Layout is the layout of colony_free_list, with
+//   int32_t page_count() const
+template<int32_t ElementsPerPage, typename Layout>
+class colony_empty_pages
+{
+public:
+	inline colony_empty_pages(const Layout& layout, int32_t& head) noexcept
+		: m_layout(layout)
+		, m_head(head)
 	{ }
 
-	inline ~colony()
+	// Adds an empty page, merging it with the runs next to it. Returns the page after the run.
+	inline int32_t add(int32_t pageIndex) noexcept
 	{
-		destroy_all();
+		MST_ASSERT(m_layout.page(pageIndex).size == 0, "page is not empty");
+
+		const auto leftRun = pageIndex != 0 ? run(pageIndex - 1) : 0;
+		const auto rightRun = pageIndex + 1 != m_layout.page_count() ? run(pageIndex + 1) : 0;
+
+		const auto first = pageIndex - leftRun;
+		const auto last = pageIndex + rightRun;
+
+		run(pageIndex) = 1;
+		run(first) = last - first + 1;
+		run(last) = last - first + 1;
+
+		if(leftRun == 0 && rightRun == 0)
+		{
+			link_run(pageIndex, -1);
+		}
+		else if(leftRun == 0)
+		{
+			// the run on the right starts one page earlier now
+			move_run(pageIndex + 1, pageIndex);
+		}
+		else if(rightRun != 0)
+		{
+			// the run on the right is absorbed by the one on the left
+			unlink_run(pageIndex + 1);
+		}
+
+		return last + 1;
 	}
 
-	void clear() noexcept
+	// takes the first page of the first run, or returns -1 when there are no empty pages
+	_MST_NODISCARD inline int32_t take() noexcept
 	{
-		if(m_pages)
-		{ // m_skips,m_capacity+1
-			auto index = m_skips[0];
+		const auto pageIndex = m_head;
+		if(pageIndex == -1)
+		{
+			return -1;
+		}
 
-			while(index != m_capacity)
+		const auto length = run(pageIndex);
+
+		run(pageIndex) = 0;
+
+		if(length == 1)
+		{
+			unlink_run(pageIndex);
+		}
+		else
+		{
+			run(pageIndex + 1) = length - 1;
+			run(pageIndex + length - 1) = length - 1;
+
+			move_run(pageIndex, pageIndex + 1);
+		}
+
+		return pageIndex;
+	}
+
+	// Removes the run that ends at the last page, returns its first page
+	inline int32_t remove_last_run() noexcept
+	{
+		const auto last = m_layout.page_count() - 1;
+		const auto first = last - run(last) + 1;
+
+		unlink_run(first);
+
+		for(auto pageIndex = first; pageIndex <= last; ++pageIndex)
+		{
+			run(pageIndex) = 0;
+		}
+
+		return first;
+	}
+
+	// Rebuilds the runs from the page sizes, linked in order of their first page
+	inline void rebuild() noexcept
+	{
+		m_head = -1;
+
+		const auto pageCount = m_layout.page_count();
+
+		int32_t lastRun = -1;
+		int32_t pageIndex = 0;
+		while(pageIndex != pageCount)
+		{
+			if(m_layout.page(pageIndex).size != 0)
+			{
+				run(pageIndex) = 0;
+				++pageIndex;
+				continue;
+			}
+
+			const auto first = pageIndex;
+			while(pageIndex != pageCount && m_layout.page(pageIndex).size == 0)
+			{
+				run(pageIndex) = 1;
+				++pageIndex;
+			}
+
+			run(first) = pageIndex - first;
+			run(pageIndex - 1) = pageIndex - first;
+
+			link_run(first, lastRun);
+			lastRun = first;
+		}
+	}
+
+	// returns the first live index at or after index, index must be live, start a free block
+	// or start the first page of a run
+	_MST_NODISCARD static inline int32_t skip_forward(
+		const Layout& layout, int32_t index, int32_t end) noexcept
+	{
+		while(index != end)
+		{
+			const auto& page = layout.page(index >> _MST_GET_SHIFT(ElementsPerPage));
+			const auto skip = page.skips[index & (ElementsPerPage - 1)];
+			if(skip == 0)
 			{
-				get_impl(index).~T();
-				new(&get_free_impl(index)) FreeListNode{};
+				return index;
+			}
 
-				m_skips[index] = 1;
+			// a whole free page is either the first page of a run, or about to be filled
+			index += skip != ElementsPerPage || page.emptyRun == 0
+				? skip
+				: page.emptyRun << _MST_GET_SHIFT(ElementsPerPage);
+		}
+
+		return index;
+	}
 
-				index = index + m_skips[index + 1] + 1;
+	// returns the last live index at or before index, index must be live, end a free block or
+	// end the last page of a run
+	_MST_NODISCARD static inline int32_t skip_backward(
+		const Layout& layout, int32_t index) noexcept
+	{
+		while(index >= 0)
+		{
+			const auto& page = layout.page(index >> _MST_GET_SHIFT(ElementsPerPage));
+			const auto skip = page.skips[index & (ElementsPerPage - 1)];
+			if(skip == 0)
+			{
+				return index;
 			}
 
-			set_free_prev(0, -1);
-			set_free_next(0, -1);
+			index -= skip != ElementsPerPage || page.emptyRun == 0
+				? skip
+				: page.emptyRun << _MST_GET_SHIFT(ElementsPerPage);
+		}
+
+		return index;
+	}
 
-			m_elementCount = 0;
-			m_skips[0] = m_capacity;
-			m_skips[m_capacity - 1] = m_capacity;
-			m_freeListHead = 0;
+	// the first live index in or after the page, pageIndex may be anywhere inside a run
+	_MST_NODISCARD static inline int32_t page_begin(
+		const Layout& layout, int32_t pageIndex, int32_t end) noexcept
+	{
+		// only the first and last page of a run know its length, walk to the end of it
+		const auto pageCount = layout.page_count();
+		while(pageIndex != pageCount && layout.page(pageIndex).emptyRun != 0)
+		{
+			++pageIndex;
 		}
+
+		return skip_forward(layout, pageIndex << _MST_GET_SHIFT(ElementsPerPage), end);
 	}
 
-	_MST_NODISCARD inline bool empty() const noexcept
+private:
+	_MST_NODISCARD inline int32_t& run(int32_t pageIndex) const noexcept
 	{
-		return m_elementCount == 0;
+		return m_layout.page(pageIndex).emptyRun;
 	}
 
-	template<typename Fn>
-	inline void foreach(Fn func) _MST_NOEXCEPT_OP_INVOCABLE(Fn, const T&)
+	inline void link_run(int32_t first, int32_t prev) noexcept
 	{
-		auto index = m_skips[0];
+		const auto next = prev == -1 ? m_head : m_layout.page(prev).runNext;
+
+		m_layout.page(first).runPrev = prev;
+		m_layout.page(first).runNext = next;
 
-		while(index != m_capacity)
+		if(next != -1)
 		{
-#if _MST_HAS_INVOKE
-			std::invoke(func, get_impl(index));
-#else
-			func(get_impl(index));
-#endif
+			m_layout.page(next).runPrev = first;
+		}
 
-			index = index + m_skips[index + 1] + 1;
+		if(prev == -1)
+		{
+			m_head = first;
+		}
+		else
+		{
+			m_layout.page(prev).runNext = first;
 		}
 	}
 
-	template<typename Fn>
-	inline void foreach(Fn func) const _MST_NOEXCEPT_OP_INVOCABLE(Fn, const T&)
+	inline void unlink_run(int32_t first) noexcept
 	{
-		auto index = m_skips[0];
+		const auto prev = m_layout.page(first).runPrev;
+		const auto next = m_layout.page(first).runNext;
 
-		while(index != m_capacity)
+		if(prev != -1)
 		{
-#if _MST_HAS_INVOKE
-			std::invoke(func, get_impl(index));
-#else
-			func(get_impl(index));
-#endif
+			m_layout.page(prev).runNext = next;
+		}
+		else
+		{
+			m_head = next;
+		}
+
+		if(next != -1)
+		{
+			m_layout.page(next).runPrev = prev;
+		}
+	}
+
+	inline void move_run(int32_t oldFirst, int32_t newFirst) noexcept
+	{
+		const auto prev = m_layout.page(oldFirst).runPrev;
+		const auto next = m_layout.page(oldFirst).runNext;
+
+		m_layout.page(newFirst).runPrev = prev;
+		m_layout.page(newFirst).runNext = next;
+
+		if(prev != -1)
+		{
+			m_layout.page(prev).runNext = newFirst;
+		}
+		else
+		{
+			m_head = newFirst;
+		}
+
+		if(next != -1)
+		{
+			m_layout.page(next).runPrev = newFirst;
+		}
+	}
+
+	Layout m_layout;
+	int32_t& m_head;
+};
+
+} // namespace _Details
+
+// The colony stores its elements in pages of ElementsPerPage elements. Every page owns its own
+// skip field: 0 for a live element, or the size of the free block at the first and last slot
+// of a run of free elements. Free blocks never cross a page boundary, so adding a page never
+// touches the existing pages and the page directory only has to copy page pointers when it grows.
+template<typename T, int32_t ElementsPerPage, typename Allocator>
+class colony
+{
+	static_assert(ElementsPerPage > 0 && (ElementsPerPage & (ElementsPerPage - 1)) == 0,
+		"ElementsPerPage must be a power of two");
+
+	typedef _Details::colony_free_list_node FreeListNode;
+
+	union ElemType
+	{
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type elem;
+		FreeListNode node;
+	};
+
+	// skips points to a shared read-only skip field describing a single free block once the
+	// page has been released by trim()
+	struct PageType : _Details::colony_page_header
+	{
+		// nullptr when the page has been released
+		ElemType* elems;
+		// bumped every time a slot is freed, only read to validate a handle. Kept for released
+		// pages, so handles into them stay stale once the page is brought back.
+		uint32_t* generations;
+	};
+
+	// gives the free list and the runs of empty pages access to the pages
+	struct PageLayout
+	{
+		const colony* self;
+
+		_MST_NODISCARD inline _Details::colony_page_header& page(int32_t pageIndex) const noexcept
+		{
+			return self->m_pages[pageIndex];
+		}
+
+		_MST_NODISCARD inline FreeListNode* node(int32_t index) const noexcept
+		{
+			return &self->m_pages[index >> _MST_GET_SHIFT(ElementsPerPage)]
+						.elems[index & (ElementsPerPage - 1)]
+						.node;
+		}
+
+		_MST_NODISCARD inline int32_t page_count() const noexcept
+		{
+			return self->m_pageCount;
+		}
+	};
+
+	typedef _Details::colony_free_list<ElementsPerPage, PageLayout> FreeList;
+	typedef _Details::colony_empty_pages<ElementsPerPage, PageLayout> EmptyPages;
+
+	static_assert(std::is_trivially_destructible<FreeListNode>::value,
+		"FreeListNode must be trivially destructible");
+
+	// The elements are allocated through a rebound copy of the allocator. The skip fields and
+	// generations are small side arrays, which would waste most of an OS page or an alignment
+	// each, so they use the default allocator.
+	typedef typename std::allocator_traits<Allocator>::template rebind_alloc<ElemType>
+		ElemAllocator;
+	typedef std::allocator<int32_t> SkipAllocator;
+	typedef std::allocator<uint32_t> GenerationAllocator;
+	typedef std::allocator_traits<ElemAllocator> ElemTraits;
+	typedef std::allocator_traits<SkipAllocator> SkipTraits;
+	typedef std::allocator_traits<GenerationAllocator> GenerationTraits;
+
+	friend class colony_iterator<T, ElementsPerPage, Allocator>;
+	friend class colony_const_iterator<T, ElementsPerPage, Allocator>;
+	friend class colony_reverse_iterator<T, ElementsPerPage, Allocator>;
+	friend class colony_const_reverse_iterator<T, ElementsPerPage, Allocator>;
+
+public:
+	typedef colony_iterator<T, ElementsPerPage, Allocator> iterator;
+	typedef colony_const_iterator<T, ElementsPerPage, Allocator> const_iterator;
+
+	typedef colony_reverse_iterator<T, ElementsPerPage, Allocator> reverse_iterator;
+	typedef colony_const_reverse_iterator<T, ElementsPerPage, Allocator> const_reverse_iterator;
+
+	typedef Allocator allocator_type;
+
+	// A reference to an element that detects when the element has been erased, even when its
+	// slot has been reused since: every slot has a generation that is bumped when it's freed.
+	struct handle
+	{
+		int32_t index = -1;
+		uint32_t generation = 0;
+
+		_MST_NODISCARD inline bool operator==(const handle& other) const noexcept
+		{
+			return index == other.index && generation == other.generation;
+		}
+
+		_MST_NODISCARD inline bool operator!=(const handle& other) const noexcept
+		{
+			return !(*this == other);
+		}
+	};
+
+	inline colony() noexcept(std::is_nothrow_default_constructible<Allocator>::value)
+		: colony(Allocator())
+	{ }
+
+	inline explicit colony(const Allocator& allocator) noexcept
+		: m_pages(nullptr)
+		, m_pageCount(0)
+		, m_pageCapacity(0)
+		, m_elementCount(0)
+		, m_capacity(0)
+		, m_freeListHead(-1)
+		, m_emptyRunHead(-1)
+		, m_releasedPageCount(0)
+		, m_newPageGeneration(0)
+		, m_allocator(allocator)
+	{ }
+
+	inline ~colony()
+	{
+		destroy_all();
+	}
+
+	void clear() noexcept
+	{
+		for(int32_t pageIndex = 0; pageIndex < m_pageCount; ++pageIndex)
+		{
+			const auto& page = m_pages[pageIndex];
+			if(page.size != 0)
+			{
+				foreach_live(page, [&](int32_t elemIndex) { ++page.generations[elemIndex]; });
+			}
+		}
+
+		destroy_elements();
+
+		m_elementCount = 0;
+		m_freeListHead = -1;
+
+		for(int32_t pageIndex = 0; pageIndex < m_pageCount; ++pageIndex)
+		{
+			if(m_pages[pageIndex].elems)
+			{
+				free_list().clear_page(pageIndex);
+			}
+		}
+
+		// a single run of empty pages, so they are filled front to back again
+		empty_pages().rebuild();
+	}
+
+	_MST_NODISCARD inline bool empty() const noexcept
+	{
+		return m_elementCount == 0;
+	}
+
+	_MST_NODISCARD inline allocator_type get_allocator() const noexcept
+	{
+		return m_allocator;
+	}
+
+	template<typename Fn>
+	inline void foreach(Fn func) _MST_NOEXCEPT_OP_INVOCABLE(Fn, const T&)
+	{
+		for(int32_t pageIndex = 0; pageIndex < m_pageCount; ++pageIndex)
+		{
+			// a run of empty pages is skipped at once
+			const auto emptyRun = m_pages[pageIndex].emptyRun;
+			if(emptyRun != 0)
+			{
+				pageIndex += emptyRun - 1;
+				continue;
+			}
+
+			foreach_page(pageIndex, func);
+		}
+	}
+
+	template<typename Fn>
+	inline void foreach(Fn func) const _MST_NOEXCEPT_OP_INVOCABLE(Fn, const T&)
+	{
+		for(int32_t pageIndex = 0; pageIndex < m_pageCount; ++pageIndex)
+		{
+			// a run of empty pages is skipped at once
+			const auto emptyRun = m_pages[pageIndex].emptyRun;
+			if(emptyRun != 0)
+			{
+				pageIndex += emptyRun - 1;
+				continue;
+			}
+
+			foreach_page(pageIndex, func);
+		}
+	}
+
+	// Calls func for every element, spread over the executor at page granularity: a page is
+	// only ever visited by a single task. The colony must not be modified during the call.
+	template<typename Executor, typename Fn>
+	inline void parallel_foreach(Executor&& executor, Fn func)
+	{
+		for_each_page_range(executor, [&](int32_t firstPage, int32_t endPage) {
+			for(int32_t pageIndex = firstPage; pageIndex < endPage; ++pageIndex)
+			{
+				foreach_page(pageIndex, func);
+			}
+		});
+	}
+
+	template<typename Executor, typename Fn>
+	inline void parallel_foreach(Executor&& executor, Fn func) const
+	{
+		for_each_page_range(executor, [&](int32_t firstPage, int32_t endPage) {
+			for(int32_t pageIndex = firstPage; pageIndex < endPage; ++pageIndex)
+			{
+				foreach_page(pageIndex, func);
+			}
+		});
+	}
+
+	// Calls func(begin, end) for non-empty iterator ranges that each cover a run of whole pages
+	template<typename Executor, typename Fn>
+	inline void parallel_foreach_chunked(Executor&& executor, Fn func)
+	{
+		for_each_page_range(executor, [&](int32_t firstPage, int32_t endPage) {
+			const auto first = page_begin(firstPage);
+			const auto last = page_begin(endPage);
+
+			if(first != last)
+			{
+#if _MST_HAS_INVOKE
+				std::invoke(func, iterator(*this, first), iterator(*this, last));
+#else
+				func(iterator(*this, first), iterator(*this, last));
+#endif
+			}
+		});
+	}
+
+	template<typename Executor, typename Fn>
+	inline void parallel_foreach_chunked(Executor&& executor, Fn func) const
+	{
+		for_each_page_range(executor, [&](int32_t firstPage, int32_t endPage) {
+			const auto first = page_begin(firstPage);
+			const auto last = page_begin(endPage);
+
+			if(first != last)
+			{
+#if _MST_HAS_INVOKE
+				std::invoke(func, const_iterator(*this, first), const_iterator(*this, last));
+#else
+				func(const_iterator(*this, first), const_iterator(*this, last));
+#endif
+			}
+		});
+	}
+
+	template<typename... Args>
+	inline iterator emplace(Args&&... args)
+	{
+		if(m_freeListHead == -1) // _MST_UNLIKELY
+		{
+			claim_page();
+		}
+
+		const int32_t newIndex = free_list().pop();
+		get_free_impl(newIndex).~FreeListNode();
+		++m_elementCount;
+
+		new(&get_impl(newIndex)) T(std::forward<Args>(args)...);
+
+		return iterator(*this, newIndex);
+	}
+
+	// Constructs count copies of T(args...). Free blocks are claimed whole and filled front to
+	// back, missing pages are added up front. Returns the indices of the new elements. When a
+	// constructor throws, the elements constructed before it are kept.
+	template<typename... Args>
+	inline std::vector<int32_t> emplace_n(int32_t count, const Args&... args)
+	{
+		return bulk_construct(count, [&](void* elem) { new(elem) T(args...); });
+	}
+
+	// Inserts copies of [first, last), see emplace_n(). Returns the indices of the new elements
+	// in the order of the input range.
+	template<typename InputIt>
+	inline std::vector<int32_t> insert(InputIt first, InputIt last)
+	{
+		typedef typename std::iterator_traits<InputIt>::iterator_category category;
+
+		if constexpr(std::is_base_of<std::forward_iterator_tag, category>::value)
+		{
+			const auto count = static_cast<int32_t>(std::distance(first, last));
+
+			return bulk_construct(count, [&](void* elem) {
+				new(elem) T(*first);
+				++first;
+			});
+		}
+		else
+		{
+			std::vector<int32_t> indices;
+			for(; first != last; ++first)
+			{
+				indices.push_back(emplace(*first).idx());
+			}
+			return indices;
+		}
+	}
+
+	inline iterator erase(const_iterator it) noexcept
+	{
+		MST_ASSERT(it.m_container == this, "iterator is not attached to this container");
+		MST_ASSERT(it.m_index >= 0, "iterator out of range");
+		MST_ASSERT(it.m_index < m_capacity, "iterator out of range");
+		MST_ASSERT(get_skip(it.m_index) == 0, "iterator invalid");
+
+		get_impl(it.m_index).~T();
+		new(&get_free_impl(it.m_index)) FreeListNode{};
+		++get_generation(it.m_index);
+
+		const auto nextIndex = free_slot(it.m_index);
+
+		return iterator(*this, skip_forward(nextIndex));
+	}
+
+	inline int32_t erase(int32_t index) noexcept
+	{
+		MST_ASSERT(index >= 0, "iterator out of range");
+		MST_ASSERT(index < m_capacity, "iterator out of range");
+		MST_ASSERT(get_skip(index) == 0, "iterator invalid");
+
+		get_impl(index).~T();
+		new(&get_free_impl(index)) FreeListNode{};
+		++get_generation(index);
+
+		const auto nextIndex = free_slot(index);
+
+		return skip_forward(nextIndex);
+	}
+
+	// Erases every element for which pred returns true. Every page is handled in a single pass:
+	// the free blocks of the page are unlinked and the runs of free slots, old and new, are linked
+	// back as one block each, or the page joins the runs of empty pages. pred must not throw or
+	// access the colony. Returns the number of erased elements.
+	template<typename Pred>
+	inline size_t erase_if(Pred pred)
+	{
+		size_t erasedCount = 0;
+
+		for(int32_t pageIndex = 0; pageIndex < m_pageCount; ++pageIndex)
+		{
+			auto& page = m_pages[pageIndex];
+			if(page.emptyRun != 0)
+			{
+				pageIndex += page.emptyRun - 1;
+				continue;
+			}
+
+			const auto pageStart = pageIndex << _MST_GET_SHIFT(ElementsPerPage);
+
+			int32_t blockStart = -1;
+			int32_t elemIndex = 0;
+			while(elemIndex != ElementsPerPage)
+			{
+				const auto skip = page.skips[elemIndex];
+				if(skip != 0)
+				{
+					// an existing free block, relinked as part of the run it ends up in
+					free_list().unlink_free_block(pageStart + elemIndex);
+
+					blockStart = blockStart == -1 ? elemIndex : blockStart;
+					elemIndex += skip;
+					continue;
+				}
+
+				auto& elem = *reinterpret_cast<T*>(&page.elems[elemIndex].elem);
+#if _MST_HAS_INVOKE
+				if(std::invoke(pred, elem))
+#else
+				if(pred(elem))
+#endif
+				{
+					elem.~T();
+					++page.generations[elemIndex];
+
+					// any non-zero value marks the slot as free inside a block
+					page.skips[elemIndex] = 1;
+					--page.size;
+					++erasedCount;
+
+					blockStart = blockStart == -1 ? elemIndex : blockStart;
+				}
+				else if(blockStart != -1)
+				{
+					free_list().link_free_run(pageStart + blockStart, elemIndex - blockStart, -1);
+					blockStart = -1;
+				}
+
+				++elemIndex;
+			}
+
+			if(page.size == 0)
+			{
+				// every slot is non-zero already, only the ends of the block are missing
+				page.skips[0] = ElementsPerPage;
+				page.skips[ElementsPerPage - 1] = ElementsPerPage;
+
+				pageIndex = empty_pages().add(pageIndex) - 1;
+			}
+			else if(blockStart != -1)
+			{
+				free_list().link_free_run(pageStart + blockStart, ElementsPerPage - blockStart, -1);
+			}
+		}
+
+		m_elementCount -= static_cast<int32_t>(erasedCount);
+
+		return erasedCount;
+	}
+
+	inline T& operator[](int32_t index) noexcept
+	{
+		MST_ASSERT(index >= 0, "iterator out of range");
+		MST_ASSERT(index < m_capacity, "iterator out of range");
+		MST_ASSERT(get_skip(index) == 0, "iterator invalid");
+
+		return get_impl(index);
+	}
+
+	inline const T& operator[](int32_t index) const noexcept
+	{
+		MST_ASSERT(index >= 0, "iterator out of range");
+		MST_ASSERT(index < m_capacity, "iterator out of range");
+		MST_ASSERT(get_skip(index) == 0, "iterator invalid");
+
+		return get_impl(index);
+	}
+
+	_MST_NODISCARD inline handle get_handle(int32_t index) const noexcept
+	{
+		MST_ASSERT(index >= 0, "iterator out of range");
+		MST_ASSERT(index < m_capacity, "iterator out of range");
+		MST_ASSERT(get_skip(index) == 0, "iterator invalid");
+
+		const auto& page = m_pages[index >> _MST_GET_SHIFT(ElementsPerPage)];
+
+		return handle{ index, page.generations[index & (ElementsPerPage - 1)] };
+	}
+
+	_MST_NODISCARD inline handle get_handle(const_iterator it) const noexcept
+	{
+		MST_ASSERT(it.m_container == this, "iterator is not attached to this container");
+
+		return get_handle(it.m_index);
+	}
+
+	// Returns the element the handle refers to, or nullptr when it has been erased
+	_MST_NODISCARD inline T* get(handle h) noexcept
+	{
+		return const_cast<T*>(static_cast<const colony*>(this)->get(h));
+	}
+
+	_MST_NODISCARD inline const T* get(handle h) const noexcept
+	{
+		if(static_cast<uint32_t>(h.index) >= static_cast<uint32_t>(m_capacity))
+		{
+			return nullptr;
+		}
+
+		const auto& page = m_pages[h.index >> _MST_GET_SHIFT(ElementsPerPage)];
+		const auto elemIndex = h.index & (ElementsPerPage - 1);
+
+		if(!page.elems || page.skips[elemIndex] != 0 || page.generations[elemIndex] != h.generation)
+		{
+			return nullptr;
+		}
+
+		return reinterpret_cast<const T*>(&page.elems[elemIndex].elem);
+	}
+
+	_MST_NODISCARD inline size_t capacity() const noexcept
+	{
+		return static_cast<size_t>(m_capacity - m_releasedPageCount * ElementsPerPage);
+	}
+
+	_MST_NODISCARD inline size_t size() const noexcept
+	{
+		return static_cast<size_t>(m_elementCount);
+	}
+
+	// number of allocated pages
+	_MST_NODISCARD inline size_t page_count() const noexcept
+	{
+		return static_cast<size_t>(m_pageCount - m_releasedPageCount);
+	}
+
+	// number of allocated pages without any elements, these are released by trim(). O(pages)
+	_MST_NODISCARD inline size_t empty_page_count() const noexcept
+	{
+		size_t emptyPages = 0;
+		for(int32_t pageIndex = 0; pageIndex < m_pageCount; ++pageIndex)
+		{
+			const auto& page = m_pages[pageIndex];
+			if(page.elems && page.size == 0)
+			{
+				++emptyPages;
+			}
+		}
+		return emptyPages;
+	}
+
+	_MST_NODISCARD inline size_t free_slot_count() const noexcept
+	{
+		return capacity() - size();
+	}
+
+	// Makes sure there is room for at least newCapacity elements
+	inline void reserve(size_t newCapacity)
+	{
+		if(newCapacity <= capacity())
+		{
+			return;
+		}
+
+		auto missingPages = static_cast<int32_t>(
+			(newCapacity - capacity() + ElementsPerPage - 1) >> _MST_GET_SHIFT(ElementsPerPage));
+
+		// bring back the released pages first, they stay in their runs of empty pages
+		for(int32_t pageIndex = 0; missingPages != 0 && m_releasedPageCount != 0; ++pageIndex)
+		{
+			if(!m_pages[pageIndex].elems)
+			{
+				restore_page(pageIndex);
+				--missingPages;
+			}
+		}
+
+		reserve_directory(m_pageCount + missingPages);
+
+		for(int32_t i = 0; i < missingPages; ++i)
+		{
+			empty_pages().add(append_page());
+		}
+	}
+
+	// Releases the memory of all pages without elements. The indices of the remaining elements
+	// stay valid, released pages in between are skipped by iteration without being touched.
+	inline void trim() noexcept
+	{
+		for(int32_t pageIndex = 0; pageIndex < m_pageCount; ++pageIndex)
+		{
+			auto& page = m_pages[pageIndex];
+			if(!page.elems || page.size != 0)
+			{
+				continue;
+			}
+
+			// an empty page is in a run of empty pages already, only its memory goes
+			free_page(page);
+
+			page.elems = nullptr;
+			page.skips =
+				const_cast<int32_t*>(_Details::colony_released_page<ElementsPerPage>::skips());
+
+			++m_releasedPageCount;
+		}
+
+		// the run of released pages at the end is dropped from the index range entirely
+		if(m_pageCount != 0 && m_pages[m_pageCount - 1].emptyRun != 0)
+		{
+			empty_pages().remove_last_run();
+		}
+
+		while(m_pageCount != 0 && !m_pages[m_pageCount - 1].elems)
+		{
+			// a page added at this index later on starts past every generation used here
+			auto& page = m_pages[m_pageCount - 1];
+
+			const auto maxGeneration =
+				*std::max_element(page.generations, page.generations + ElementsPerPage);
+			m_newPageGeneration = std::max(m_newPageGeneration, maxGeneration + 1);
+
+			free_generations(page);
+
+			--m_pageCount;
+			--m_releasedPageCount;
+			m_capacity -= ElementsPerPage;
+		}
+	}
+
+	// trim(), and shrinks the page directory to the pages that are left
+	inline void shrink_to_fit()
+	{
+		trim();
+
+		if(m_pageCount == m_pageCapacity)
+		{
+			return;
+		}
 
-			index = index + m_skips[index + 1] + 1;
+		if(m_pageCount == 0)
+		{
+			delete[] m_pages;
+			m_pages = nullptr;
+			m_pageCapacity = 0;
+			return;
 		}
+
+		resize_directory(m_pageCount);
 	}
 
-	template<typename... Args>
-	inline iterator emplace(Args&&... args)
+	// Moves the elements from the back of the colony into the free slots at the front, until
+	// all elements are packed into the first pages. onMove(oldIndex, newIndex) is called for
+	// every relocated element, so external indices can be patched. The colony itself must not
+	// be accessed from onMove, and onMove must not throw. Elements are relocated with a memcpy
+	// when mst::is_trivially_relocatable<T> holds, otherwise by a move construction that must
+	// not throw either: the skip fields and the free list are only rebuilt after the last move.
+	// The pages emptied at the back are kept as empty pages, call trim() to release them.
+	template<typename Fn>
+	inline void compact(Fn onMove)
 	{
-		int32_t newIndex;
-		if(m_elementCount == m_capacity) // _MST_UNLIKELY
+		static_assert(
+			is_trivially_relocatable<T>::value || std::is_nothrow_move_constructible<T>::value,
+			"compact() needs T to be trivially relocatable or nothrow move constructible");
+
+		if(m_elementCount == 0)
 		{
-			newIndex = create_new();
+			return;
 		}
-		else
+
+		// the skip fields are only rebuilt afterwards, so both scans see the original layout
+		const auto nextFree = [this](int32_t index) {
+			while(index != m_capacity)
+			{
+				const auto pageIndex = index >> _MST_GET_SHIFT(ElementsPerPage);
+				if(!m_pages[pageIndex].elems)
+				{
+					index = (pageIndex + 1) << _MST_GET_SHIFT(ElementsPerPage);
+				}
+				else if(get_skip(index) == 0)
+				{
+					++index;
+				}
+				else
+				{
+					break;
+				}
+			}
+			return index;
+		};
+
+		auto dst = nextFree(0);
+		auto src = skip_backward(m_capacity - 1);
+
+		while(dst < src)
 		{
-			newIndex = get_from_free_list();
-			get_free_impl(newIndex).~FreeListNode();
-		}
+			auto& elem = get_impl(src);
+			void* const newElem = &get_impl(dst);
 
-		new(&get_impl(newIndex)) T(std::forward<Args>(args)...);
+			if constexpr(is_trivially_relocatable<T>::value)
+			{
+				memcpy(newElem, &elem, sizeof(T));
+			}
+			else
+			{
+				new(newElem) T(std::move(elem));
+				elem.~T();
+			}
 
-		return iterator(*this, newIndex);
-	}
+			// handles to the element now point at its old slot
+			++get_generation(src);
 
-	inline iterator erase(const_iterator it) noexcept
-	{
-		MST_ASSERT(it.m_container == this, "iterator is not attached to this container");
-		MST_ASSERT(it.m_index >= 0, "iterator out of range");
-		MST_ASSERT(it.m_index < m_capacity, "iterator out of range");
-		MST_ASSERT(m_skips[it.m_index] == 0, "iterator invalid");
+#if _MST_HAS_INVOKE
+			std::invoke(onMove, src, dst);
+#else
+			onMove(src, dst);
+#endif
 
-		get_impl(it.m_index).~T();
-		new(&get_free_impl(it.m_index)) FreeListNode{};
+			dst = nextFree(dst + 1);
+			src = prev_index(src);
+		}
 
-		const auto nextIndex = add_to_free_list(it.m_index);
+		// every allocated page is now full, up to the one page that is partially filled
+		m_freeListHead = -1;
 
-		return iterator(*this, nextIndex);
-	}
+		auto remaining = m_elementCount;
+		int32_t freeListPrev = -1;
 
-	inline int32_t erase(int32_t index) noexcept
-	{
-		MST_ASSERT(index >= 0, "iterator out of range");
-		MST_ASSERT(index < m_capacity, "iterator out of range");
-		MST_ASSERT(m_skips[index] == 0, "iterator invalid");
+		for(int32_t pageIndex = 0; pageIndex < m_pageCount; ++pageIndex)
+		{
+			auto& page = m_pages[pageIndex];
+			if(!page.elems)
+			{
+				continue;
+			}
 
-		get_impl(index).~T();
-		new(&get_free_impl(index)) FreeListNode{};
+			const auto pageSize = std::min(remaining, ElementsPerPage);
+			remaining -= pageSize;
 
-		const auto nextIndex = add_to_free_list(index);
+			if(pageSize == 0)
+			{
+				free_list().clear_page(pageIndex);
+				continue;
+			}
 
-		return nextIndex;
-	}
+			page.size = pageSize;
+			memset(page.skips, 0, size_t(pageSize) * sizeof(int32_t));
 
-	inline T& operator[](int32_t index) noexcept
-	{
-		MST_ASSERT(index >= 0, "iterator out of range");
-		MST_ASSERT(index < m_capacity, "iterator out of range");
-		MST_ASSERT(m_skips[index] == 0, "iterator invalid");
+			if(pageSize != ElementsPerPage)
+			{
+				const auto pageStart = pageIndex << _MST_GET_SHIFT(ElementsPerPage);
 
-		return get_impl(index);
+				freeListPrev = free_list().link_free_block(
+					pageStart + pageSize, ElementsPerPage - pageSize, freeListPrev);
+			}
+		}
+
+		empty_pages().rebuild();
 	}
 
-	inline const T& operator[](int32_t index) const noexcept
+	// compact(), returning a remap table: for every index before the compaction the new index of
+	// its element, or -1 when it held no element
+	inline std::vector<int32_t> compact()
 	{
-		MST_ASSERT(index >= 0, "iterator out of range");
-		MST_ASSERT(index < m_capacity, "iterator out of range");
-		MST_ASSERT(m_skips[index] == 0, "iterator invalid");
+		std::vector<int32_t> remap(static_cast<size_t>(m_capacity), -1);
 
-		return get_impl(index);
-	}
+		for(auto index = skip_forward(0); index != m_capacity; index = next_index(index))
+		{
+			remap[static_cast<size_t>(index)] = index;
+		}
 
-	_MST_NODISCARD inline size_t capacity() const noexcept
-	{
-		return static_cast<size_t>(m_capacity);
-	}
+		compact([&](int32_t oldIndex, int32_t newIndex) {
+			remap[static_cast<size_t>(oldIndex)] = newIndex;
+		});
 
-	_MST_NODISCARD inline size_t size() const noexcept
-	{
-		return static_cast<size_t>(m_elementCount);
+		return remap;
 	}
 
 	_MST_NODISCARD inline iterator begin() noexcept
 	{
-		return iterator(*this, m_skips[0]);
+		return iterator(*this, skip_forward(0));
 	}
 
 	_MST_NODISCARD inline iterator end() noexcept
@@ -251,7 +1428,7 @@ public:
 
 	_MST_NODISCARD inline const_iterator begin() const noexcept
 	{
-		return const_iterator(*this, m_skips[0]);
+		return const_iterator(*this, skip_forward(0));
 	}
 
 	_MST_NODISCARD inline const_iterator end() const noexcept
@@ -270,221 +1447,360 @@ public:
 	}
 
 private:
-	_MST_NODISCARD inline int32_t create_new()
+	// links the first empty page into the free list, appending a page when there are none
+	inline void claim_page()
 	{
-		MST_ASSERT(m_capacity == m_elementCount, "invalid create_new() call");
-
-		if(m_capacity == 0) // [[unlikely]]
+		auto pageIndex = empty_pages().take();
+		if(pageIndex == -1)
 		{
-			m_pages = new ElemType*[1];
-
-			m_pages[0] = new ElemType[ElementsPerPage];
+			pageIndex = append_page();
+		}
+		else if(!m_pages[pageIndex].elems)
+		{
+			restore_page(pageIndex);
+		}
 
-			for(int32_t e = 1; e < ElementsPerPage; ++e)
-			{
-				new(&m_pages[0][e].node) FreeListNode{};
-			}
+		(void)free_list().reset_page(pageIndex);
+	}
 
-			m_skips = new int32_t[ElementsPerPage + 1];
-			m_capacity = ElementsPerPage;
-			memset(m_skips + 2, 1, (ElementsPerPage - 3) * sizeof(int32_t));
-			m_skips[0] = 0;
-			m_skips[1] = ElementsPerPage - 1;
-			m_skips[ElementsPerPage - 1] = ElementsPerPage - 1;
-			m_skips[ElementsPerPage] = 0;
-			m_freeListHead = 1;
-			set_free_prev(1, -1);
-			set_free_next(1, -1);
-			return m_elementCount++;
+	// adds an empty page past the index range, which is not in any run yet
+	inline int32_t append_page()
+	{
+		if(m_pageCount == m_pageCapacity) // [[unlikely]]
+		{
+			// grow the page directory geometrically, the pages themselves never move
+			reserve_directory(m_pageCapacity == 0 ? 4 : m_pageCapacity * 2);
 		}
 
-		m_capacity += ElementsPerPage;
+		const auto pageIndex = m_pageCount;
 
-		const auto pageCount = m_capacity >> _MST_GET_SHIFT(ElementsPerPage);
-		const auto oldPageCount = m_elementCount >> _MST_GET_SHIFT(ElementsPerPage);
+		GenerationAllocator generationAllocator;
 
-		const auto newPages = new ElemType*[(size_t)pageCount];
-		const auto newSkips = new int32_t[size_t(m_capacity + 1)];
+		auto& page = m_pages[pageIndex];
+		page.generations = GenerationTraits::allocate(generationAllocator, ElementsPerPage);
+		std::fill_n(page.generations, ElementsPerPage, m_newPageGeneration);
+		page.emptyRun = 0;
 
-		for(int32_t i = 0; i < oldPageCount; ++i)
-		{
-			newPages[i] = m_pages[i];
-		}
+		++m_pageCount;
+		m_capacity += ElementsPerPage;
 
-		newPages[oldPageCount] = new ElemType[ElementsPerPage];
+		allocate_page(pageIndex);
 
-		for(int32_t e = 1; e < ElementsPerPage; ++e)
-		{
-			new(&newPages[oldPageCount][e].node) FreeListNode{};
-		}
+		return pageIndex;
+	}
 
-		memset(newSkips, 0, size_t(m_elementCount + 1) * sizeof(int32_t));
-		memset(newSkips + m_elementCount + 2, 1, size_t(ElementsPerPage - 3) * sizeof(int32_t));
-		newSkips[m_elementCount + 1] = ElementsPerPage - 1;
-		newSkips[m_capacity - 1] = ElementsPerPage - 1;
-		newSkips[m_capacity] = 0;
+	// allocates the memory of a released page, which stays in its run
+	inline void restore_page(int32_t pageIndex)
+	{
+		allocate_page(pageIndex);
 
-		delete[] m_pages;
-		delete[] m_skips;
+		--m_releasedPageCount;
+	}
 
-		m_pages = newPages;
-		m_skips = newSkips;
-		m_freeListHead = m_elementCount + 1;
+	inline void allocate_page(int32_t pageIndex)
+	{
+		auto& page = m_pages[pageIndex];
 
-		set_free_prev(m_elementCount + 1, -1);
-		set_free_next(m_elementCount + 1, -1);
+		ElemAllocator elemAllocator(m_allocator);
+		SkipAllocator skipAllocator;
 
-		return m_elementCount++;
+		page.elems = ElemTraits::allocate(elemAllocator, ElementsPerPage);
+		page.skips = SkipTraits::allocate(skipAllocator, ElementsPerPage);
+
+		free_list().clear_page(pageIndex);
 	}
 
-	_MST_NODISCARD inline int32_t get_from_free_list() noexcept
+	// Frees the slot of an erased element. A page that is emptied leaves the free list for the
+	// runs of empty pages. Returns the index after the free block or run that holds the slot.
+	_MST_NODISCARD inline int32_t free_slot(int32_t index) noexcept
 	{
-		MST_ASSERT(m_freeListHead != -1, "no free list elements");
+		--m_elementCount;
 
-		++m_elementCount;
+		const auto nextIndex = free_list().push(index);
+
+		const auto pageIndex = index >> _MST_GET_SHIFT(ElementsPerPage);
+		if(m_pages[pageIndex].size != 0)
+		{
+			return nextIndex;
+		}
 
-		int32_t newIndex = m_freeListHead;
+		free_list().unlink_free_block(pageIndex << _MST_GET_SHIFT(ElementsPerPage));
 
-		const auto rightIsDestroyed = m_skips[m_freeListHead + 1] != 0;
+		return empty_pages().add(pageIndex) << _MST_GET_SHIFT(ElementsPerPage);
+	}
 
-		if(rightIsDestroyed)
+	inline void reserve_directory(int32_t pageCapacity)
+	{
+		if(pageCapacity > m_pageCapacity)
 		{
-			const auto freeBlockSize = m_skips[m_freeListHead];
-			m_skips[m_freeListHead + 1] = freeBlockSize - 1;
-			m_skips[m_freeListHead + freeBlockSize - 1] = freeBlockSize - 1;
+			resize_directory(pageCapacity);
+		}
+	}
 
-			const auto freeNext = get_free_next(m_freeListHead);
-			++m_freeListHead;
-			if(freeNext != -1)
-			{
-				set_free_prev(freeNext, m_freeListHead);
-			}
+	inline void resize_directory(int32_t pageCapacity)
+	{
+		MST_ASSERT(pageCapacity >= m_pageCount, "page directory too small");
 
-			set_free_next(m_freeListHead, freeNext);
-			set_free_prev(m_freeListHead, -1);
-		}
-		else
+		const auto newPages = new PageType[(size_t)pageCapacity];
+
+		for(int32_t i = 0; i < m_pageCount; ++i)
 		{
-			m_freeListHead = get_free_next(m_freeListHead);
-			if(m_freeListHead != -1)
-			{
-				set_free_prev(m_freeListHead, -1);
-			}
+			newPages[i] = m_pages[i];
 		}
 
-		m_skips[newIndex] = 0;
+		delete[] m_pages;
 
-		return newIndex;
+		m_pages = newPages;
+		m_pageCapacity = pageCapacity;
 	}
 
-	_MST_NODISCARD inline int32_t add_to_free_list(int32_t index) noexcept
+	template<typename ConstructFn>
+	inline std::vector<int32_t> bulk_construct(int32_t count, ConstructFn construct)
 	{
-		--m_elementCount;
+		MST_ASSERT(count >= 0, "count must not be negative");
 
-		const auto leftIndex = std::max(index - 1, 0);
-		const auto rightIndex = index + 1;
+		std::vector<int32_t> indices;
+		indices.reserve(static_cast<size_t>(count));
 
-		const uint8_t leftIsDestroyed = m_skips[leftIndex] != 0;
-		const uint8_t rightIsDestroyed = m_skips[rightIndex] != 0;
+		reserve(size() + static_cast<size_t>(count));
 
-		switch(leftIsDestroyed | (rightIsDestroyed << 1))
+		while(count != 0)
 		{
-		case 0: // none
-			m_skips[index] = 1;
-
-			if(m_freeListHead != -1)
+			if(m_freeListHead == -1)
 			{
-				set_free_prev(m_freeListHead, index);
+				claim_page();
 			}
-			set_free_next(index, m_freeListHead);
-			set_free_prev(index, -1);
 
-			m_freeListHead = index;
-			return index + 1;
-		case 1: // end
-		{
-			const auto skipBlockSize = m_skips[leftIndex];
-			m_skips[index - skipBlockSize] = skipBlockSize + 1;
-			m_skips[index] = skipBlockSize + 1;
-			return index + 1;
-		}
-		case 2: // begin
-		{
-			const auto skipBlockSize = m_skips[rightIndex];
-			m_skips[index + skipBlockSize] = skipBlockSize + 1;
-			m_skips[index] = skipBlockSize + 1;
+			const auto first = m_freeListHead;
+			const auto claimed = free_list().take_front(count);
+
+			// free blocks never cross a page boundary, so the claimed run is contiguous
+			const auto& page = m_pages[first >> _MST_GET_SHIFT(ElementsPerPage)];
+			const auto elemIndex = first & (ElementsPerPage - 1);
 
-			const auto prev = get_free_prev(rightIndex);
-			const auto next = get_free_next(rightIndex);
+			int32_t constructed = 0;
 
-			if(m_freeListHead == rightIndex)
+#if _MST_HAS_EXCEPTIONS
+			try
+#endif
 			{
-				m_freeListHead = index;
+				for(; constructed < claimed; ++constructed)
+				{
+					construct(&page.elems[elemIndex + constructed].elem);
+
+					// a slot only becomes live once its element exists
+					free_list().set_live(first + constructed);
+					++m_elementCount;
+					indices.push_back(first + constructed);
+				}
 			}
-			else if(prev != -1)
+#if _MST_HAS_EXCEPTIONS
+			catch(...)
 			{
-				set_free_next(prev, index);
+				// The elements constructed so far stay, the rest of the slots are freed again. They
+				// are all marked live first, so each one merges with the free slots before it.
+				for(auto index = first + constructed; index != first + claimed; ++index)
+				{
+					free_list().set_live(index);
+					++m_elementCount;
+				}
+				for(auto index = first + constructed; index != first + claimed; ++index)
+				{
+					(void)free_slot(index);
+				}
+				throw;
 			}
+#endif
+
+			count -= claimed;
+		}
 
-			set_free_prev(index, prev);
-			set_free_next(index, next);
+		return indices;
+	}
 
-			if(next != -1)
-			{
-				set_free_prev(next, index);
-			}
+	template<typename Fn>
+	inline void foreach_page(int32_t pageIndex, Fn& func)
+	{
+		const auto& page = m_pages[pageIndex];
 
-			return index + skipBlockSize + 1;
-		}
-		// case 3: // both
-		default: {
-			m_skips[index] = 1;
+		foreach_live(page, [&](int32_t elemIndex) {
+#if _MST_HAS_INVOKE
+			std::invoke(func, *reinterpret_cast<T*>(&page.elems[elemIndex].elem));
+#else
+			func(*reinterpret_cast<T*>(&page.elems[elemIndex].elem));
+#endif
+		});
+	}
 
-			const auto skipBlockSizeLeft = m_skips[leftIndex];
-			const auto skipBlockSizeRight = m_skips[rightIndex];
+	template<typename Fn>
+	inline void foreach_page(int32_t pageIndex, Fn& func) const
+	{
+		const auto& page = m_pages[pageIndex];
 
-			m_skips[index - skipBlockSizeLeft] = skipBlockSizeLeft + skipBlockSizeRight + 1;
-			m_skips[index + skipBlockSizeRight] = skipBlockSizeLeft + skipBlockSizeRight + 1;
+		foreach_live(page, [&](int32_t elemIndex) {
+#if _MST_HAS_INVOKE
+			std::invoke(func, *reinterpret_cast<const T*>(&page.elems[elemIndex].elem));
+#else
+			func(*reinterpret_cast<const T*>(&page.elems[elemIndex].elem));
+#endif
+		});
+	}
 
-			const auto prev = get_free_prev(rightIndex);
-			const auto next = get_free_next(rightIndex);
+	// calls func(elemIndex) for every live slot of a page
+	template<typename Fn>
+	static inline void foreach_live(const PageType& page, Fn&& func)
+	{
+		if(page.size == ElementsPerPage)
+		{
+			// nothing to skip
+			for(int32_t elemIndex = 0; elemIndex != ElementsPerPage; ++elemIndex)
+			{
+				func(elemIndex);
+			}
+			return;
+		}
 
-			if(m_freeListHead == rightIndex)
+		int32_t elemIndex = 0;
+		while(elemIndex != ElementsPerPage)
+		{
+			const auto skip = page.skips[elemIndex];
+			if(skip != 0)
 			{
-				m_freeListHead = next;
-				set_free_prev(next, -1);
+				elemIndex += skip;
+				continue;
 			}
-			else
+
+#if _MST_HAS_AVX2
+			// visit the live elements a window at a time, instead of reading the skips one slot
+			// at a time, which is a chain of dependent loads when the page is full of small holes
+			auto liveMask = live_mask(page.skips, elemIndex);
+
+			if(liveMask == (uint32_t(1) << _Details::colony_scan_width) - 1)
 			{
-				set_free_next(prev, next);
-				if(next != -1)
+				for(int32_t i = 0; i != _Details::colony_scan_width; ++i)
 				{
-					set_free_prev(next, prev);
+					func(elemIndex + i);
 				}
+				elemIndex += _Details::colony_scan_width;
+				continue;
 			}
-			return index + skipBlockSizeRight + 1;
+
+			// one past the last live slot of the window is either live or starts a free block
+			const auto windowEnd = elemIndex + _Details::colony_bit_width(liveMask);
+
+			do
+			{
+				func(elemIndex + _Details::colony_lowest_bit(liveMask));
+				liveMask &= liveMask - 1;
+			} while(liveMask != 0);
+
+			elemIndex = windowEnd;
+#else
+			func(elemIndex);
+			++elemIndex;
+#endif
+		}
+	}
+
+	// live mask of the window of slots starting at elemIndex, clipped to the end of the page
+	_MST_NODISCARD static inline uint32_t live_mask(
+		const int32_t* skips, int32_t elemIndex) noexcept
+	{
+		if(ElementsPerPage < _Details::colony_scan_width)
+		{
+			return _Details::colony_live_mask(skips + elemIndex, ElementsPerPage - elemIndex);
 		}
+
+		const auto windowStart =
+			std::min(elemIndex, ElementsPerPage - _Details::colony_scan_width);
+
+		return _Details::colony_live_mask(skips + windowStart) >> (elemIndex - windowStart);
+	}
+
+	// splits the pages into a few contiguous ranges per executor thread and runs
+	// func(firstPage, endPage) for each of them
+	template<typename Executor, typename Fn>
+	inline void for_each_page_range(Executor& executor, Fn&& func) const
+	{
+		if(m_pageCount == 0)
+		{
+			return;
 		}
+
+		const auto pageCount = static_cast<size_t>(m_pageCount);
+		const auto taskCount =
+			std::min<size_t>(pageCount, std::max<size_t>(executor.concurrency(), 1) * 4);
+
+		executor.execute(taskCount, [&](size_t taskIndex) {
+			const auto firstPage = static_cast<int32_t>(pageCount * taskIndex / taskCount);
+			const auto endPage = static_cast<int32_t>(pageCount * (taskIndex + 1) / taskCount);
+
+			func(firstPage, endPage);
+		});
+	}
+
+	_MST_NODISCARD inline FreeList free_list() noexcept
+	{
+		return FreeList(PageLayout{ this }, m_freeListHead);
+	}
+
+	_MST_NODISCARD inline EmptyPages empty_pages() noexcept
+	{
+		return EmptyPages(PageLayout{ this }, m_emptyRunHead);
+	}
+
+	// returns the first live index at or after index, index must be live, start a free block or
+	// start a run of empty pages
+	_MST_NODISCARD inline int32_t skip_forward(int32_t index) const noexcept
+	{
+		return EmptyPages::skip_forward(PageLayout{ this }, index, m_capacity);
+	}
+
+	// returns the last live index at or before index, index must be live, end a free block or
+	// end a run of empty pages
+	_MST_NODISCARD inline int32_t skip_backward(int32_t index) const noexcept
+	{
+		return EmptyPages::skip_backward(PageLayout{ this }, index);
+	}
+
+	// returns the first live index in or after the page, which may be inside a run
+	_MST_NODISCARD inline int32_t page_begin(int32_t pageIndex) const noexcept
+	{
+		return EmptyPages::page_begin(PageLayout{ this }, pageIndex, m_capacity);
+	}
+
+	_MST_NODISCARD inline int32_t next_index(int32_t index) const noexcept
+	{
+		return skip_forward(index + 1);
 	}
 
-	_MST_NODISCARD inline int32_t get_free_prev(int32_t index) const noexcept
+	_MST_NODISCARD inline int32_t prev_index(int32_t index) const noexcept
 	{
-		return get_free_impl(index).prev;
+		return skip_backward(index - 1);
 	}
 
-	inline void set_free_prev(int32_t index, int32_t newPrev) noexcept
+	_MST_NODISCARD inline int32_t& get_skip(int32_t index) noexcept
 	{
-		get_free_impl(index).prev = newPrev;
+		const auto pageIndex = index >> _MST_GET_SHIFT(ElementsPerPage);
+		const auto elemIndex = index & (ElementsPerPage - 1);
+
+		return m_pages[pageIndex].skips[elemIndex];
 	}
 
-	_MST_NODISCARD inline int32_t get_free_next(int32_t index) const noexcept
+	_MST_NODISCARD inline uint32_t& get_generation(int32_t index) noexcept
 	{
-		return get_free_impl(index).next;
+		const auto pageIndex = index >> _MST_GET_SHIFT(ElementsPerPage);
+		const auto elemIndex = index & (ElementsPerPage - 1);
+
+		return m_pages[pageIndex].generations[elemIndex];
 	}
 
-	inline void set_free_next(int32_t index, int32_t newNext) noexcept
+	_MST_NODISCARD inline int32_t get_skip(int32_t index) const noexcept
 	{
-		get_free_impl(index).next = newNext;
+		const auto pageIndex = index >> _MST_GET_SHIFT(ElementsPerPage);
+		const auto elemIndex = index & (ElementsPerPage - 1);
+
+		return m_pages[pageIndex].skips[elemIndex];
 	}
 
 	_MST_NODISCARD inline T& get_impl(int32_t index) noexcept
@@ -497,7 +1813,7 @@ private:
 
 	_MST_NODISCARD inline T& get_impl(int32_t pageIndex, int32_t elemIndex) noexcept
 	{
-		return *reinterpret_cast<T*>(&m_pages[pageIndex][elemIndex].elem);
+		return *reinterpret_cast<T*>(&m_pages[pageIndex].elems[elemIndex].elem);
 	}
 
 	_MST_NODISCARD inline const T& get_impl(int32_t index) const noexcept
@@ -510,7 +1826,7 @@ private:
 
 	_MST_NODISCARD inline const T& get_impl(int32_t pageIndex, int32_t elemIndex) const noexcept
 	{
-		return *reinterpret_cast<const T*>(&m_pages[pageIndex][elemIndex].elem);
+		return *reinterpret_cast<const T*>(&m_pages[pageIndex].elems[elemIndex].elem);
 	}
 
 	_MST_NODISCARD inline FreeListNode& get_free_impl(int32_t index) noexcept
@@ -518,7 +1834,7 @@ private:
 		const auto pageIndex = index >> _MST_GET_SHIFT(ElementsPerPage);
 		const auto elemIndex = index & (ElementsPerPage - 1);
 
-		return m_pages[pageIndex][elemIndex].node;
+		return m_pages[pageIndex].elems[elemIndex].node;
 	}
 
 	_MST_NODISCARD inline const FreeListNode& get_free_impl(int32_t index) const noexcept
@@ -526,47 +1842,71 @@ private:
 		const auto pageIndex = index >> _MST_GET_SHIFT(ElementsPerPage);
 		const auto elemIndex = index & (ElementsPerPage - 1);
 
-		return m_pages[pageIndex][elemIndex].node;
+		return m_pages[pageIndex].elems[elemIndex].node;
+	}
+
+	inline void destroy_elements() noexcept
+	{
+		if(std::is_trivially_destructible<T>::value)
+		{
+			return;
+		}
+
+		foreach([](T& elem) { elem.~T(); });
 	}
 
 	inline void destroy_all()
 	{
-		if(m_pages)
-		{ // m_skips,m_capacity+1
-			auto index = m_skips[0];
+		destroy_elements();
 
-			while(index != m_capacity)
+		for(int32_t i = 0; i < m_pageCount; ++i)
+		{
+			if(m_pages[i].elems)
 			{
-				get_impl(index).~T();
-
-				index = index + m_skips[index + 1] + 1;
+				free_page(m_pages[i]);
 			}
+			free_generations(m_pages[i]);
+		}
 
-			const auto pageCount = m_capacity >> _MST_GET_SHIFT(ElementsPerPage);
+		delete[] m_pages;
+	}
 
-			for(int32_t i = 0; i < pageCount; ++i)
-			{
-				delete[] m_pages[i];
-			}
+	inline void free_generations(PageType& page) noexcept
+	{
+		GenerationAllocator generationAllocator;
 
-			delete[] m_pages;
-			delete[] m_skips;
-		}
+		GenerationTraits::deallocate(generationAllocator, page.generations, ElementsPerPage);
+	}
+
+	inline void free_page(PageType& page) noexcept
+	{
+		ElemAllocator elemAllocator(m_allocator);
+		SkipAllocator skipAllocator;
+
+		ElemTraits::deallocate(elemAllocator, page.elems, ElementsPerPage);
+		SkipTraits::deallocate(skipAllocator, page.skips, ElementsPerPage);
 	}
 
 private:
-	ElemType** m_pages;
+	PageType* m_pages;
+	int32_t m_pageCount, m_pageCapacity;
+	// m_capacity is the end of the index range, released pages included
 	int32_t m_elementCount, m_capacity;
 	int32_t m_freeListHead;
-	int32_t* m_skips;
+	// first run of empty pages, see _Details::colony_empty_pages
+	int32_t m_emptyRunHead;
+	int32_t m_releasedPageCount;
+	// generation of every slot of a page added past the current index range
+	uint32_t m_newPageGeneration;
+	Allocator m_allocator;
 
 }; // class colony
 
-template<typename T>
+template<typename T, int32_t ElementsPerPage, typename Allocator>
 class colony_iterator
 {
-	friend class colony<T>;
-	friend class colony_const_iterator<T>;
+	friend class colony<T, ElementsPerPage, Allocator>;
+	friend class colony_const_iterator<T, ElementsPerPage, Allocator>;
 
 public:
 	inline colony_iterator() noexcept
@@ -574,7 +1914,7 @@ public:
 		, m_index(0)
 	{ }
 
-	inline colony_iterator(colony<T>& container, int32_t index) noexcept
+	inline colony_iterator(colony<T, ElementsPerPage, Allocator>& container, int32_t index) noexcept
 		: m_container(&container)
 		, m_index(index)
 	{ }
@@ -585,28 +1925,28 @@ public:
 	colony_iterator& operator=(const colony_iterator&) = default;
 	colony_iterator& operator=(colony_iterator&&) = default;
 
-	_MST_NODISCARD inline colony_iterator& operator++() noexcept
+	inline colony_iterator& operator++() noexcept
 	{
-		MST_ASSERT(m_index < m_container->m_capacity, "cannot decrement end iterator");
+		MST_ASSERT(m_index < m_container->m_capacity, "cannot increment end iterator");
 
-		m_index += m_container->m_skips[m_index + 1] + 1;
+		m_index = m_container->next_index(m_index);
 		return *this;
 	}
 
 	_MST_NODISCARD inline colony_iterator operator++(int) noexcept
 	{
-		MST_ASSERT(m_index < m_container->m_capacity, "cannot decrement end iterator");
+		MST_ASSERT(m_index < m_container->m_capacity, "cannot increment end iterator");
 
 		const auto retval = *this;
-		m_index += m_container->m_skips[m_index + 1] + 1;
+		m_index = m_container->next_index(m_index);
 		return retval;
 	}
 
-	_MST_NODISCARD inline colony_iterator& operator--() noexcept
+	inline colony_iterator& operator--() noexcept
 	{
 		MST_ASSERT(m_index > 0, "cannot decrement begin iterator");
 
-		m_index += m_container->m_skips[m_index - 1] - 1;
+		m_index = m_container->prev_index(m_index);
 		return *this;
 	}
 
@@ -615,7 +1955,7 @@ public:
 		MST_ASSERT(m_index > 0, "cannot decrement begin iterator");
 
 		const auto retval = *this;
-		m_index += m_container->m_skips[m_index - 1] - 1;
+		m_index = m_container->prev_index(m_index);
 		return retval;
 	}
 
@@ -633,18 +1973,18 @@ public:
 
 	_MST_NODISCARD inline T& operator*() const noexcept
 	{
-		MST_ASSERT(m_index >= 0, "cannot decrement iterator");
-		MST_ASSERT(m_index < m_container->m_capacity, "cannot decrement iterator");
-		MST_ASSERT(m_container->m_skips[m_index] == 0, "cannot decrement iterator");
+		MST_ASSERT(m_index >= 0, "cannot dereference iterator");
+		MST_ASSERT(m_index < m_container->m_capacity, "cannot dereference iterator");
+		MST_ASSERT(m_container->get_skip(m_index) == 0, "cannot dereference iterator");
 
 		return m_container->get_impl(m_index);
 	}
 
 	_MST_NODISCARD inline T* operator->() const noexcept
 	{
-		MST_ASSERT(m_index >= 0, "cannot decrement iterator");
-		MST_ASSERT(m_index < m_container->m_capacity, "cannot decrement iterator");
-		MST_ASSERT(m_container->m_skips[m_index] == 0, "cannot decrement iterator");
+		MST_ASSERT(m_index >= 0, "cannot dereference iterator");
+		MST_ASSERT(m_index < m_container->m_capacity, "cannot dereference iterator");
+		MST_ASSERT(m_container->get_skip(m_index) == 0, "cannot dereference iterator");
 
 		return &m_container->get_impl(m_index);
 	}
@@ -656,22 +1996,22 @@ public:
 
 	_MST_NODISCARD T* ptr() const noexcept
 	{
-		MST_ASSERT(m_index >= 0, "cannot decrement iterator");
-		MST_ASSERT(m_index < m_container->m_capacity, "cannot decrement iterator");
-		MST_ASSERT(m_container->m_skips[m_index] == 0, "cannot decrement iterator");
+		MST_ASSERT(m_index >= 0, "cannot dereference iterator");
+		MST_ASSERT(m_index < m_container->m_capacity, "cannot dereference iterator");
+		MST_ASSERT(m_container->get_skip(m_index) == 0, "cannot dereference iterator");
 
 		return &m_container->get_impl(m_index);
 	}
 
 private:
-	colony<T>* m_container;
+	colony<T, ElementsPerPage, Allocator>* m_container;
 	int32_t m_index;
 };
 
-template<typename T>
+template<typename T, int32_t ElementsPerPage, typename Allocator>
 class colony_const_iterator
 {
-	friend class colony<T>;
+	friend class colony<T, ElementsPerPage, Allocator>;
 
 public:
 	inline colony_const_iterator() noexcept
@@ -679,30 +2019,49 @@ public:
 		, m_index(0)
 	{ }
 
-	inline colony_const_iterator(const colony<T>& container, int32_t index) noexcept
+	inline colony_const_iterator(
+		const colony<T, ElementsPerPage, Allocator>& container, int32_t index) noexcept
 		: m_container(&container)
 		, m_index(index)
 	{ }
 
-	inline colony_const_iterator(const colony_iterator<T>& other) noexcept
+	inline colony_const_iterator(
+		const colony_iterator<T, ElementsPerPage, Allocator>& other) noexcept
 		: m_container(other.m_container)
 		, m_index(other.m_index)
 	{ }
 
-	_MST_NODISCARD inline colony_const_iterator& operator++() noexcept
+	inline colony_const_iterator& operator++() noexcept
 	{
-		MST_ASSERT(m_index < m_container->m_capacity, "cannot decrement end iterator");
+		MST_ASSERT(m_index < m_container->m_capacity, "cannot increment end iterator");
 
-		m_index += m_container->m_skips[m_index + 1] + 1;
+		m_index = m_container->next_index(m_index);
 		return *this;
 	}
 
 	_MST_NODISCARD inline colony_const_iterator operator++(int) noexcept
 	{
-		MST_ASSERT(m_index < m_container->m_capacity, "cannot decrement end iterator");
+		MST_ASSERT(m_index < m_container->m_capacity, "cannot increment end iterator");
+
+		const auto retval = *this;
+		m_index = m_container->next_index(m_index);
+		return retval;
+	}
+
+	inline colony_const_iterator& operator--() noexcept
+	{
+		MST_ASSERT(m_index > 0, "cannot decrement begin iterator");
+
+		m_index = m_container->prev_index(m_index);
+		return *this;
+	}
+
+	_MST_NODISCARD inline colony_const_iterator operator--(int) noexcept
+	{
+		MST_ASSERT(m_index > 0, "cannot decrement begin iterator");
 
 		const auto retval = *this;
-		m_index += m_container->m_skips[m_index + 1] + 1;
+		m_index = m_container->prev_index(m_index);
 		return retval;
 	}
 
@@ -720,18 +2079,18 @@ public:
 
 	_MST_NODISCARD inline const T& operator*() const noexcept
 	{
-		MST_ASSERT(m_index >= 0, "cannot decrement iterator");
-		MST_ASSERT(m_index < m_container->m_capacity, "cannot decrement iterator");
-		MST_ASSERT(m_container->m_skips[m_index] == 0, "cannot decrement iterator");
+		MST_ASSERT(m_index >= 0, "cannot dereference iterator");
+		MST_ASSERT(m_index < m_container->m_capacity, "cannot dereference iterator");
+		MST_ASSERT(m_container->get_skip(m_index) == 0, "cannot dereference iterator");
 
 		return m_container->get_impl(m_index);
 	}
 
 	_MST_NODISCARD inline const T* operator->() const noexcept
 	{
-		MST_ASSERT(m_index >= 0, "cannot decrement iterator");
-		MST_ASSERT(m_index < m_container->m_capacity, "cannot decrement iterator");
-		MST_ASSERT(m_container->m_skips[m_index] == 0, "cannot decrement iterator");
+		MST_ASSERT(m_index >= 0, "cannot dereference iterator");
+		MST_ASSERT(m_index < m_container->m_capacity, "cannot dereference iterator");
+		MST_ASSERT(m_container->get_skip(m_index) == 0, "cannot dereference iterator");
 
 		return &m_container->get_impl(m_index);
 	}
@@ -743,16 +2102,16 @@ public:
 
 	_MST_NODISCARD const T* ptr() const noexcept
 	{
-		MST_ASSERT(m_index >= 0, "cannot decrement iterator");
-		MST_ASSERT(m_index < m_container->m_capacity, "cannot decrement iterator");
-		MST_ASSERT(m_container->m_skips[m_index] == 0, "cannot decrement iterator");
+		MST_ASSERT(m_index >= 0, "cannot dereference iterator");
+		MST_ASSERT(m_index < m_container->m_capacity, "cannot dereference iterator");
+		MST_ASSERT(m_container->get_skip(m_index) == 0, "cannot dereference iterator");
 
 		return &m_container->get_impl(m_index);
 	}
 
 private:
-	const colony<T>* m_container;
+	const colony<T, ElementsPerPage, Allocator>* m_container;
 	int32_t m_index;
 };
 
-} // namespace mst
\ No newline at end of file
+} // namespace mst
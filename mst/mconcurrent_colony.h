@@ -0,0 +1,482 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//      MST Utility Library                                                                 //
+//      Copyright (c)2026 Martinus Terpstra                                                 //
+//                                                                                          //
+//      Permission is hereby granted, free of charge, to any person obtaining a copy        //
+//      of this software and associated documentation files (the "Software"), to deal       //
+//      in the Software without restriction, including without limitation the rights        //
+//      to use, copy, modify, merge, publish, distribute, sublicense, and/or sell           //
+//      copies of the Software, and to permit persons to whom the Software is               //
+//      furnished to do so, subject to the following conditions:                            //
+//                                                                                          //
+//      The above copyright notice and this permission notice shall be included in          //
+//      all copies or substantial portions of the Software.                                 //
+//                                                                                          //
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR          //
+//      IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,            //
+//      FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE         //
+//      AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER              //
+//      LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,       //
+//      OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN           //
+//      THE SOFTWARE.                                                                       //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <mcolony.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <limits>
+
+namespace mst {
+
+namespace _Details {
+
+_MST_NODISCARD inline uint64_t next_concurrent_colony_id() noexcept
+{
+	static std::atomic<uint64_t> nextId{ 1 };
+
+	return nextId.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace _Details
+
+// A colony that many threads can emplace into and erase from at the same time. It uses the same
+// pages and skip fields as colony, but every thread that emplaces owns its own pages and free
+// list, so emplace and erase never take a shared lock. Erasing an element in a page of another
+// thread destroys it and pushes the slot onto a lock-free list of the owning thread, which takes
+// the slots back into its free list once its own free slots run out. Only adding a page locks.
+//
+// Iteration, clear() and size() are only exact at quiescent points: no thread may emplace or
+// erase at the same time. Indices are stable and can be used with operator[] from any thread.
+template<typename T, int32_t ElementsPerPage = MST_DEFAULT_COLONY_PAGE_SIZE>
+class concurrent_colony
+{
+	static_assert(ElementsPerPage > 0 && (ElementsPerPage & (ElementsPerPage - 1)) == 0,
+		"ElementsPerPage must be a power of two");
+
+	typedef _Details::colony_free_list_node FreeListNode;
+
+	union ElemType
+	{
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type elem;
+		FreeListNode node;
+		// link in the remote free list of the owning thread, set by the erasing thread
+		int32_t remoteNext;
+	};
+
+	struct ThreadState;
+
+	// the skip field and size are only touched by the owning thread
+	struct PageType : _Details::colony_page_header
+	{
+		ElemType* elems;
+		ThreadState* owner;
+	};
+
+	// gives the free lists access to the pages
+	struct PageLayout
+	{
+		const concurrent_colony* self;
+
+		_MST_NODISCARD inline _Details::colony_page_header& page(int32_t pageIndex) const noexcept
+		{
+			return self->get_page(pageIndex);
+		}
+
+		_MST_NODISCARD inline FreeListNode* node(int32_t index) const noexcept
+		{
+			return &self->get_elem(index).node;
+		}
+	};
+
+	typedef _Details::colony_free_list<ElementsPerPage, PageLayout> FreeList;
+
+	struct alignas(64) ThreadState
+	{
+		std::thread::id threadId;
+		// next registered thread, never changes once published
+		ThreadState* next;
+		int32_t freeListHead;
+		std::atomic<int32_t> elementCount;
+		// slots erased by other threads, kept on their own cache line as all of them push to it
+		alignas(64) std::atomic<int32_t> remoteFreeHead;
+	};
+
+	struct ThreadCache
+	{
+		uint64_t colonyId;
+		ThreadState* state;
+	};
+
+	// page i is stored in segment bit_width(i + 1) - 1, segment s holds 2^s pages. Segments
+	// never move, so pages can be looked up while another thread adds one.
+	static constexpr int32_t SegmentCount = 32;
+
+public:
+	inline concurrent_colony() noexcept
+		: m_id(_Details::next_concurrent_colony_id())
+		, m_pageCount(0)
+		, m_states(nullptr)
+	{
+		for(auto& segment : m_segments)
+		{
+			segment.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	concurrent_colony(const concurrent_colony&) = delete;
+	concurrent_colony& operator=(const concurrent_colony&) = delete;
+
+	inline ~concurrent_colony()
+	{
+		destroy_all();
+	}
+
+	// Constructs an element in a free slot of the calling thread, or in a new page of it
+	template<typename... Args>
+	inline int32_t emplace(Args&&... args)
+	{
+		auto& state = local_state();
+
+		if(state.freeListHead == -1) // _MST_UNLIKELY
+		{
+			reclaim_remote_frees(state);
+
+			if(state.freeListHead == -1)
+			{
+				add_page(state);
+			}
+		}
+
+		const int32_t newIndex = free_list(state).pop();
+		get_elem(newIndex).node.~FreeListNode();
+
+#if _MST_HAS_EXCEPTIONS
+		try
+#endif
+		{
+			new(&get_elem(newIndex).elem) T(std::forward<Args>(args)...);
+		}
+#if _MST_HAS_EXCEPTIONS
+		catch(...)
+		{
+			// the node shares the slot with the element, so the slot goes back to the free list
+			new(&get_elem(newIndex).node) FreeListNode{};
+			(void)free_list(state).push(newIndex);
+			throw;
+		}
+#endif
+
+		state.elementCount.fetch_add(1, std::memory_order_relaxed);
+
+		return newIndex;
+	}
+
+	// Can be called from any thread, but every element must be erased only once
+	inline void erase(int32_t index) noexcept
+	{
+		MST_ASSERT(index >= 0, "index out of range");
+		MST_ASSERT(index < capacity(), "index out of range");
+
+		auto& page = get_page(index >> _MST_GET_SHIFT(ElementsPerPage));
+		auto& elem = page.elems[index & (ElementsPerPage - 1)];
+
+		reinterpret_cast<T*>(&elem.elem)->~T();
+
+		auto& owner = *page.owner;
+		owner.elementCount.fetch_sub(1, std::memory_order_relaxed);
+
+		if(owner.threadId == std::this_thread::get_id())
+		{
+			new(&elem.node) FreeListNode{};
+			(void)free_list(owner).push(index);
+			return;
+		}
+
+		// the skip field belongs to the owner, hand the slot over
+		auto head = owner.remoteFreeHead.load(std::memory_order_relaxed);
+		do
+		{
+			elem.remoteNext = head;
+		} while(!owner.remoteFreeHead.compare_exchange_weak(
+			head, index, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	_MST_NODISCARD inline T& operator[](int32_t index) noexcept
+	{
+		MST_ASSERT(index >= 0, "index out of range");
+		MST_ASSERT(index < capacity(), "index out of range");
+
+		return *reinterpret_cast<T*>(&get_elem(index).elem);
+	}
+
+	_MST_NODISCARD inline const T& operator[](int32_t index) const noexcept
+	{
+		MST_ASSERT(index >= 0, "index out of range");
+		MST_ASSERT(index < capacity(), "index out of range");
+
+		return *reinterpret_cast<const T*>(&get_elem(index).elem);
+	}
+
+	// Calls func for every element, quiescent points only
+	template<typename Fn>
+	inline void foreach(Fn func)
+	{
+		reclaim_all_remote_frees();
+
+		const auto pageCount = m_pageCount.load(std::memory_order_acquire);
+
+		for(int32_t pageIndex = 0; pageIndex < pageCount; ++pageIndex)
+		{
+			const auto& page = get_page(pageIndex);
+
+			int32_t elemIndex = 0;
+			while(elemIndex != ElementsPerPage)
+			{
+				const auto skip = page.skips[elemIndex];
+				if(skip != 0)
+				{
+					elemIndex += skip;
+					continue;
+				}
+
+#if _MST_HAS_INVOKE
+				std::invoke(func, *reinterpret_cast<T*>(&page.elems[elemIndex].elem));
+#else
+				func(*reinterpret_cast<T*>(&page.elems[elemIndex].elem));
+#endif
+
+				++elemIndex;
+			}
+		}
+	}
+
+	// Destroys every element, quiescent points only. The pages stay with their threads.
+	inline void clear() noexcept
+	{
+		destroy_elements();
+
+		for(auto state = m_states.load(std::memory_order_acquire); state; state = state->next)
+		{
+			state->freeListHead = -1;
+			state->elementCount.store(0, std::memory_order_relaxed);
+		}
+
+		const auto pageCount = m_pageCount.load(std::memory_order_acquire);
+
+		for(int32_t pageIndex = 0; pageIndex < pageCount; ++pageIndex)
+		{
+			auto& page = get_page(pageIndex);
+
+			free_list(*page.owner).reset_page(pageIndex);
+		}
+	}
+
+	// Exact at quiescent points only
+	_MST_NODISCARD inline size_t size() const noexcept
+	{
+		int64_t retval = 0;
+		for(auto state = m_states.load(std::memory_order_acquire); state; state = state->next)
+		{
+			retval += state->elementCount.load(std::memory_order_relaxed);
+		}
+		return static_cast<size_t>(retval);
+	}
+
+	_MST_NODISCARD inline bool empty() const noexcept
+	{
+		return size() == 0;
+	}
+
+	_MST_NODISCARD inline int32_t capacity() const noexcept
+	{
+		return m_pageCount.load(std::memory_order_acquire) * ElementsPerPage;
+	}
+
+	_MST_NODISCARD inline int32_t page_count() const noexcept
+	{
+		return m_pageCount.load(std::memory_order_acquire);
+	}
+
+private:
+	_MST_NODISCARD static inline ThreadCache& thread_cache() noexcept
+	{
+		static thread_local ThreadCache cache{ 0, nullptr };
+
+		return cache;
+	}
+
+	_MST_NODISCARD inline ThreadState& local_state()
+	{
+		auto& cache = thread_cache();
+
+		if(cache.colonyId != m_id) // _MST_UNLIKELY
+		{
+			cache.state = &find_or_add_state();
+			cache.colonyId = m_id;
+		}
+
+		return *cache.state;
+	}
+
+	_MST_NODISCARD inline ThreadState& find_or_add_state()
+	{
+		const auto threadId = std::this_thread::get_id();
+
+		for(auto state = m_states.load(std::memory_order_acquire); state; state = state->next)
+		{
+			if(state->threadId == threadId)
+			{
+				return *state;
+			}
+		}
+
+		// only the thread itself adds its state, so it can't have been added in the meantime
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto state = new ThreadState;
+		state->threadId = threadId;
+		state->next = m_states.load(std::memory_order_relaxed);
+		state->freeListHead = -1;
+		state->elementCount.store(0, std::memory_order_relaxed);
+		state->remoteFreeHead.store(-1, std::memory_order_relaxed);
+
+		m_states.store(state, std::memory_order_release);
+
+		return *state;
+	}
+
+	inline void add_page(ThreadState& state)
+	{
+		int32_t pageIndex;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			pageIndex = m_pageCount.load(std::memory_order_relaxed);
+
+			MST_ASSERT(pageIndex < (std::numeric_limits<int32_t>::max() >>
+									   _MST_GET_SHIFT(ElementsPerPage)),
+				"concurrent_colony is full");
+
+			const auto position = static_cast<uint32_t>(pageIndex) + 1;
+			const auto segment = _Details::colony_bit_width(position) - 1;
+
+			auto pages = m_segments[segment].load(std::memory_order_relaxed);
+			if(!pages)
+			{
+				pages = new PageType[size_t(1) << segment];
+				m_segments[segment].store(pages, std::memory_order_release);
+			}
+
+			auto& page = pages[position - (uint32_t(1) << segment)];
+
+			page.elems = new ElemType[ElementsPerPage];
+			page.skips = new int32_t[ElementsPerPage];
+			page.size = 0;
+			page.owner = &state;
+
+			m_pageCount.store(pageIndex + 1, std::memory_order_release);
+		}
+
+		free_list(state).reset_page(pageIndex);
+	}
+
+	inline void reclaim_remote_frees(ThreadState& state) noexcept
+	{
+		auto index = state.remoteFreeHead.exchange(-1, std::memory_order_acquire);
+
+		while(index != -1)
+		{
+			const auto next = get_elem(index).remoteNext;
+
+			new(&get_elem(index).node) FreeListNode{};
+			(void)free_list(state).push(index);
+
+			index = next;
+		}
+	}
+
+	inline void reclaim_all_remote_frees() noexcept
+	{
+		for(auto state = m_states.load(std::memory_order_acquire); state; state = state->next)
+		{
+			reclaim_remote_frees(*state);
+		}
+	}
+
+	// the free list of the pages of a thread, only used by that thread
+	_MST_NODISCARD inline FreeList free_list(ThreadState& state) const noexcept
+	{
+		return FreeList(PageLayout{ this }, state.freeListHead);
+	}
+
+	_MST_NODISCARD inline PageType& get_page(int32_t pageIndex) const noexcept
+	{
+		const auto position = static_cast<uint32_t>(pageIndex) + 1;
+		const auto segment = _Details::colony_bit_width(position) - 1;
+
+		return m_segments[segment].load(
+			std::memory_order_acquire)[position - (uint32_t(1) << segment)];
+	}
+
+	_MST_NODISCARD inline ElemType& get_elem(int32_t index) const noexcept
+	{
+		return get_page(index >> _MST_GET_SHIFT(ElementsPerPage))
+			.elems[index & (ElementsPerPage - 1)];
+	}
+
+	inline void destroy_elements() noexcept
+	{
+		if(std::is_trivially_destructible<T>::value)
+		{
+			reclaim_all_remote_frees();
+			return;
+		}
+
+		foreach([](T& elem) { elem.~T(); });
+	}
+
+	inline void destroy_all() noexcept
+	{
+		destroy_elements();
+
+		const auto pageCount = m_pageCount.load(std::memory_order_acquire);
+
+		for(int32_t pageIndex = 0; pageIndex < pageCount; ++pageIndex)
+		{
+			auto& page = get_page(pageIndex);
+
+			delete[] page.elems;
+			delete[] page.skips;
+		}
+
+		for(auto& segment : m_segments)
+		{
+			delete[] segment.load(std::memory_order_relaxed);
+		}
+
+		auto state = m_states.load(std::memory_order_acquire);
+		while(state)
+		{
+			const auto next = state->next;
+			delete state;
+			state = next;
+		}
+	}
+
+private:
+	// unique for every colony ever created, so a stale thread cache never matches a new colony
+	const uint64_t m_id;
+	std::atomic<PageType*> m_segments[SegmentCount];
+	std::atomic<int32_t> m_pageCount;
+	std::atomic<ThreadState*> m_states;
+	// guards adding pages and threads
+	std::mutex m_mutex;
+
+}; // class concurrent_colony
+
+} // namespace mst
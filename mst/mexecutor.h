@@ -0,0 +1,168 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//      MST Utility Library                                                                 //
+//      Copyright (c)2026 Martinus Terpstra                                                 //
+//                                                                                          //
+//      Permission is hereby granted, free of charge, to any person obtaining a copy        //
+//      of this software and associated documentation files (the "Software"), to deal       //
+//      in the Software without restriction, including without limitation the rights        //
+//      to use, copy, modify, merge, publish, distribute, sublicense, and/or sell           //
+//      copies of the Software, and to permit persons to whom the Software is               //
+//      furnished to do so, subject to the following conditions:                            //
+//                                                                                          //
+//      The above copyright notice and this permission notice shall be included in          //
+//      all copies or substantial portions of the Software.                                 //
+//                                                                                          //
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR          //
+//      IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,            //
+//      FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE         //
+//      AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER              //
+//      LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,       //
+//      OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN           //
+//      THE SOFTWARE.                                                                       //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <mcore.h>
+#include <mscope_guard.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <exception>
+
+namespace mst {
+namespace threading {
+
+// An executor runs task(0) up to task(taskCount - 1) and returns once all of them have finished.
+// The parallel algorithms of the containers only require these two members:
+//
+//   uint32_t concurrency() const;
+//   template<typename Fn> void execute(size_t taskCount, Fn&& task);
+
+// Runs every task on the calling thread
+class inline_executor
+{
+public:
+	_MST_NODISCARD inline uint32_t concurrency() const noexcept
+	{
+		return 1;
+	}
+
+	template<typename Fn>
+	inline void execute(size_t taskCount, Fn&& task)
+	{
+		for(size_t i = 0; i < taskCount; ++i)
+		{
+			task(i);
+		}
+	}
+};
+
+// Spreads the tasks over threadCount std::threads, the calling thread being one of them.
+// Threads pick up tasks one at a time, so uneven tasks are balanced automatically.
+// The first exception thrown by a task is rethrown on the calling thread.
+class thread_executor
+{
+public:
+	inline explicit thread_executor(uint32_t threadCount = 0) noexcept
+		: m_threadCount(threadCount != 0 ? threadCount : default_thread_count())
+	{ }
+
+	_MST_NODISCARD inline uint32_t concurrency() const noexcept
+	{
+		return m_threadCount;
+	}
+
+	template<typename Fn>
+	inline void execute(size_t taskCount, Fn&& task)
+	{
+		const auto threadCount = std::min<size_t>(m_threadCount, taskCount);
+
+		if(threadCount <= 1)
+		{
+			for(size_t i = 0; i < taskCount; ++i)
+			{
+				task(i);
+			}
+			return;
+		}
+
+		std::atomic<size_t> nextTask{ 0 };
+
+#if _MST_HAS_EXCEPTIONS
+		std::exception_ptr error;
+		std::atomic_flag errorSet = ATOMIC_FLAG_INIT;
+#endif
+
+		const auto worker = [&] {
+#if _MST_HAS_EXCEPTIONS
+			try
+#endif
+			{
+				size_t taskIndex;
+				while((taskIndex = nextTask.fetch_add(1, std::memory_order_relaxed)) < taskCount)
+				{
+					task(taskIndex);
+				}
+			}
+#if _MST_HAS_EXCEPTIONS
+			catch(...)
+			{
+				if(!errorSet.test_and_set())
+				{
+					error = std::current_exception();
+				}
+
+				// stop handing out new tasks
+				nextTask.store(taskCount, std::memory_order_relaxed);
+			}
+#endif
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount - 1);
+
+		{
+			// joins the started threads, also when starting the next one throws
+			auto joinThreads = ::mst::scope_guard([&] {
+				for(auto& thread : threads)
+				{
+					if(thread.joinable())
+					{
+						thread.join();
+					}
+				}
+			});
+
+			for(size_t i = 1; i < threadCount; ++i)
+			{
+				threads.emplace_back(worker);
+			}
+
+			worker();
+		}
+
+#if _MST_HAS_EXCEPTIONS
+		if(error)
+		{
+			std::rethrow_exception(error);
+		}
+#endif
+	}
+
+private:
+	_MST_NODISCARD inline static uint32_t default_thread_count() noexcept
+	{
+		const auto hardwareThreads = std::thread::hardware_concurrency();
+		return hardwareThreads != 0 ? hardwareThreads : 1;
+	}
+
+private:
+	uint32_t m_threadCount;
+};
+
+} // namespace threading
+} // namespace mst
@@ -0,0 +1,609 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//      MST Utility Library                                                                 //
+//      Copyright (c)2026 Martinus Terpstra                                                 //
+//                                                                                          //
+//      Permission is hereby granted, free of charge, to any person obtaining a copy        //
+//      of this software and associated documentation files (the "Software"), to deal       //
+//      in the Software without restriction, including without limitation the rights        //
+//      to use, copy, modify, merge, publish, distribute, sublicense, and/or sell           //
+//      copies of the Software, and to permit persons to whom the Software is               //
+//      furnished to do so, subject to the following conditions:                            //
+//                                                                                          //
+//      The above copyright notice and this permission notice shall be included in          //
+//      all copies or substantial portions of the Software.                                 //
+//                                                                                          //
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR          //
+//      IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,            //
+//      FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE         //
+//      AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER              //
+//      LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,       //
+//      OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN           //
+//      THE SOFTWARE.                                                                       //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <mcore.h>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <type_traits>
+#include <mdebug.h>
+#include <mx_common.h>
+#include <mx_packed_pair.h>
+#include <initializer_list>
+
+namespace mst {
+
+// Random access iterator over a flat_soa_map. Dereferencing yields a pair of references into
+// the key and value arrays, operator-> returns a proxy holding that pair.
+template<typename KeyType, typename ValueType>
+class flat_soa_map_iterator
+{
+public:
+	typedef ::std::random_access_iterator_tag iterator_category;
+	typedef ::std::pair<const KeyType, ::std::remove_const_t<ValueType>> value_type;
+	typedef ::std::pair<const KeyType&, ValueType&> reference;
+	typedef ptrdiff_t difference_type;
+
+	class pointer
+	{
+	public:
+		inline explicit pointer(reference ref)
+			: _Myref(ref)
+		{ }
+
+		inline const reference* operator->() const
+		{
+			return &_Myref;
+		}
+
+	private:
+		reference _Myref;
+	};
+
+	inline flat_soa_map_iterator()
+		: _Mykey(nullptr)
+		, _Myvalue(nullptr)
+	{ }
+
+	inline flat_soa_map_iterator(const KeyType* key, ValueType* value)
+		: _Mykey(key)
+		, _Myvalue(value)
+	{ }
+
+	// non-const to const conversion
+	template<typename OtherValueType,
+		typename ::std::enable_if<::std::is_same<const OtherValueType, ValueType>::value &&
+									  !::std::is_same<OtherValueType, ValueType>::value,
+			int>::type = 0>
+	inline flat_soa_map_iterator(const flat_soa_map_iterator<KeyType, OtherValueType>& other)
+		: _Mykey(other._Mykey)
+		, _Myvalue(other._Myvalue)
+	{ }
+
+	_MST_NODISCARD inline reference operator*() const
+	{
+		return reference(*_Mykey, *_Myvalue);
+	}
+
+	_MST_NODISCARD inline pointer operator->() const
+	{
+		return pointer(**this);
+	}
+
+	_MST_NODISCARD inline reference operator[](ptrdiff_t offset) const
+	{
+		return reference(_Mykey[offset], _Myvalue[offset]);
+	}
+
+	inline flat_soa_map_iterator& operator++()
+	{
+		++_Mykey;
+		++_Myvalue;
+		return *this;
+	}
+
+	inline flat_soa_map_iterator operator++(int)
+	{
+		flat_soa_map_iterator result = *this;
+		++*this;
+		return result;
+	}
+
+	inline flat_soa_map_iterator& operator--()
+	{
+		--_Mykey;
+		--_Myvalue;
+		return *this;
+	}
+
+	inline flat_soa_map_iterator operator--(int)
+	{
+		flat_soa_map_iterator result = *this;
+		--*this;
+		return result;
+	}
+
+	inline flat_soa_map_iterator& operator+=(ptrdiff_t offset)
+	{
+		_Mykey += offset;
+		_Myvalue += offset;
+		return *this;
+	}
+
+	inline flat_soa_map_iterator& operator-=(ptrdiff_t offset)
+	{
+		_Mykey -= offset;
+		_Myvalue -= offset;
+		return *this;
+	}
+
+	_MST_NODISCARD inline flat_soa_map_iterator operator+(ptrdiff_t offset) const
+	{
+		return flat_soa_map_iterator(_Mykey + offset, _Myvalue + offset);
+	}
+
+	_MST_NODISCARD inline flat_soa_map_iterator operator-(ptrdiff_t offset) const
+	{
+		return flat_soa_map_iterator(_Mykey - offset, _Myvalue - offset);
+	}
+
+	_MST_NODISCARD inline ptrdiff_t operator-(const flat_soa_map_iterator& other) const
+	{
+		return _Mykey - other._Mykey;
+	}
+
+	_MST_NODISCARD inline bool operator==(const flat_soa_map_iterator& other) const
+	{
+		return _Mykey == other._Mykey;
+	}
+
+	_MST_NODISCARD inline bool operator!=(const flat_soa_map_iterator& other) const
+	{
+		return _Mykey != other._Mykey;
+	}
+
+	_MST_NODISCARD inline bool operator<(const flat_soa_map_iterator& other) const
+	{
+		return _Mykey < other._Mykey;
+	}
+
+	_MST_NODISCARD inline bool operator<=(const flat_soa_map_iterator& other) const
+	{
+		return _Mykey <= other._Mykey;
+	}
+
+	_MST_NODISCARD inline bool operator>(const flat_soa_map_iterator& other) const
+	{
+		return _Mykey > other._Mykey;
+	}
+
+	_MST_NODISCARD inline bool operator>=(const flat_soa_map_iterator& other) const
+	{
+		return _Mykey >= other._Mykey;
+	}
+
+private:
+	template<typename, typename>
+	friend class flat_soa_map_iterator;
+
+	template<typename, typename, typename>
+	friend class flat_soa_map;
+
+	const KeyType* _Mykey;
+	ValueType* _Myvalue;
+};
+
+// A sorted map like array_map, that keeps its keys and values in two parallel arrays. Lookups
+// only touch the key array, so a binary search doesn't drag large values through the cache.
+// Iterators yield pair<const KeyType&, ValueType&> proxies instead of pair references.
+template<typename KeyType, typename ValueType, typename ComparisonType = ::std::less<KeyType>>
+class flat_soa_map
+{
+	// the values live in a ::std::vector, whose bool specialization has no data() to iterate
+	static_assert(!::std::is_same<::std::remove_cv_t<ValueType>, bool>::value,
+		"flat_soa_map doesn't support bool values, use a byte sized type like uint8_t instead");
+
+public:
+	typedef ::std::pair<const KeyType, ValueType> value_type;
+	typedef KeyType key_type;
+	typedef ValueType mapped_type;
+	typedef flat_soa_map_iterator<KeyType, ValueType> iterator;
+	typedef flat_soa_map_iterator<KeyType, const ValueType> const_iterator;
+	typedef typename iterator::reference reference;
+	typedef typename const_iterator::reference const_reference;
+
+	inline flat_soa_map()
+		: _Mykeys()
+		, _Myvalues()
+	{ }
+
+	inline flat_soa_map(const flat_soa_map& other)
+		: _Mykeys(ComparisonType(), other._Get_keys())
+		, _Myvalues(other._Myvalues)
+	{ }
+
+	inline flat_soa_map(flat_soa_map&& other)
+		: _Mykeys(ComparisonType(), ::std::move(other._Get_keys()))
+		, _Myvalues(::std::move(other._Myvalues))
+	{ }
+
+	inline flat_soa_map& operator=(const flat_soa_map& other)
+	{
+		_Get_keys() = other._Get_keys();
+		_Myvalues = other._Myvalues;
+		return *this;
+	}
+
+	inline flat_soa_map& operator=(flat_soa_map&& other)
+	{
+		_Get_keys() = ::std::move(other._Get_keys());
+		_Myvalues = ::std::move(other._Myvalues);
+		return *this;
+	}
+
+	inline flat_soa_map(std::initializer_list<value_type> initList)
+		: _Mykeys()
+		, _Myvalues()
+	{
+		insert(initList.begin(), initList.end());
+	}
+
+	// Takes unsorted pairs, sorting them and dropping duplicate keys once. Of duplicate keys, the
+	// first one is kept, as if the pairs were inserted in order.
+	inline explicit flat_soa_map(::std::vector<::std::pair<KeyType, ValueType>> unsortedPairs)
+		: _Mykeys()
+		, _Myvalues()
+	{
+		_Sort_unique(unsortedPairs);
+		_Merge(unsortedPairs);
+	}
+
+	_MST_NODISCARD inline size_t capacity() const
+	{
+		return _Get_keys().capacity();
+	}
+
+	_MST_NODISCARD inline size_t size() const
+	{
+		return _Get_keys().size();
+	}
+
+	_MST_NODISCARD inline bool empty() const
+	{
+		return _Get_keys().empty();
+	}
+
+	inline iterator begin()
+	{
+		return iterator(_Get_keys().data(), _Myvalues.data());
+	}
+
+	inline const_iterator begin() const
+	{
+		return const_iterator(_Get_keys().data(), _Myvalues.data());
+	}
+
+	inline const_iterator cbegin() const
+	{
+		return begin();
+	}
+
+	inline iterator end()
+	{
+		return begin() + (ptrdiff_t)size();
+	}
+
+	inline const_iterator end() const
+	{
+		return begin() + (ptrdiff_t)size();
+	}
+
+	inline const_iterator cend() const
+	{
+		return end();
+	}
+
+	// the sorted keys, parallel to values()
+	_MST_NODISCARD inline const ::std::vector<KeyType>& keys() const
+	{
+		return _Get_keys();
+	}
+
+	_MST_NODISCARD inline const ::std::vector<ValueType>& values() const
+	{
+		return _Myvalues;
+	}
+
+	inline size_t count(const key_type& key) const
+	{
+		// map is singular, so guaranteed 1
+		return contains(key) ? 1 : 0;
+	}
+
+	inline void reserve(size_t _Count)
+	{
+		_Get_keys().reserve(_Count);
+		_Myvalues.reserve(_Count);
+	}
+
+	inline void clear()
+	{
+		_Get_keys().clear();
+		_Myvalues.clear();
+	}
+
+	inline void shrink_to_fit()
+	{
+		_Get_keys().shrink_to_fit();
+		_Myvalues.shrink_to_fit();
+	}
+
+	inline mapped_type& at(const key_type& key)
+	{
+		const size_t index = _Find(key);
+		if(index == size())
+		{
+			MST_FATAL_ERROR("key not found");
+		}
+
+		return _Myvalues[index];
+	}
+
+	inline const mapped_type& at(const key_type& key) const
+	{
+		const size_t index = _Find(key);
+		if(index == size())
+		{
+			throw std::out_of_range("key not found");
+		}
+
+		return _Myvalues[index];
+	}
+
+	inline iterator find(const key_type& key)
+	{
+		return begin() + (ptrdiff_t)_Find(key);
+	}
+
+	inline const_iterator find(const key_type& key) const
+	{
+		return begin() + (ptrdiff_t)_Find(key);
+	}
+
+	inline mapped_type& operator[](const key_type& key)
+	{
+		const size_t index = _Lower_bound(key);
+		if(index == size() || _Get_comp()(key, _Get_keys()[index]))
+		{
+			_Insert_at(index, key, mapped_type());
+		}
+
+		return _Myvalues[index];
+	}
+
+	_MST_NODISCARD inline bool contains(const key_type& key) const
+	{
+		return _Find(key) != size();
+	}
+
+	inline const key_type& get_key(size_t index) const
+	{
+		return _Get_keys()[index];
+	}
+
+	// Inserts the pair, unless its key is already in the map
+	template<typename PairType>
+	inline void insert(PairType&& keyValueTypePair)
+	{
+		const size_t index = _Lower_bound(keyValueTypePair.first);
+		if(index == size() || _Get_comp()(keyValueTypePair.first, _Get_keys()[index]))
+		{
+			_Insert_at(index, ::std::forward<PairType>(keyValueTypePair).first,
+				::std::forward<PairType>(keyValueTypePair).second);
+		}
+	}
+
+	// Inserts the pairs of [first, last) with a single merge, see array_map::insert(first, last)
+	template<typename InputIt>
+	inline void insert(InputIt first, InputIt last)
+	{
+		::std::vector<::std::pair<KeyType, ValueType>> pairs(first, last);
+		_Sort_unique(pairs);
+		_Merge(pairs);
+	}
+
+	// Like insert(first, last), for a range that is already sorted and has unique keys
+	template<typename InputIt>
+	inline void insert_sorted_unique(InputIt first, InputIt last)
+	{
+		::std::vector<::std::pair<KeyType, ValueType>> pairs(first, last);
+
+		MST_ASSERT(::std::adjacent_find(pairs.begin(), pairs.end(),
+					   [&](const auto& left, const auto& right) {
+						   return !_Get_comp()(left.first, right.first);
+					   }) == pairs.end(),
+			"range is not sorted or has duplicate keys");
+
+		_Merge(pairs);
+	}
+
+	inline void erase(const key_type& key)
+	{
+		MST_ASSERT(!empty(), "cannot call erase on empty container");
+
+		const size_t index = _Find(key);
+
+		MST_ASSERT(index != size(), "key is not found");
+
+		erase(begin() + (ptrdiff_t)index);
+	}
+
+	inline iterator erase(iterator iter)
+	{
+		MST_ASSERT(!empty(), "cannot call erase on empty container");
+		MST_ASSERT((iter >= begin() && iter < end()), "iterator out of range");
+
+		const auto offset = iter - begin();
+		_Get_keys().erase(_Get_keys().begin() + offset);
+		_Myvalues.erase(_Myvalues.begin() + offset);
+
+		return begin() + offset;
+	}
+
+	iterator lower_bound(const key_type& key)
+	{
+		return begin() + (ptrdiff_t)_Lower_bound(key);
+	}
+
+	const_iterator lower_bound(const key_type& key) const
+	{
+		return begin() + (ptrdiff_t)_Lower_bound(key);
+	}
+
+	iterator upper_bound(const key_type& key)
+	{
+		return begin() + (ptrdiff_t)_Upper_bound(key);
+	}
+
+	const_iterator upper_bound(const key_type& key) const
+	{
+		return begin() + (ptrdiff_t)_Upper_bound(key);
+	}
+
+private:
+	inline const ComparisonType& _Get_comp() const
+	{
+		return _Mykeys._Get_first();
+	}
+
+	inline ::std::vector<KeyType>& _Get_keys()
+	{
+		return _Mykeys._Get_second();
+	}
+
+	inline const ::std::vector<KeyType>& _Get_keys() const
+	{
+		return _Mykeys._Get_second();
+	}
+
+	// the index of key, or size() when it's not in the map
+	inline size_t _Find(const key_type& key) const
+	{
+		const size_t index = _Lower_bound(key);
+		if(index == size() || _Get_comp()(key, _Get_keys()[index]))
+		{
+			return size();
+		}
+
+		return index;
+	}
+
+	inline size_t _Lower_bound(const key_type& key) const
+	{
+		const auto& keys = _Get_keys();
+		return (size_t)(::std::lower_bound(keys.begin(), keys.end(), key, _Get_comp()) -
+						keys.begin());
+	}
+
+	inline size_t _Upper_bound(const key_type& key) const
+	{
+		const auto& keys = _Get_keys();
+		return (size_t)(::std::upper_bound(keys.begin(), keys.end(), key, _Get_comp()) -
+						keys.begin());
+	}
+
+	// inserts the value before the key, and takes it out again when the key throws,
+	// so the two arrays never get out of step
+	template<typename KeyArg, typename ValueArg>
+	inline void _Insert_at(size_t index, KeyArg&& key, ValueArg&& value)
+	{
+		_Myvalues.insert(_Myvalues.begin() + (ptrdiff_t)index, ::std::forward<ValueArg>(value));
+#if _MST_HAS_EXCEPTIONS
+		try
+#endif
+		{
+			_Get_keys().insert(_Get_keys().begin() + (ptrdiff_t)index, ::std::forward<KeyArg>(key));
+		}
+#if _MST_HAS_EXCEPTIONS
+		catch(...)
+		{
+			_Myvalues.erase(_Myvalues.begin() + (ptrdiff_t)index);
+			throw;
+		}
+#endif
+	}
+
+	// sorts pairs by key, keeping the first of equal keys
+	inline void _Sort_unique(::std::vector<::std::pair<KeyType, ValueType>>& pairs) const
+	{
+		const auto keyLess = [&](const auto& left, const auto& right) {
+			return _Get_comp()(left.first, right.first);
+		};
+
+		::std::stable_sort(pairs.begin(), pairs.end(), keyLess);
+		pairs.erase(::std::unique(pairs.begin(), pairs.end(),
+						[&](const auto& left, const auto& right) { return !keyLess(left, right); }),
+			pairs.end());
+	}
+
+	// merges the sorted, unique pairs into the map, where the keys already in the map win
+	inline void _Merge(::std::vector<::std::pair<KeyType, ValueType>>& pairs)
+	{
+		auto& keys = _Get_keys();
+
+		// appending keys past the current last key needs no merge
+		if(keys.empty() || pairs.empty() || _Get_comp()(keys.back(), pairs.front().first))
+		{
+			reserve(size() + pairs.size());
+			for(auto& pair : pairs)
+			{
+				keys.push_back(::std::move(pair.first));
+				_Myvalues.push_back(::std::move(pair.second));
+			}
+			return;
+		}
+
+		::std::vector<KeyType> newKeys;
+		::std::vector<ValueType> newValues;
+		newKeys.reserve(size() + pairs.size());
+		newValues.reserve(size() + pairs.size());
+
+		size_t index = 0;
+		for(auto& pair : pairs)
+		{
+			for(; index < keys.size() && !_Get_comp()(pair.first, keys[index]); ++index)
+			{
+				newKeys.push_back(::std::move(keys[index]));
+				newValues.push_back(::std::move(_Myvalues[index]));
+			}
+
+			if(!newKeys.empty() && !_Get_comp()(newKeys.back(), pair.first))
+			{
+				continue;
+			}
+
+			newKeys.push_back(::std::move(pair.first));
+			newValues.push_back(::std::move(pair.second));
+		}
+		for(; index < keys.size(); ++index)
+		{
+			newKeys.push_back(::std::move(keys[index]));
+			newValues.push_back(::std::move(_Myvalues[index]));
+		}
+
+		keys = ::std::move(newKeys);
+		_Myvalues = ::std::move(newValues);
+	}
+
+	::mst::_Details::_Packed_pair<ComparisonType, ::std::vector<KeyType>> _Mykeys;
+	::std::vector<ValueType> _Myvalues;
+
+}; // class flat_soa_map<KeyType, ValueType, ComparisonType>
+
+} // namespace mst
@@ -0,0 +1,314 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//      MST Utility Library                                                                 //
+//      Copyright (c)2026 Martinus Terpstra                                                 //
+//                                                                                          //
+//      Permission is hereby granted, free of charge, to any person obtaining a copy        //
+//      of this software and associated documentation files (the "Software"), to deal       //
+//      in the Software without restriction, including without limitation the rights        //
+//      to use, copy, modify, merge, publish, distribute, sublicense, and/or sell           //
+//      copies of the Software, and to permit persons to whom the Software is               //
+//      furnished to do so, subject to the following conditions:                            //
+//                                                                                          //
+//      The above copyright notice and this permission notice shall be included in          //
+//      all copies or substantial portions of the Software.                                 //
+//                                                                                          //
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR          //
+//      IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,            //
+//      FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE         //
+//      AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER              //
+//      LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,       //
+//      OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN           //
+//      THE SOFTWARE.                                                                       //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <mstride_map.h>
+#include <mx_platform.h>
+#include <utility>
+
+namespace mst {
+
+enum class map_mode
+{
+	// the records can only be read, writing through them is an access violation
+	read_only,
+
+	// the records can be written, changes stay private to the process and never reach the file
+	copy_on_write,
+};
+
+enum class map_access_hint : uint32_t
+{
+	normal,
+
+	// records will be read front to back, the OS reads ahead aggressively
+	sequential,
+
+	// records will be read in no particular order, the OS does not read ahead
+	random,
+
+	// all records will be needed soon, the OS starts reading them in right away
+	will_need,
+};
+
+// A file of fixed-size records, mapped into memory instead of read. Opening is constant time:
+// pages are loaded from the file (or the page cache) the first time they are touched. Trailing
+// bytes that don't make up a full record are not part of the map. The non-const accessors
+// are only writable in map_mode::copy_on_write; writing a read_only map faults.
+class mapped_stride_map
+{
+public:
+	mapped_stride_map() noexcept
+		: _MyBegin(nullptr)
+		, _MyEnd(nullptr)
+		, _MyMappedSize(0)
+		, _MyStride(0)
+		, _MyMode(map_mode::read_only)
+		, _MyOpen(false)
+	{ }
+
+	mapped_stride_map(const char* _Path, size_t _Stride, map_mode _Mode = map_mode::read_only,
+		map_access_hint _Hint = map_access_hint::normal) noexcept
+		: mapped_stride_map()
+	{
+		open(_Path, _Stride, _Mode, _Hint);
+	}
+
+	mapped_stride_map(mapped_stride_map&& _Other) noexcept
+		: _MyBegin(_Other._MyBegin)
+		, _MyEnd(_Other._MyEnd)
+		, _MyMappedSize(_Other._MyMappedSize)
+		, _MyStride(_Other._MyStride)
+		, _MyMode(_Other._MyMode)
+		, _MyOpen(_Other._MyOpen)
+	{
+		_Other._release();
+	}
+
+	mapped_stride_map(const mapped_stride_map&) = delete;
+	mapped_stride_map& operator=(const mapped_stride_map&) = delete;
+
+	~mapped_stride_map()
+	{
+		close();
+	}
+
+	inline mapped_stride_map& operator=(mapped_stride_map&& _Other) noexcept
+	{
+		if(this != &_Other)
+		{
+			close();
+
+			_MyBegin = _Other._MyBegin;
+			_MyEnd = _Other._MyEnd;
+			_MyMappedSize = _Other._MyMappedSize;
+			_MyStride = _Other._MyStride;
+			_MyMode = _Other._MyMode;
+			_MyOpen = _Other._MyOpen;
+
+			_Other._release();
+		}
+		return *this;
+	}
+
+	// maps the file at _Path, closing the current one first; returns false when the file can't
+	// be opened or mapped, which leaves the map closed
+	inline bool open(const char* _Path, size_t _Stride, map_mode _Mode = map_mode::read_only,
+		map_access_hint _Hint = map_access_hint::normal) noexcept
+	{
+		MST_ASSERT(_Stride != 0, "invalid stride");
+
+		close();
+
+		void* _Data;
+		size_t _Size;
+		if(!::mst::_Details::map_file_impl(
+			   _Path, _Mode == map_mode::copy_on_write, &_Data, &_Size))
+		{
+			return false;
+		}
+
+		_MyBegin = (char*)_Data;
+		_MyEnd = _MyBegin + (_Size / _Stride) * _Stride;
+		_MyMappedSize = _Size;
+		_MyStride = _Stride;
+		_MyMode = _Mode;
+		_MyOpen = true;
+
+		if(_Hint != map_access_hint::normal)
+		{
+			advise(_Hint);
+		}
+		return true;
+	}
+
+	inline void close() noexcept
+	{
+		if(_MyBegin)
+		{
+			::mst::_Details::unmap_file_impl(_MyBegin, _MyMappedSize);
+		}
+		_release();
+	}
+
+	inline bool is_open() const noexcept
+	{
+		return _MyOpen;
+	}
+
+	// tells the OS how the records are about to be read
+	inline void advise(map_access_hint _Hint) noexcept
+	{
+		if(_MyBegin)
+		{
+			::mst::_Details::advise_mapped_impl(_MyBegin, _MyMappedSize, (uint32_t)_Hint);
+		}
+	}
+
+	inline map_mode mode() const noexcept
+	{
+		return _MyMode;
+	}
+
+	inline bool writable() const noexcept
+	{
+		return _MyMode == map_mode::copy_on_write;
+	}
+
+	inline size_t size() const
+	{
+		return _MyStride == 0 ? 0 : (size_t)(_MyEnd - _MyBegin) / _MyStride;
+	}
+
+	inline bool empty() const
+	{
+		return _MyBegin == _MyEnd;
+	}
+
+	inline size_t stride() const
+	{
+		return _MyStride;
+	}
+
+	inline const void* data() const
+	{
+		return _MyBegin;
+	}
+
+	inline void* data()
+	{
+		return _MyBegin;
+	}
+
+	inline size_t data_size() const
+	{
+		return (size_t)(_MyEnd - _MyBegin);
+	}
+
+	template<typename T>
+	inline const T& index(size_t _Idx) const
+	{
+		MST_ASSERT(_Idx < size(), "index out of range");
+		return *(const T*)(_MyBegin + _Idx * _MyStride);
+	}
+
+	template<typename T>
+	inline T& index(size_t _Idx)
+	{
+		MST_ASSERT(_Idx < size(), "index out of range");
+		return *(T*)(_MyBegin + _Idx * _MyStride);
+	}
+
+	template<typename T>
+	inline stride_map_iterator<const T> begin() const
+	{
+		return stride_map_iterator<const T>(_MyBegin, _MyStride);
+	}
+
+	template<typename T>
+	inline stride_map_iterator<const T> end() const
+	{
+		return stride_map_iterator<const T>(_MyEnd, _MyStride);
+	}
+
+	template<typename T>
+	inline stride_map_iterator<T> begin()
+	{
+		return stride_map_iterator<T>(_MyBegin, _MyStride);
+	}
+
+	template<typename T>
+	inline stride_map_iterator<T> end()
+	{
+		return stride_map_iterator<T>(_MyEnd, _MyStride);
+	}
+
+	template<typename T>
+	inline stride_map_iterator<const T> cbegin() const
+	{
+		return begin<T>();
+	}
+
+	template<typename T>
+	inline stride_map_iterator<const T> cend() const
+	{
+		return end<T>();
+	}
+
+	// a view of the T stored _Offset bytes into every record
+	template<typename T>
+	inline stride_map_column<const T> column(size_t _Offset) const
+	{
+		MST_ASSERT(_Offset + sizeof(T) <= _MyStride, "column does not fit inside the stride");
+		return stride_map_column<const T>(_MyBegin + _Offset, _MyStride, size());
+	}
+
+	// copies the T stored _Offset bytes into every record to _Out, which holds size() elements
+	template<typename T>
+	inline void gather(size_t _Offset, T* _Out) const
+	{
+		static_assert(::std::is_trivially_copyable<T>::value, "T is not trivially copyable");
+		MST_ASSERT(_Offset + sizeof(T) <= _MyStride, "column does not fit inside the stride");
+
+		_Details::_Strided_gather(_MyBegin + _Offset, _MyStride, sizeof(T), size(), (char*)_Out);
+	}
+
+	// copies every record into a regular, growable stride_map
+	_MST_NODISCARD inline stride_map to_stride_map() const
+	{
+		stride_map _Result(_MyStride == 0 ? 1 : _MyStride, size());
+		if(!empty())
+		{
+			memcpy(_Result.data(), _MyBegin, data_size());
+		}
+		return _Result;
+	}
+
+private:
+	inline void _release() noexcept
+	{
+		_MyBegin = _MyEnd = nullptr;
+		_MyMappedSize = 0;
+		_MyOpen = false;
+	}
+
+	char* _MyBegin;
+	char* _MyEnd;
+	size_t _MyMappedSize;
+	size_t _MyStride;
+	map_mode _MyMode;
+	bool _MyOpen;
+
+}; // class mapped_stride_map
+
+template<typename T>
+iterator_range<stride_map_iterator<const T>> range(const mapped_stride_map& mappedMap)
+{
+	return iterator_range<stride_map_iterator<const T>>(
+		mappedMap.begin<T>(), mappedMap.end<T>());
+}
+
+} // namespace mst
@@ -0,0 +1,449 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//      MST Utility Library                                                                 //
+//      Copyright (c)2026 Martinus Terpstra                                                 //
+//                                                                                          //
+//      Permission is hereby granted, free of charge, to any person obtaining a copy        //
+//      of this software and associated documentation files (the "Software"), to deal       //
+//      in the Software without restriction, including without limitation the rights        //
+//      to use, copy, modify, merge, publish, distribute, sublicense, and/or sell           //
+//      copies of the Software, and to permit persons to whom the Software is               //
+//      furnished to do so, subject to the following conditions:                            //
+//                                                                                          //
+//      The above copyright notice and this permission notice shall be included in          //
+//      all copies or substantial portions of the Software.                                 //
+//                                                                                          //
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR          //
+//      IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,            //
+//      FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE         //
+//      AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER              //
+//      LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,       //
+//      OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN           //
+//      THE SOFTWARE.                                                                       //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <mcolony.h>
+#include <maligned_malloc.h>
+#include <tuple>
+#include <new>
+
+namespace mst {
+
+// A colony that stores every field in its own array per page: page i holds ElementsPerPage
+// values of every field, each array starting on a cache line. The pages use the same skip field
+// and free list as colony, so indices are stable and erased slots are reused. foreach_run()
+// passes the fields of every contiguous run of live elements as plain arrays, so an update that
+// only touches a few fields only loads those, and can be vectorized over the run.
+template<int32_t ElementsPerPage, typename... Fields>
+class basic_soa_colony
+{
+	static_assert(ElementsPerPage > 0 && (ElementsPerPage & (ElementsPerPage - 1)) == 0,
+		"ElementsPerPage must be a power of two");
+	static_assert(sizeof...(Fields) > 0, "basic_soa_colony needs at least one field");
+
+	typedef _Details::colony_free_list_node FreeListNode;
+
+	struct PageType : _Details::colony_page_header
+	{
+		// the field arrays, each on a ColumnAlignment boundary
+		void* columns;
+		// the free list is kept out of the field arrays, which hold live elements only
+		FreeListNode* nodes;
+	};
+
+	// gives the free list access to the pages
+	struct PageLayout
+	{
+		const basic_soa_colony* self;
+
+		_MST_NODISCARD inline _Details::colony_page_header& page(int32_t pageIndex) const noexcept
+		{
+			return self->m_pages[pageIndex];
+		}
+
+		_MST_NODISCARD inline FreeListNode* node(int32_t index) const noexcept
+		{
+			return &self->m_pages[index >> _MST_GET_SHIFT(ElementsPerPage)]
+						.nodes[index & (ElementsPerPage - 1)];
+		}
+	};
+
+	typedef _Details::colony_free_list<ElementsPerPage, PageLayout> FreeList;
+
+	static constexpr size_t ColumnAlignment = 64;
+
+	static constexpr size_t column_offset(size_t fieldIndex) noexcept
+	{
+		constexpr size_t sizes[] = { sizeof(Fields)... };
+
+		size_t offset = 0;
+		for(size_t i = 0; i < fieldIndex; ++i)
+		{
+			offset += (sizes[i] * ElementsPerPage + ColumnAlignment - 1) & ~(ColumnAlignment - 1);
+		}
+		return offset;
+	}
+
+	static_assert(std::max({ alignof(Fields)... }) <= ColumnAlignment,
+		"basic_soa_colony doesn't support fields with an alignment over 64");
+
+	template<size_t I>
+	using field_type = typename std::tuple_element<I, std::tuple<Fields...>>::type;
+
+public:
+	inline basic_soa_colony() noexcept
+		: m_pages(nullptr)
+		, m_pageCount(0)
+		, m_pageCapacity(0)
+		, m_elementCount(0)
+		, m_capacity(0)
+		, m_freeListHead(-1)
+	{ }
+
+	basic_soa_colony(const basic_soa_colony&) = delete;
+	basic_soa_colony& operator=(const basic_soa_colony&) = delete;
+
+	inline ~basic_soa_colony()
+	{
+		destroy_elements();
+
+		for(int32_t pageIndex = 0; pageIndex < m_pageCount; ++pageIndex)
+		{
+			auto& page = m_pages[pageIndex];
+
+			aligned_free(page.columns);
+			delete[] page.skips;
+			delete[] page.nodes;
+		}
+
+		delete[] m_pages;
+	}
+
+	// Constructs every field from the matching argument, returns the index of the element
+	template<typename... Args>
+	inline int32_t emplace(Args&&... args)
+	{
+		static_assert(sizeof...(Args) == sizeof...(Fields), "one argument per field expected");
+
+		if(m_freeListHead == -1) // _MST_UNLIKELY
+		{
+			add_page();
+		}
+
+		// the free list nodes live apart from the columns, so the fields are built in the head
+		// slot first and the slot only becomes live once they all exist
+		const auto newIndex = m_freeListHead;
+
+		construct_fields(
+			newIndex, std::index_sequence_for<Fields...>{}, std::forward<Args>(args)...);
+
+		(void)free_list().pop();
+		++m_elementCount;
+
+		return newIndex;
+	}
+
+	// Returns the index of the next element, or capacity()
+	inline int32_t erase(int32_t index) noexcept
+	{
+		MST_ASSERT(index >= 0, "index out of range");
+		MST_ASSERT(index < m_capacity, "index out of range");
+		MST_ASSERT(get_skip(index) == 0, "index invalid");
+
+		destroy_fields(index, std::index_sequence_for<Fields...>{});
+
+		--m_elementCount;
+		return skip_forward(free_list().push(index));
+	}
+
+	template<size_t I>
+	_MST_NODISCARD inline field_type<I>& get(int32_t index) noexcept
+	{
+		MST_ASSERT(index >= 0, "index out of range");
+		MST_ASSERT(index < m_capacity, "index out of range");
+		MST_ASSERT(get_skip(index) == 0, "index invalid");
+
+		return column<I>(m_pages[index >> _MST_GET_SHIFT(ElementsPerPage)])
+			[index & (ElementsPerPage - 1)];
+	}
+
+	template<size_t I>
+	_MST_NODISCARD inline const field_type<I>& get(int32_t index) const noexcept
+	{
+		MST_ASSERT(index >= 0, "index out of range");
+		MST_ASSERT(index < m_capacity, "index out of range");
+		MST_ASSERT(get_skip(index) == 0, "index invalid");
+
+		return column<I>(m_pages[index >> _MST_GET_SHIFT(ElementsPerPage)])
+			[index & (ElementsPerPage - 1)];
+	}
+
+	// Calls func(Fields&...) for every element
+	template<typename Fn>
+	inline void foreach(Fn func)
+	{
+		foreach_run([&](int32_t, int32_t count, Fields*... fields) {
+			for(int32_t i = 0; i < count; ++i)
+			{
+#if _MST_HAS_INVOKE
+				std::invoke(func, fields[i]...);
+#else
+				func(fields[i]...);
+#endif
+			}
+		});
+	}
+
+	template<typename Fn>
+	inline void foreach(Fn func) const
+	{
+		foreach_run([&](int32_t, int32_t count, const Fields*... fields) {
+			for(int32_t i = 0; i < count; ++i)
+			{
+#if _MST_HAS_INVOKE
+				std::invoke(func, fields[i]...);
+#else
+				func(fields[i]...);
+#endif
+			}
+		});
+	}
+
+	// Calls func(firstIndex, count, Fields*...) for every run of live elements, the pointers
+	// point at the first element of the run in each field array. A run never crosses a page.
+	template<typename Fn>
+	inline void foreach_run(Fn func)
+	{
+		foreach_run_impl(func, std::index_sequence_for<Fields...>{});
+	}
+
+	template<typename Fn>
+	inline void foreach_run(Fn func) const
+	{
+		auto constFunc = [&](int32_t firstIndex, int32_t count, Fields*... fields) {
+#if _MST_HAS_INVOKE
+			std::invoke(func, firstIndex, count, static_cast<const Fields*>(fields)...);
+#else
+			func(firstIndex, count, static_cast<const Fields*>(fields)...);
+#endif
+		};
+
+		foreach_run_impl(constFunc, std::index_sequence_for<Fields...>{});
+	}
+
+	inline void clear() noexcept
+	{
+		destroy_elements();
+
+		m_elementCount = 0;
+		m_freeListHead = -1;
+
+		// link the pages in order of their index, so they are filled front to back again
+		int32_t freeListPrev = -1;
+		for(int32_t pageIndex = 0; pageIndex < m_pageCount; ++pageIndex)
+		{
+			freeListPrev = free_list().reset_page(pageIndex, freeListPrev);
+		}
+	}
+
+	_MST_NODISCARD inline bool empty() const noexcept
+	{
+		return m_elementCount == 0;
+	}
+
+	_MST_NODISCARD inline size_t size() const noexcept
+	{
+		return static_cast<size_t>(m_elementCount);
+	}
+
+	_MST_NODISCARD inline size_t capacity() const noexcept
+	{
+		return static_cast<size_t>(m_capacity);
+	}
+
+private:
+	template<size_t I>
+	_MST_NODISCARD static inline field_type<I>* column(const PageType& page) noexcept
+	{
+		return reinterpret_cast<field_type<I>*>(
+			static_cast<char*>(page.columns) + column_offset(I));
+	}
+
+	template<typename... Args, size_t... I>
+	inline void construct_fields(int32_t index, std::index_sequence<I...>, Args&&... args)
+	{
+		const auto& page = m_pages[index >> _MST_GET_SHIFT(ElementsPerPage)];
+		const auto elemIndex = index & (ElementsPerPage - 1);
+
+		size_t constructed = 0;
+
+#if _MST_HAS_EXCEPTIONS
+		try
+#endif
+		{
+			((new(column<I>(page) + elemIndex) field_type<I>(std::forward<Args>(args)),
+				 ++constructed),
+				...);
+		}
+#if _MST_HAS_EXCEPTIONS
+		catch(...)
+		{
+			// the fields built before the one that threw
+			((I < constructed ? ::mst::_Details::_Destroy_object(column<I>(page) + elemIndex)
+							  : void()),
+				...);
+			throw;
+		}
+#endif
+	}
+
+	template<size_t... I>
+	inline void destroy_fields(int32_t index, std::index_sequence<I...>) noexcept
+	{
+		const auto& page = m_pages[index >> _MST_GET_SHIFT(ElementsPerPage)];
+		const auto elemIndex = index & (ElementsPerPage - 1);
+
+		(::mst::_Details::_Destroy_object(column<I>(page) + elemIndex), ...);
+	}
+
+	template<typename Fn, size_t... I>
+	inline void foreach_run_impl(Fn& func, std::index_sequence<I...>) const
+	{
+		for(int32_t pageIndex = 0; pageIndex < m_pageCount; ++pageIndex)
+		{
+			const auto& page = m_pages[pageIndex];
+			const auto pageStart = pageIndex << _MST_GET_SHIFT(ElementsPerPage);
+
+			int32_t elemIndex = 0;
+			while(elemIndex != ElementsPerPage)
+			{
+				const auto skip = page.skips[elemIndex];
+				if(skip != 0)
+				{
+					elemIndex += skip;
+					continue;
+				}
+
+				auto runEnd = elemIndex + 1;
+				if(page.size == ElementsPerPage)
+				{
+					runEnd = ElementsPerPage;
+				}
+				else
+				{
+					while(runEnd != ElementsPerPage && page.skips[runEnd] == 0)
+					{
+						++runEnd;
+					}
+				}
+
+#if _MST_HAS_INVOKE
+				std::invoke(func, pageStart + elemIndex, runEnd - elemIndex,
+					(column<I>(page) + elemIndex)...);
+#else
+				func(pageStart + elemIndex, runEnd - elemIndex, (column<I>(page) + elemIndex)...);
+#endif
+
+				elemIndex = runEnd;
+			}
+		}
+	}
+
+	inline void destroy_elements() noexcept
+	{
+		if(std::conjunction<std::is_trivially_destructible<Fields>...>::value)
+		{
+			return;
+		}
+
+		foreach_run([this](int32_t firstIndex, int32_t count, Fields*...) {
+			for(int32_t i = 0; i < count; ++i)
+			{
+				destroy_fields(firstIndex + i, std::index_sequence_for<Fields...>{});
+			}
+		});
+	}
+
+	inline void add_page()
+	{
+		if(m_pageCount == m_pageCapacity) // [[unlikely]]
+		{
+			const auto pageCapacity = m_pageCapacity == 0 ? 4 : m_pageCapacity * 2;
+			const auto newPages = new PageType[(size_t)pageCapacity];
+
+			for(int32_t i = 0; i < m_pageCount; ++i)
+			{
+				newPages[i] = m_pages[i];
+			}
+
+			delete[] m_pages;
+
+			m_pages = newPages;
+			m_pageCapacity = pageCapacity;
+		}
+
+		auto& page = m_pages[m_pageCount];
+
+		page.columns = aligned_malloc(column_offset(sizeof...(Fields)), ColumnAlignment);
+		if(!page.columns)
+		{
+#if _MST_HAS_EXCEPTIONS
+			throw std::bad_alloc();
+#else
+			::std::abort();
+#endif
+		}
+
+		page.skips = new int32_t[ElementsPerPage];
+		page.nodes = new FreeListNode[ElementsPerPage];
+
+		++m_pageCount;
+		m_capacity += ElementsPerPage;
+
+		// the new page goes at the front of the free list, which is empty here
+		free_list().reset_page(m_pageCount - 1);
+	}
+
+	_MST_NODISCARD inline FreeList free_list() noexcept
+	{
+		return FreeList(PageLayout{ this }, m_freeListHead);
+	}
+
+	// returns the first live index at or after index, index must be live or start a free block
+	_MST_NODISCARD inline int32_t skip_forward(int32_t index) const noexcept
+	{
+		while(index != m_capacity)
+		{
+			const auto skip = get_skip(index);
+			if(skip == 0)
+			{
+				return index;
+			}
+
+			index += skip;
+		}
+
+		return index;
+	}
+
+	_MST_NODISCARD inline int32_t& get_skip(int32_t index) const noexcept
+	{
+		return m_pages[index >> _MST_GET_SHIFT(ElementsPerPage)]
+			.skips[index & (ElementsPerPage - 1)];
+	}
+
+private:
+	PageType* m_pages;
+	int32_t m_pageCount, m_pageCapacity;
+	int32_t m_elementCount, m_capacity;
+	int32_t m_freeListHead;
+
+}; // class basic_soa_colony
+
+template<typename... Fields>
+using soa_colony = basic_soa_colony<MST_DEFAULT_COLONY_PAGE_SIZE, Fields...>;
+
+} // namespace mst
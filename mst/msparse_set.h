@@ -27,10 +27,18 @@
 #include <mcore.h>
 #include <mdebug.h>
 #include <mx_storage_pair.h>
+#include <marray_view.h>
+#include <mranges.h>
+#include <mscope_guard.h>
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <cstring>
 #include <tuple>
+#include <array>
+#include <utility>
+#include <type_traits>
 
 namespace mst {
 
@@ -40,128 +48,292 @@ class sparse_iterator;
 template<typename ElementType, typename IndexType>
 class const_sparse_iterator;
 
-template<typename ElementType, typename IndexType = size_t, size_t PageSize = 32768U>
+template<typename... Sets>
+class sparse_view;
+
+template<typename... Sets>
+class sparse_group;
+
+namespace _Details {
+
+// Notified of every structural change of the sparse_set it owns, see sparse_group
+template<typename IndexType>
+class sparse_set_owner
+{
+public:
+	virtual void on_emplace(IndexType index) = 0;
+	virtual void on_erase(IndexType index) = 0;
+	virtual void on_clear() = 0;
+
+protected:
+	~sparse_set_owner() = default;
+};
+
+} // namespace _Details
+
+// Splits an index into VersionBits high bits and the remaining low bits. The low bits select the
+// sparse entry, the version is stored in that entry. contains() then rejects an index with a
+// stale version using the same load. sparse_set_traits<> uses the whole index for paging.
+template<size_t VersionBits = 0>
+struct sparse_set_traits
+{
+	static constexpr size_t version_bits = VersionBits;
+};
+
+template<typename ElementType, typename IndexType = size_t, size_t PageSize = 32768U,
+	typename Traits = sparse_set_traits<>>
 class sparse_set
 {
 	friend class sparse_iterator<ElementType, IndexType>;
 	friend class const_sparse_iterator<ElementType, IndexType>;
 
+	template<typename... Sets>
+	friend class sparse_view;
+
+	template<typename... Sets>
+	friend class sparse_group;
+
 public:
 	typedef std::pair<const IndexType, ElementType> value_type;
+	typedef ElementType element_type;
+	typedef IndexType index_type;
 
 	typedef sparse_iterator<ElementType, IndexType> iterator;
 	typedef const_sparse_iterator<ElementType, IndexType> const_iterator;
 
+	// the number of emptied pages kept for reuse, instead of freeing them
+	static constexpr size_t PagePoolSize = 4;
+
+	static_assert(PageSize <= UINT32_MAX, "page occupancy is counted in 32 bits");
+	static_assert(Traits::version_bits == 0 || std::is_integral<IndexType>::value,
+		"versioned indices must be integers");
+	static_assert(Traits::version_bits < sizeof(IndexType) * 8, "no bits left for the index");
+
+	// the number of low index bits that select the sparse entry
+	static constexpr size_t IndexBits = sizeof(IndexType) * 8 - Traits::version_bits;
+
 	inline sparse_set() noexcept
 	{ }
 
 	inline ~sparse_set()
 	{
-		for(auto page : m_sparse)
-		{
-			delete[] page;
-		}
+		release_pages_impl();
 	}
 
 	inline sparse_set(const sparse_set& other)
 		: m_data(other.m_data)
 	{
-		const auto dataSize = m_data.size();
-		for(size_t i = 0; i < dataSize; ++i)
-		{
-			const auto index = m_data[i];
-
-			const size_t idx = static_cast<size_t>(index);
-			const size_t pageIdx = idx >> _MST_GET_SHIFT(PageSize);
-			const size_t elemIdx = idx & (PageSize - 1);
-
-			ensure_page(pageIdx)[elemIdx] = static_cast<IndexType>(i);
-		}
+		rebuild_sparse_impl();
 	}
 
 	inline sparse_set(sparse_set&& other)
 		: m_data(std::move(other.m_data))
 		, m_sparse(std::move(other.m_sparse))
-	{ }
+		, m_pageCounts(std::move(other.m_pageCounts))
+		, m_pagePool(std::move(other.m_pagePool))
+	{
+		MST_ASSERT(!other.m_owner, "a set owned by a sparse_group can't be moved");
+	}
 
 	inline sparse_set& operator=(const sparse_set& other)
 	{
+		assert_not_iterating_impl();
+		MST_ASSERT(!m_owner, "a set owned by a sparse_group can't be assigned to");
+
 		clear();
 
 		m_data = other.m_data;
-
-		const auto dataSize = m_data.size();
-		for(size_t i = 0; i < dataSize; ++i)
-		{
-			const auto index = m_data[i];
-
-			const size_t idx = static_cast<size_t>(index);
-			const size_t pageIdx = idx >> _MST_GET_SHIFT(PageSize);
-			const size_t elemIdx = idx & (PageSize - 1);
-
-			ensure_page(pageIdx)[elemIdx] = static_cast<IndexType>(i);
-		}
+		rebuild_sparse_impl();
 
 		return *this;
 	}
 
 	inline sparse_set& operator=(sparse_set&& other)
 	{
+		assert_not_iterating_impl();
+		MST_ASSERT(!m_owner && !other.m_owner, "a set owned by a sparse_group can't be moved");
+
 		m_data.swap(other.m_data);
 		m_sparse.swap(other.m_sparse);
+		m_pageCounts.swap(other.m_pageCounts);
+		m_pagePool.swap(other.m_pagePool);
 
 		return *this;
 	}
 
 	inline void reserve(IndexType count)
 	{
+		assert_not_iterating_impl();
+
 		m_data.reserve(static_cast<size_t>(count));
 	}
 
 	template<typename... Args>
 	inline value_type& emplace(IndexType index, Args&&... args)
 	{
-		MST_ASSERT(!contains(index), "index already exists in set");
+		assert_not_iterating_impl();
+		MST_ASSERT(find_index_impl(index, false) == static_cast<size_t>(-1),
+			"index already exists in set");
+		MST_ASSERT(m_data.size() < EntryPositionMask, "the set is full");
 
-		const size_t idx = static_cast<size_t>(index);
+		const size_t idx = entry_impl(index);
 		const size_t pageIdx = idx >> _MST_GET_SHIFT(PageSize);
 		const size_t elemIdx = idx & (PageSize - 1);
 
-		ensure_page(pageIdx)[elemIdx] = static_cast<IndexType>(m_data.size());
+		ensure_page(pageIdx)[elemIdx] = make_entry_impl(index, m_data.size());
+		++m_pageCounts[pageIdx];
 
 		m_data.emplace_back(std::piecewise_construct, std::forward_as_tuple(index),
 			std::forward_as_tuple(std::forward<Args>(args)...));
 
+		if(m_owner)
+		{
+			// may move the new element to the front
+			m_owner->on_emplace(index);
+			return m_data[get_index_impl(index)].get();
+		}
+
 		return m_data.back().get();
 	}
 
 	void erase(IndexType index) noexcept
 	{
+		assert_not_iterating_impl();
 		MST_ASSERT(contains(index), "erase() requires an existing index");
 
-		const size_t idx = static_cast<size_t>(index);
+		if(m_owner)
+			m_owner->on_erase(index);
+
+		const size_t idx = entry_impl(index);
 		const size_t pageIdx = idx >> _MST_GET_SHIFT(PageSize);
 		const size_t elemIdx = idx & (PageSize - 1);
 
-		const auto dataIndex = m_sparse[pageIdx][elemIdx];
+		const auto dataIndex = entry_position_impl(m_sparse[pageIdx][elemIdx]);
 		m_sparse[pageIdx][elemIdx] = -1;
 
-		if(static_cast<size_t>(dataIndex + 1) != m_data.size())
+		if(dataIndex + 1 != m_data.size())
 		{
-			const size_t lastIdx = static_cast<size_t>(m_data.back().get().first);
+			const auto lastIndex = m_data.back().get().first;
+			const size_t lastIdx = entry_impl(lastIndex);
 			const size_t lastPageIdx = lastIdx >> _MST_GET_SHIFT(PageSize);
 			const size_t lastElemIdx = lastIdx & (PageSize - 1);
 
-			m_sparse[lastPageIdx][lastElemIdx] = dataIndex;
-			m_data[static_cast<size_t>(dataIndex)] = m_data.back();
+			m_sparse[lastPageIdx][lastElemIdx] = make_entry_impl(lastIndex, dataIndex);
+			m_data[dataIndex] = m_data.back();
 		}
 
 		m_data.pop_back();
+
+		if(--m_pageCounts[pageIdx] == 0)
+			release_page_impl(pageIdx);
 	}
 
+	// Emplaces copies of values at indices, which must not be in the set yet. The sparse pages are
+	// written page by page, and each missing page is allocated once.
+	void emplace_batch(array_view<IndexType> indices, array_view<ElementType> values)
+	{
+		assert_not_iterating_impl();
+		MST_ASSERT(indices.size() == values.size(), "emplace_batch() needs a value per index");
+
+		const size_t count = indices.size();
+		if(count == 0)
+			return;
+
+		const size_t first = m_data.size();
+		MST_ASSERT(first + count <= EntryPositionMask, "the set is full");
+
+		m_data.reserve(first + count);
+		for(size_t i = 0; i < count; ++i)
+		{
+			m_data.emplace_back(std::piecewise_construct, std::forward_as_tuple(indices[i]),
+				std::forward_as_tuple(values[i]));
+		}
+
+		const auto order = sort_by_page_impl(indices);
+		for(const auto i : order)
+		{
+			const size_t idx = entry_impl(indices[i]);
+			const size_t pageIdx = idx >> _MST_GET_SHIFT(PageSize);
+			const size_t elemIdx = idx & (PageSize - 1);
+
+			auto& slot = ensure_page(pageIdx)[elemIdx];
+			MST_ASSERT(slot == static_cast<IndexType>(-1), "index already exists in set");
+
+			slot = make_entry_impl(indices[i], first + i);
+			++m_pageCounts[pageIdx];
+		}
+
+		if(m_owner)
+		{
+			for(size_t i = 0; i < count; ++i)
+				m_owner->on_emplace(indices[i]);
+		}
+	}
+
+	// Erases the elements at indices, which must all be in the set. The elements past the new
+	// size that survive are moved into the holes, like erase() does with the last element.
+	void erase_batch(array_view<IndexType> indices)
+	{
+		assert_not_iterating_impl();
+
+		if(m_owner)
+		{
+			// the group reorders the dense array on every erase
+			for(const auto index : indices)
+				erase(index);
+			return;
+		}
+
+		const size_t count = indices.size();
+		MST_ASSERT(count <= m_data.size(), "erase_batch() requires existing indices");
+
+		const size_t newSize = m_data.size() - count;
+		std::vector<size_t> holes;
+		std::vector<bool> erasedTail(count);
+
+		// ordering the erased indices by page doesn't pay off, the sparse reads are already
+		// independent, and only the pages of surviving elements are needed afterwards
+		for(const auto index : indices)
+		{
+			MST_ASSERT(contains(index), "erase_batch() requires existing indices");
+
+			const size_t idx = entry_impl(index);
+			const size_t pageIdx = idx >> _MST_GET_SHIFT(PageSize);
+			const size_t elemIdx = idx & (PageSize - 1);
+
+			const auto dataIndex = entry_position_impl(m_sparse[pageIdx][elemIdx]);
+			m_sparse[pageIdx][elemIdx] = -1;
+
+			if(--m_pageCounts[pageIdx] == 0)
+				release_page_impl(pageIdx);
+
+			if(dataIndex < newSize)
+				holes.push_back(dataIndex);
+			else
+				erasedTail[dataIndex - newSize] = true;
+		}
+
+		// fill the holes with the surviving elements past the new size
+		size_t tail = m_data.size();
+		for(const auto hole : holes)
+		{
+			do
+			{
+				--tail;
+			} while(erasedTail[tail - newSize]);
+
+			set_entry_impl(m_data[tail].get().first, hole);
+			m_data[hole] = std::move(m_data[tail]);
+		}
+
+		m_data.erase(m_data.begin() + newSize, m_data.end());
+	}
+
+	// Whether the set contains index. With versioned indices, an index whose version differs from
+	// the stored one is not contained.
 	[[nodiscard]] inline bool contains(IndexType index) const noexcept
 	{
-		const size_t idx = static_cast<size_t>(index);
+		const size_t idx = entry_impl(index);
 		const size_t pageIdx = idx >> _MST_GET_SHIFT(PageSize);
 
 		if(m_sparse.size() <= pageIdx)
@@ -172,7 +344,7 @@ public:
 
 		const size_t elemIdx = idx & (PageSize - 1);
 
-		return m_sparse[pageIdx][elemIdx] != static_cast<IndexType>(-1);
+		return entry_matches_impl(m_sparse[pageIdx][elemIdx], index);
 	}
 
 	[[nodiscard]] inline const ElementType& at(IndexType index) const noexcept
@@ -231,13 +403,123 @@ public:
 
 	void clear()
 	{
+		assert_not_iterating_impl();
+
+		if(m_owner)
+			m_owner->on_clear();
+
 		m_data.clear();
-		for(auto page : m_sparse)
+		release_pages_impl();
+
+		m_sparse.clear();
+		m_pageCounts.clear();
+		m_pagePool.clear();
+	}
+
+	// Sorts the dense array with comp(const value_type&, const value_type&), which changes the
+	// iteration order. Without a comparator the set is sorted by index.
+	template<typename Compare>
+	void sort(Compare comp)
+	{
+		assert_not_iterating_impl();
+		MST_ASSERT(!m_owner, "a set owned by a sparse_group can't be sorted");
+
+		std::sort(m_data.begin(), m_data.end(),
+			[&](const auto& left, const auto& right) { return comp(left.get(), right.get()); });
+
+		update_sparse_impl();
+	}
+
+	void sort()
+	{
+		sort([](const value_type& left, const value_type& right) {
+			return left.first < right.first;
+		});
+	}
+
+	// Reorders the dense array so the indices it shares with other come first, in the order of
+	// other. Both sets can then be walked in lockstep with sequential memory access.
+	template<typename OtherElementType, size_t OtherPageSize, typename OtherTraits>
+	void respect(const sparse_set<OtherElementType, IndexType, OtherPageSize, OtherTraits>& other)
+		noexcept(NothrowSwap)
+	{
+		assert_not_iterating_impl();
+		MST_ASSERT(!m_owner, "a set owned by a sparse_group can't be reordered");
+
+		size_t position = 0;
+		for(const auto& elem : other)
+		{
+			const size_t current = find_index_impl(elem.first);
+			if(current != static_cast<size_t>(-1))
+				swap_elements_impl(current, position++);
+		}
+	}
+
+	// Calls func(range) for consecutive ranges of at most chunkSize elements, covering the dense
+	// array in order. range is an iterator_range over value_type. Structural changes to the set
+	// are not allowed during the call.
+	template<typename Fn>
+	void for_each_chunk(size_t chunkSize, Fn func)
+	{
+		for_each_chunk_impl(*this, chunkSize, func);
+	}
+
+	template<typename Fn>
+	void for_each_chunk(size_t chunkSize, Fn func) const
+	{
+		for_each_chunk_impl(*this, chunkSize, func);
+	}
+
+	// Calls func(value_type&) for every element, spread over the executor as contiguous ranges
+	// of the dense array. Structural changes to the set are not allowed during the call.
+	template<typename Executor, typename Fn>
+	void parallel_for_each(Executor&& executor, Fn func)
+	{
+		parallel_for_each_impl(*this, executor, func);
+	}
+
+	template<typename Executor, typename Fn>
+	void parallel_for_each(Executor&& executor, Fn func) const
+	{
+		parallel_for_each_impl(*this, executor, func);
+	}
+
+	// Frees the pooled pages, drops the trailing empty page slots and trims the dense storage
+	void shrink_to_fit()
+	{
+		assert_not_iterating_impl();
+
+		for(auto page : m_pagePool)
 		{
 			delete[] page;
 		}
+		m_pagePool.clear();
+		m_pagePool.shrink_to_fit();
 
-		m_sparse.clear();
+		while(!m_sparse.empty() && !m_sparse.back())
+		{
+			m_sparse.pop_back();
+			m_pageCounts.pop_back();
+		}
+
+		m_data.shrink_to_fit();
+		m_sparse.shrink_to_fit();
+		m_pageCounts.shrink_to_fit();
+	}
+
+	// The number of bytes allocated by the set, including its sparse pages and the page pool
+	[[nodiscard]] inline size_t memory_usage() const noexcept
+	{
+		size_t pageCount = m_pagePool.size();
+		for(auto page : m_sparse)
+		{
+			pageCount += page != nullptr;
+		}
+
+		return m_data.capacity() * sizeof(m_data[0]) + m_sparse.capacity() * sizeof(IndexType*) +
+			   m_pageCounts.capacity() * sizeof(uint32_t) +
+			   m_pagePool.capacity() * sizeof(IndexType*) +
+			   pageCount * PageSize * sizeof(IndexType);
 	}
 
 private:
@@ -246,24 +528,265 @@ private:
 		if(m_sparse.size() <= index)
 		{
 			m_sparse.resize(index + 1);
+			m_pageCounts.resize(index + 1);
 		}
 
 		if(!m_sparse[index])
 		{
-			m_sparse[index] = new IndexType[PageSize];
-			memset(m_sparse[index], -1, PageSize * sizeof(IndexType));
+			if(!m_pagePool.empty())
+			{
+				// pooled pages are already cleared to -1
+				m_sparse[index] = m_pagePool.back();
+				m_pagePool.pop_back();
+			}
+			else
+			{
+				m_sparse[index] = new IndexType[PageSize];
+				memset(m_sparse[index], -1, PageSize * sizeof(IndexType));
+			}
 		}
 
 		return m_sparse[index];
 	}
 
+	inline void assert_not_iterating_impl() const noexcept
+	{
+#if MST_DEBUGMODE
+		MST_ASSERT(m_iterationDepth == 0, "the set can't be changed while it's being iterated");
+#endif
+	}
+
+	template<typename Set, typename Fn>
+	static void for_each_chunk_impl(Set& set, size_t chunkSize, Fn& func)
+	{
+		MST_ASSERT(chunkSize > 0, "chunkSize must be positive");
+
+#if MST_DEBUGMODE
+		++set.m_iterationDepth;
+		const auto iterationGuard = scope_guard([&] { --set.m_iterationDepth; });
+#endif
+
+		const auto first = set.begin();
+		const size_t count = set.size();
+		for(size_t offset = 0; offset < count; offset += chunkSize)
+		{
+			const size_t last = std::min(count, offset + chunkSize);
+			func(iterator_range<decltype(set.begin())>(first + offset, first + last));
+		}
+	}
+
+	template<typename Set, typename Executor, typename Fn>
+	static void parallel_for_each_impl(Set& set, Executor& executor, Fn& func)
+	{
+		const size_t count = set.size();
+		if(count == 0)
+			return;
+
+#if MST_DEBUGMODE
+		++set.m_iterationDepth;
+		const auto iterationGuard = scope_guard([&] { --set.m_iterationDepth; });
+#endif
+
+		const size_t concurrency = executor.concurrency() == 0 ? 1 : executor.concurrency();
+		const size_t taskCount = std::min(count, concurrency * 4);
+
+		const auto data = set.m_data.data();
+		executor.execute(taskCount, [&](size_t task) {
+			const size_t last = count * (task + 1) / taskCount;
+			for(size_t i = count * task / taskCount; i < last; ++i)
+			{
+				func(data[i].get());
+			}
+		});
+	}
+
+	// returns the now empty page to the pool, or frees it when the pool is full
+	void release_page_impl(size_t index) noexcept
+	{
+		const auto page = m_sparse[index];
+		m_sparse[index] = nullptr;
+
+		if(m_pagePool.size() < PagePoolSize)
+			m_pagePool.push_back(page);
+		else
+			delete[] page;
+	}
+
+	void release_pages_impl() noexcept
+	{
+		for(auto page : m_sparse)
+		{
+			delete[] page;
+		}
+		for(auto page : m_pagePool)
+		{
+			delete[] page;
+		}
+	}
+
+	// the positions in indices, ordered by their sparse page with a counting sort
+	[[nodiscard]] std::vector<uint32_t> sort_by_page_impl(array_view<IndexType> indices) const
+	{
+		MST_ASSERT(indices.size() <= UINT32_MAX, "batch too large");
+
+		size_t pageCount = 0;
+		for(const auto index : indices)
+		{
+			pageCount =
+				std::max(pageCount, (entry_impl(index) >> _MST_GET_SHIFT(PageSize)) + 1);
+		}
+
+		std::vector<uint32_t> offsets(pageCount + 1);
+		for(const auto index : indices)
+		{
+			++offsets[(entry_impl(index) >> _MST_GET_SHIFT(PageSize)) + 1];
+		}
+		for(size_t i = 1; i <= pageCount; ++i)
+		{
+			offsets[i] += offsets[i - 1];
+		}
+
+		std::vector<uint32_t> order(indices.size());
+		for(size_t i = 0; i < indices.size(); ++i)
+		{
+			order[offsets[entry_impl(indices[i]) >> _MST_GET_SHIFT(PageSize)]++] =
+				static_cast<uint32_t>(i);
+		}
+
+		return order;
+	}
+
+	// points the existing sparse entries at the current positions in m_data
+	void update_sparse_impl() noexcept
+	{
+		const auto dataSize = m_data.size();
+		for(size_t i = 0; i < dataSize; ++i)
+		{
+			set_entry_impl(m_data[i].get().first, i);
+		}
+	}
+
+	// fills the sparse pages from m_data
+	void rebuild_sparse_impl()
+	{
+		const auto dataSize = m_data.size();
+		for(size_t i = 0; i < dataSize; ++i)
+		{
+			const auto index = m_data[i].get().first;
+			const size_t idx = entry_impl(index);
+			const size_t pageIdx = idx >> _MST_GET_SHIFT(PageSize);
+			const size_t elemIdx = idx & (PageSize - 1);
+
+			ensure_page(pageIdx)[elemIdx] = make_entry_impl(index, i);
+			++m_pageCounts[pageIdx];
+		}
+	}
+
 	[[nodiscard]] size_t get_index_impl(IndexType index) const noexcept
 	{
-		const size_t idx = static_cast<size_t>(index);
+		const size_t idx = entry_impl(index);
 		const size_t pageIdx = idx >> _MST_GET_SHIFT(PageSize);
 		const size_t elemIdx = idx & (PageSize - 1);
 
-		return (size_t)m_sparse[pageIdx][elemIdx];
+		return entry_position_impl(m_sparse[pageIdx][elemIdx]);
+	}
+
+	// the sparse entry of index, or nullptr when its page doesn't exist
+	[[nodiscard]] const IndexType* find_slot_impl(IndexType index) const noexcept
+	{
+		const size_t idx = entry_impl(index);
+		const size_t pageIdx = idx >> _MST_GET_SHIFT(PageSize);
+
+		if(m_sparse.size() <= pageIdx || !m_sparse[pageIdx])
+			return nullptr;
+
+		return m_sparse[pageIdx] + (idx & (PageSize - 1));
+	}
+
+	// The position of index in m_data, or -1 when the set doesn't contain it. Unless matchVersion
+	// is false, an entry with another version doesn't count.
+	[[nodiscard]] size_t find_index_impl(IndexType index, bool matchVersion = true) const noexcept
+	{
+		const auto slot = find_slot_impl(index);
+
+		if(!slot || *slot == static_cast<IndexType>(-1))
+			return static_cast<size_t>(-1);
+
+		if(matchVersion && !entry_matches_impl(*slot, index))
+			return static_cast<size_t>(-1);
+
+		return entry_position_impl(*slot);
+	}
+
+	typedef std::make_unsigned_t<std::conditional_t<std::is_integral<IndexType>::value, IndexType,
+		size_t>>
+		EntryType;
+
+	// the low bits of a sparse entry hold the position in m_data, the high bits the version
+	static constexpr EntryType EntryPositionMask =
+		Traits::version_bits == 0 ? EntryType(-1) : (EntryType(1) << IndexBits) - 1;
+
+	// the part of index that selects its sparse entry
+	[[nodiscard]] static inline size_t entry_impl(IndexType index) noexcept
+	{
+		if constexpr(Traits::version_bits == 0)
+			return static_cast<size_t>(index);
+		else
+			return static_cast<size_t>(static_cast<EntryType>(index) & EntryPositionMask);
+	}
+
+	// the sparse entry of index when its element is at position in m_data
+	[[nodiscard]] static inline IndexType make_entry_impl(IndexType index, size_t position) noexcept
+	{
+		if constexpr(Traits::version_bits == 0)
+			return static_cast<IndexType>(position);
+		else
+			return static_cast<IndexType>((static_cast<EntryType>(index) & ~EntryPositionMask) |
+										  static_cast<EntryType>(position));
+	}
+
+	[[nodiscard]] static inline size_t entry_position_impl(IndexType entry) noexcept
+	{
+		if constexpr(Traits::version_bits == 0)
+			return static_cast<size_t>(entry);
+		else
+			return static_cast<size_t>(static_cast<EntryType>(entry) & EntryPositionMask);
+	}
+
+	// whether entry is in use, and by index's version
+	[[nodiscard]] static inline bool entry_matches_impl(IndexType entry, IndexType index) noexcept
+	{
+		if(entry == static_cast<IndexType>(-1))
+			return false;
+
+		if constexpr(Traits::version_bits == 0)
+			return true;
+		else
+			return ((static_cast<EntryType>(entry) ^ static_cast<EntryType>(index)) &
+					   ~EntryPositionMask) == 0;
+	}
+
+	// points the sparse entry of index at position in m_data
+	void set_entry_impl(IndexType index, size_t position) noexcept
+	{
+		const size_t idx = entry_impl(index);
+		m_sparse[idx >> _MST_GET_SHIFT(PageSize)][idx & (PageSize - 1)] =
+			make_entry_impl(index, position);
+	}
+
+	// swapping two elements of m_data move constructs ElementType
+	static constexpr bool NothrowSwap = std::is_nothrow_move_constructible_v<ElementType>;
+
+	// swaps two elements of m_data, keeping the sparse entries pointing at them
+	void swap_elements_impl(size_t first, size_t second) noexcept(NothrowSwap)
+	{
+		if(first == second)
+			return;
+
+		std::swap(m_data[first], m_data[second]);
+
+		set_entry_impl(m_data[first].get().first, first);
+		set_entry_impl(m_data[second].get().first, second);
 	}
 
 	[[nodiscard]] ElementType& get_impl(IndexType index) noexcept
@@ -279,6 +802,13 @@ private:
 private:
 	std::vector<::mst::_Details::storage_pair<IndexType, ElementType>> m_data;
 	std::vector<IndexType*> m_sparse;
+	std::vector<uint32_t> m_pageCounts; // the number of indices in each page
+	std::vector<IndexType*> m_pagePool; // emptied pages, kept for reuse
+	_Details::sparse_set_owner<IndexType>* m_owner = nullptr;
+#if MST_DEBUGMODE
+	// for_each_chunk() and parallel_for_each() calls in progress
+	mutable std::atomic<uint32_t> m_iterationDepth{ 0 };
+#endif
 };
 
 template<typename ElementType, typename IndexType>
@@ -286,7 +816,8 @@ class sparse_iterator
 {
 	typedef typename std::vector<::mst::_Details::storage_pair<IndexType, ElementType>>::iterator
 		InternalIteratorType;
-	friend class sparse_set<ElementType, IndexType>;
+	template<typename, typename, size_t, typename>
+	friend class sparse_set;
 
 public:
 	sparse_iterator() = default;
@@ -324,7 +855,7 @@ public:
 		return *this;
 	}
 
-	[[nodiscard]] inline sparse_iterator operator+(ptrdiff_t offset) noexcept
+	[[nodiscard]] inline sparse_iterator operator+(ptrdiff_t offset) const noexcept
 	{
 		return sparse_iterator(m_iter + offset);
 	}
@@ -335,7 +866,7 @@ public:
 		return *this;
 	}
 
-	[[nodiscard]] inline sparse_iterator operator-(ptrdiff_t offset) noexcept
+	[[nodiscard]] inline sparse_iterator operator-(ptrdiff_t offset) const noexcept
 	{
 		return sparse_iterator(m_iter - offset);
 	}
@@ -381,7 +912,8 @@ class const_sparse_iterator
 	typedef
 		typename std::vector<::mst::_Details::storage_pair<IndexType, ElementType>>::const_iterator
 			InternalIteratorType;
-	friend class sparse_set<ElementType, IndexType>;
+	template<typename, typename, size_t, typename>
+	friend class sparse_set;
 
 public:
 	const_sparse_iterator() = default;
@@ -439,7 +971,7 @@ public:
 		return *this;
 	}
 
-	[[nodiscard]] inline const_sparse_iterator operator+(ptrdiff_t offset) noexcept
+	[[nodiscard]] inline const_sparse_iterator operator+(ptrdiff_t offset) const noexcept
 	{
 		return const_sparse_iterator(m_iter + offset);
 	}
@@ -450,7 +982,7 @@ public:
 		return *this;
 	}
 
-	[[nodiscard]] inline const_sparse_iterator operator-(ptrdiff_t offset) noexcept
+	[[nodiscard]] inline const_sparse_iterator operator-(ptrdiff_t offset) const noexcept
 	{
 		return const_sparse_iterator(m_iter - offset);
 	}
@@ -491,4 +1023,539 @@ template<typename ElementType, typename IndexType>
 	return iter += offset;
 }
 
-} // namespace mst
\ No newline at end of file
+// Iterates the indices present in every one of a number of sparse_sets, e.g. the entities that
+// have all of a set of components. The smallest set drives the iteration, every other set is
+// probed through its sparse pages, so the cost is proportional to the smallest set. The sets
+// must not be modified while they are being iterated.
+//
+//   sparse_view view(positions, velocities);
+//   view.each([](auto index, vec3& position, const vec3& velocity) { ... });
+//   for(auto [index, position, velocity] : view) { ... }
+template<typename... Sets>
+class sparse_view
+{
+	static_assert(sizeof...(Sets) > 0, "sparse_view needs at least one set");
+
+	typedef std::tuple_element_t<0, std::tuple<std::remove_const_t<Sets>...>> first_set_type;
+
+public:
+	typedef typename first_set_type::index_type index_type;
+
+	static_assert(
+		(std::is_same<typename std::remove_const_t<Sets>::index_type, index_type>::value && ...),
+		"all sets of a sparse_view must use the same index type");
+
+	// references to the elements of the sets, const for const sets
+	template<typename Set>
+	using element_reference = std::conditional_t<std::is_const<Set>::value,
+		const typename std::remove_const_t<Set>::element_type&,
+		typename std::remove_const_t<Set>::element_type&>;
+
+	class iterator;
+
+	inline explicit sparse_view(Sets&... sets) noexcept
+		: m_sets(&sets...)
+	{ }
+
+	// Calls func(index, elements...) for every index that is present in all sets
+	template<typename Fn>
+	inline void each(Fn func) const
+	{
+		each_impl(smallest_set(), func, std::index_sequence_for<Sets...>());
+	}
+
+	[[nodiscard]] inline iterator begin() const noexcept
+	{
+		return iterator(this, smallest_set(), 0);
+	}
+
+	[[nodiscard]] inline iterator end() const noexcept
+	{
+		const size_t driver = smallest_set();
+		return iterator(this, driver, driver_size(driver));
+	}
+
+	// an upper bound for the number of indices the view visits
+	[[nodiscard]] inline size_t size_hint() const noexcept
+	{
+		return driver_size(smallest_set());
+	}
+
+	class iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef std::tuple<index_type, element_reference<Sets>...> value_type;
+		typedef value_type reference;
+		typedef ptrdiff_t difference_type;
+		typedef void pointer;
+
+		iterator() = default;
+
+		inline iterator& operator++() noexcept
+		{
+			++m_position;
+			skip_missing();
+			return *this;
+		}
+
+		inline iterator operator++(int) noexcept
+		{
+			iterator result = *this;
+			++*this;
+			return result;
+		}
+
+		[[nodiscard]] inline reference operator*() const noexcept
+		{
+			return deref(std::index_sequence_for<Sets...>());
+		}
+
+		[[nodiscard]] inline bool operator==(const iterator& other) const noexcept
+		{
+			return m_position == other.m_position;
+		}
+
+		[[nodiscard]] inline bool operator!=(const iterator& other) const noexcept
+		{
+			return m_position != other.m_position;
+		}
+
+	private:
+		friend class sparse_view;
+
+		inline iterator(const sparse_view* view, size_t driver, size_t position) noexcept
+			: m_view(view)
+			, m_driver(driver)
+			, m_position(position)
+			, m_end(view->driver_size(driver))
+		{
+			skip_missing();
+		}
+
+		inline void skip_missing() noexcept
+		{
+			for(; m_position != m_end; ++m_position)
+			{
+				m_index = m_view->driver_index(m_driver, m_position);
+				if(m_view->find_all(m_index, m_positions, std::index_sequence_for<Sets...>()))
+				{
+					return;
+				}
+			}
+		}
+
+		template<size_t... Is>
+		[[nodiscard]] inline reference deref(std::index_sequence<Is...>) const noexcept
+		{
+			return reference(
+				m_index, std::get<Is>(m_view->m_sets)->m_data[m_positions[Is]].get().second...);
+		}
+
+		const sparse_view* m_view = nullptr;
+		size_t m_driver = 0;
+		size_t m_position = 0;
+		size_t m_end = 0;
+		index_type m_index = index_type();
+		std::array<size_t, sizeof...(Sets)> m_positions = {};
+	};
+
+private:
+	// the driver prefetches the sparse entries of the other sets this many elements ahead,
+	// and the elements those entries point to half as far ahead
+	static constexpr size_t PrefetchDistance = 16;
+
+	[[nodiscard]] inline size_t smallest_set() const noexcept
+	{
+		return smallest_set_impl(std::index_sequence_for<Sets...>());
+	}
+
+	template<size_t... Is>
+	[[nodiscard]] inline size_t smallest_set_impl(std::index_sequence<Is...>) const noexcept
+	{
+		const size_t sizes[] = { std::get<Is>(m_sets)->size()... };
+
+		size_t smallest = 0;
+		for(size_t i = 1; i < sizeof...(Sets); ++i)
+		{
+			if(sizes[i] < sizes[smallest])
+				smallest = i;
+		}
+		return smallest;
+	}
+
+	[[nodiscard]] inline size_t driver_size(size_t driver) const noexcept
+	{
+		return driver_size_impl(driver, std::index_sequence_for<Sets...>());
+	}
+
+	template<size_t... Is>
+	[[nodiscard]] inline size_t driver_size_impl(
+		size_t driver, std::index_sequence<Is...>) const noexcept
+	{
+		size_t size = 0;
+		((driver == Is ? (void)(size = std::get<Is>(m_sets)->size()) : (void)0), ...);
+		return size;
+	}
+
+	[[nodiscard]] inline index_type driver_index(size_t driver, size_t position) const noexcept
+	{
+		return driver_index_impl(driver, position, std::index_sequence_for<Sets...>());
+	}
+
+	template<size_t... Is>
+	[[nodiscard]] inline index_type driver_index_impl(
+		size_t driver, size_t position, std::index_sequence<Is...>) const noexcept
+	{
+		index_type index = index_type();
+		((driver == Is ? (void)(index = std::get<Is>(m_sets)->m_data[position].get().first)
+					   : (void)0),
+			...);
+		return index;
+	}
+
+	// looks index up in every set, stops at the first set that doesn't contain it
+	template<size_t... Is>
+	[[nodiscard]] inline bool find_all(index_type index,
+		std::array<size_t, sizeof...(Sets)>& positions, std::index_sequence<Is...>) const noexcept
+	{
+		return ((positions[Is] = std::get<Is>(m_sets)->find_index_impl(index),
+					positions[Is] != static_cast<size_t>(-1)) &&
+			...);
+	}
+
+	template<typename Fn, size_t... Is>
+	inline void each_impl(size_t driver, Fn& func, std::index_sequence<Is...> seq) const
+	{
+		((driver == Is ? each_driven_by<Is>(func, seq) : (void)0), ...);
+	}
+
+	template<size_t Driver, typename Fn, size_t... Is>
+	inline void each_driven_by(Fn& func, std::index_sequence<Is...>) const
+	{
+		const auto& dense = std::get<Driver>(m_sets)->m_data;
+		const size_t count = dense.size();
+
+		std::array<size_t, sizeof...(Sets)> positions;
+		for(size_t position = 0; position < count; ++position)
+		{
+			if(position + PrefetchDistance < count)
+			{
+				const auto ahead = dense[position + PrefetchDistance].get().first;
+				((Is != Driver ? prefetch_slot<Is>(ahead) : (void)0), ...);
+			}
+			if(position + PrefetchDistance / 2 < count)
+			{
+				const auto ahead = dense[position + PrefetchDistance / 2].get().first;
+				((Is != Driver ? prefetch_element<Is>(ahead) : (void)0), ...);
+			}
+
+			const auto index = dense[position].get().first;
+
+			positions[Driver] = position;
+			const bool inAll = ((Is == Driver ||
+									(positions[Is] = std::get<Is>(m_sets)->find_index_impl(index),
+										positions[Is] != static_cast<size_t>(-1))) &&
+				...);
+			if(!inAll)
+				continue;
+
+			func(index, std::get<Is>(m_sets)->m_data[positions[Is]].get().second...);
+		}
+	}
+
+	template<size_t I>
+	inline void prefetch_slot(index_type index) const noexcept
+	{
+		if(const auto slot = std::get<I>(m_sets)->find_slot_impl(index))
+			_MST_PREFETCH(slot);
+	}
+
+	template<size_t I>
+	inline void prefetch_element(index_type index) const noexcept
+	{
+		const size_t position = std::get<I>(m_sets)->find_index_impl(index);
+		if(position != static_cast<size_t>(-1))
+			_MST_PREFETCH(std::get<I>(m_sets)->m_data.data() + position);
+	}
+
+	std::tuple<Sets*...> m_sets;
+};
+
+template<typename... Sets>
+sparse_view(Sets&...) -> sparse_view<Sets...>;
+
+// Owns two or more sparse_sets and keeps the indices they have in common packed at the front
+// of each of their dense arrays, in the same order. Iterating the group is then a linear walk
+// over parallel arrays, without any sparse lookups. emplace() and erase() on the owned sets
+// keep the group up to date with a swap per set. A set can be owned by one group at a time, and
+// must outlive it.
+//
+//   sparse_group group(positions, velocities);
+//   group.each([](auto index, vec3& position, vec3& velocity) { ... });
+template<typename... Sets>
+class sparse_group
+	: private _Details::sparse_set_owner<
+		  typename std::tuple_element_t<0, std::tuple<Sets...>>::index_type>
+{
+	static_assert(sizeof...(Sets) > 1, "a sparse_group needs at least two sets");
+	static_assert(!(std::is_const<Sets>::value || ...), "a sparse_group can't own const sets");
+
+public:
+	typedef typename std::tuple_element_t<0, std::tuple<Sets...>>::index_type index_type;
+
+	static_assert((std::is_same<typename Sets::index_type, index_type>::value && ...),
+		"all sets of a sparse_group must use the same index type");
+
+	class iterator;
+
+	inline explicit sparse_group(Sets&... sets)
+		: m_sets(&sets...)
+	{
+		MST_ASSERT(((sets.m_owner == nullptr) && ...), "a set can only be owned by one group");
+		((sets.m_owner = this), ...);
+
+		// walk a copy of the smallest set's indices, the walk itself reorders the sets
+		std::vector<index_type> indices;
+		sparse_view<Sets...>(sets...).each([&](index_type index, auto&...) {
+			indices.push_back(index);
+		});
+		for(const auto index : indices)
+		{
+			pack(index);
+		}
+	}
+
+	sparse_group(const sparse_group&) = delete;
+	sparse_group& operator=(const sparse_group&) = delete;
+
+	inline ~sparse_group()
+	{
+		std::apply([](auto*... sets) { ((sets->m_owner = nullptr), ...); }, m_sets);
+	}
+
+	// the number of indices that are in every owned set
+	[[nodiscard]] inline size_t size() const noexcept
+	{
+		return m_size;
+	}
+
+	[[nodiscard]] inline bool empty() const noexcept
+	{
+		return m_size == 0;
+	}
+
+	[[nodiscard]] inline bool contains(index_type index) const noexcept
+	{
+		return std::get<0>(m_sets)->find_index_impl(index) < m_size;
+	}
+
+	// Calls func(index, elements...) for every index in the group, in the shared dense order.
+	// The sets must not be modified during the call.
+	template<typename Fn>
+	inline void each(Fn func)
+	{
+		each_impl(func, std::index_sequence_for<Sets...>());
+	}
+
+	[[nodiscard]] inline iterator begin() noexcept
+	{
+		return iterator(this, 0);
+	}
+
+	[[nodiscard]] inline iterator end() noexcept
+	{
+		return iterator(this, m_size);
+	}
+
+	class iterator
+	{
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef std::tuple<index_type, typename Sets::element_type&...> value_type;
+		typedef value_type reference;
+		typedef ptrdiff_t difference_type;
+		typedef void pointer;
+
+		iterator() = default;
+
+		inline iterator& operator++() noexcept
+		{
+			++m_position;
+			return *this;
+		}
+
+		inline iterator operator++(int) noexcept
+		{
+			iterator result = *this;
+			++m_position;
+			return result;
+		}
+
+		inline iterator& operator--() noexcept
+		{
+			--m_position;
+			return *this;
+		}
+
+		inline iterator operator--(int) noexcept
+		{
+			iterator result = *this;
+			--m_position;
+			return result;
+		}
+
+		inline iterator& operator+=(ptrdiff_t offset) noexcept
+		{
+			m_position += offset;
+			return *this;
+		}
+
+		inline iterator& operator-=(ptrdiff_t offset) noexcept
+		{
+			m_position -= offset;
+			return *this;
+		}
+
+		[[nodiscard]] inline iterator operator+(ptrdiff_t offset) const noexcept
+		{
+			return iterator(m_group, m_position + offset);
+		}
+
+		[[nodiscard]] inline iterator operator-(ptrdiff_t offset) const noexcept
+		{
+			return iterator(m_group, m_position - offset);
+		}
+
+		[[nodiscard]] friend inline iterator operator+(
+			ptrdiff_t offset, const iterator& it) noexcept
+		{
+			return it + offset;
+		}
+
+		[[nodiscard]] inline ptrdiff_t operator-(const iterator& other) const noexcept
+		{
+			return static_cast<ptrdiff_t>(m_position) - static_cast<ptrdiff_t>(other.m_position);
+		}
+
+		[[nodiscard]] inline reference operator*() const noexcept
+		{
+			return deref(std::index_sequence_for<Sets...>());
+		}
+
+		[[nodiscard]] inline reference operator[](ptrdiff_t offset) const noexcept
+		{
+			return *(*this + offset);
+		}
+
+		[[nodiscard]] inline bool operator==(const iterator& other) const noexcept
+		{
+			return m_position == other.m_position;
+		}
+
+		[[nodiscard]] inline bool operator!=(const iterator& other) const noexcept
+		{
+			return m_position != other.m_position;
+		}
+
+		[[nodiscard]] inline bool operator<(const iterator& other) const noexcept
+		{
+			return m_position < other.m_position;
+		}
+
+		[[nodiscard]] inline bool operator>(const iterator& other) const noexcept
+		{
+			return m_position > other.m_position;
+		}
+
+		[[nodiscard]] inline bool operator<=(const iterator& other) const noexcept
+		{
+			return m_position <= other.m_position;
+		}
+
+		[[nodiscard]] inline bool operator>=(const iterator& other) const noexcept
+		{
+			return m_position >= other.m_position;
+		}
+
+	private:
+		friend class sparse_group;
+
+		inline iterator(sparse_group* group, size_t position) noexcept
+			: m_group(group)
+			, m_position(position)
+		{ }
+
+		template<size_t... Is>
+		[[nodiscard]] inline reference deref(std::index_sequence<Is...>) const noexcept
+		{
+			return reference(std::get<0>(m_group->m_sets)->m_data[m_position].get().first,
+				std::get<Is>(m_group->m_sets)->m_data[m_position].get().second...);
+		}
+
+		sparse_group* m_group = nullptr;
+		size_t m_position = 0;
+	};
+
+private:
+	void on_emplace(index_type index) override
+	{
+		if(in_all(index, std::index_sequence_for<Sets...>()))
+			pack(index);
+	}
+
+	void on_erase(index_type index) override
+	{
+		const size_t position = std::get<0>(m_sets)->find_index_impl(index);
+		if(position == static_cast<size_t>(-1) || position >= m_size)
+			return;
+
+		// swap it with the last grouped index, then leave it just past the group
+		--m_size;
+		std::apply(
+			[&](auto*... sets) { (sets->swap_elements_impl(position, m_size), ...); }, m_sets);
+	}
+
+	void on_clear() override
+	{
+		m_size = 0;
+	}
+
+	template<size_t... Is>
+	[[nodiscard]] inline bool in_all(index_type index, std::index_sequence<Is...>) const noexcept
+	{
+		return ((std::get<Is>(m_sets)->find_index_impl(index) != static_cast<size_t>(-1)) && ...);
+	}
+
+	// moves index, which is in every set but not yet in the group, to the end of the group
+	inline void pack(index_type index)
+	{
+		std::apply(
+			[&](auto*... sets) {
+				(sets->swap_elements_impl(sets->find_index_impl(index), m_size), ...);
+			},
+			m_sets);
+		++m_size;
+	}
+
+	template<typename Fn, size_t... Is>
+	inline void each_impl(Fn& func, std::index_sequence<Is...>)
+	{
+		const std::tuple<decltype(std::get<Is>(m_sets)->m_data.data())...> data(
+			std::get<Is>(m_sets)->m_data.data()...);
+
+		for(size_t position = 0; position < m_size; ++position)
+		{
+			func(std::get<0>(data)[position].get().first,
+				std::get<Is>(data)[position].get().second...);
+		}
+	}
+
+	std::tuple<Sets*...> m_sets;
+	size_t m_size = 0;
+};
+
+template<typename... Sets>
+sparse_group(Sets&...) -> sparse_group<Sets...>;
+
+} // namespace mst
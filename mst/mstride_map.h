@@ -28,9 +28,24 @@
 #include <iterator>
 #include <mdebug.h>
 #include <mranges.h>
+#include <maligned_malloc.h>
+#include <mx_platform.h>
 #include <initializer_list>
+#include <algorithm>
+#include <vector>
 #include <cstdlib>
 #include <cstring>
+#include <type_traits>
+
+#if _MST_HAS_AVX2
+#include <immintrin.h>
+#endif
+
+// Maps whose storage reaches this many bytes live in their own pages, which grow with
+// mremap() on Linux instead of being copied
+#ifndef MST_STRIDE_MAP_MREMAP_THRESHOLD
+#define MST_STRIDE_MAP_MREMAP_THRESHOLD (1024 * 1024)
+#endif
 
 namespace mst {
 
@@ -158,27 +173,260 @@ private:
 	const size_t _MyStride;
 };
 
-class stride_map
+// A view over one field of every record in a stride_map: element i is the T found
+// _Offset bytes into record i. Invalidated by anything that reallocates the stride_map.
+template<typename T>
+class stride_map_column
 {
 public:
-	explicit stride_map(size_t _Stride)
-		: _MyBegin((char*)malloc(_Stride))
-		, _MyEnd(_MyBegin)
-		, _MyLast(_MyBegin + _Stride)
-		, _MyStride(_Stride)
-	{ }
-	explicit stride_map(size_t _Stride, size_t _InitSize)
-		: _MyBegin((char*)malloc(_InitSize * _Stride))
-		, _MyEnd(_MyBegin + (_InitSize * _Stride))
-		, _MyLast(_MyEnd)
+	typedef T value_type;
+	typedef T& reference;
+	typedef T* pointer;
+	typedef stride_map_iterator<T> iterator;
+
+	stride_map_column(char* _First, size_t _Stride, size_t _Count)
+		: _MyFirst(_First)
 		, _MyStride(_Stride)
+		, _MyCount(_Count)
 	{ }
+
+	inline reference operator[](size_t _Idx) const
+	{
+		MST_ASSERT(_Idx < _MyCount, "index out of range");
+		return *(pointer)(_MyFirst + _Idx * _MyStride);
+	}
+
+	inline iterator begin() const
+	{
+		return iterator(_MyFirst, _MyStride);
+	}
+
+	inline iterator end() const
+	{
+		return iterator(_MyFirst + _MyCount * _MyStride, _MyStride);
+	}
+
+	inline size_t size() const
+	{
+		return _MyCount;
+	}
+
+	inline bool empty() const
+	{
+		return _MyCount == 0;
+	}
+
+	inline size_t stride() const
+	{
+		return _MyStride;
+	}
+
+private:
+	char* _MyFirst;
+	size_t _MyStride;
+	size_t _MyCount;
+};
+
+namespace _Details {
+
+// copies _Count fields of _Size bytes, _Stride bytes apart, from _Src into the packed _Dst
+inline void _Strided_gather(
+	const char* _Src, size_t _Stride, size_t _Size, size_t _Count, char* _Dst) noexcept
+{
+	size_t _Idx = 0;
+#if _MST_HAS_AVX2
+	// hardware gathers take 32-bit byte offsets, 8 lanes wide for 4-byte fields and
+	// 4 lanes wide for 8-byte fields
+	if((_Size == 4 || _Size == 8) && _Stride <= 0x7FFFFFFF / 8)
+	{
+		const int _S = (int)_Stride;
+		if(_Size == 4)
+		{
+			const __m256i _Offsets = _mm256_setr_epi32(
+				0, _S, 2 * _S, 3 * _S, 4 * _S, 5 * _S, 6 * _S, 7 * _S);
+			for(; _Idx + 8 <= _Count; _Idx += 8)
+			{
+				const __m256i _Values = _mm256_i32gather_epi32(
+					(const int*)(_Src + _Idx * _Stride), _Offsets, 1);
+				_mm256_storeu_si256((__m256i*)(_Dst + _Idx * 4), _Values);
+			}
+		}
+		else
+		{
+			const __m128i _Offsets = _mm_setr_epi32(0, _S, 2 * _S, 3 * _S);
+			for(; _Idx + 4 <= _Count; _Idx += 4)
+			{
+				const __m256i _Values = _mm256_i32gather_epi64(
+					(const long long*)(_Src + _Idx * _Stride), _Offsets, 1);
+				_mm256_storeu_si256((__m256i*)(_Dst + _Idx * 8), _Values);
+			}
+		}
+	}
+#endif
+	for(; _Idx + 4 <= _Count; _Idx += 4)
+	{
+		const char* _From = _Src + _Idx * _Stride;
+		char* _To = _Dst + _Idx * _Size;
+		memcpy(_To, _From, _Size);
+		memcpy(_To + _Size, _From + _Stride, _Size);
+		memcpy(_To + 2 * _Size, _From + 2 * _Stride, _Size);
+		memcpy(_To + 3 * _Size, _From + 3 * _Stride, _Size);
+	}
+	for(; _Idx < _Count; ++_Idx)
+	{
+		memcpy(_Dst + _Idx * _Size, _Src + _Idx * _Stride, _Size);
+	}
+}
+
+// copies _Count packed fields of _Size bytes from _Src into _Dst, _Stride bytes apart
+// AVX2 has no scatter instruction, so this is always an unrolled strided copy
+inline void _Strided_scatter(
+	const char* _Src, size_t _Stride, size_t _Size, size_t _Count, char* _Dst) noexcept
+{
+	size_t _Idx = 0;
+	for(; _Idx + 4 <= _Count; _Idx += 4)
+	{
+		const char* _From = _Src + _Idx * _Size;
+		char* _To = _Dst + _Idx * _Stride;
+		memcpy(_To, _From, _Size);
+		memcpy(_To + _Stride, _From + _Size, _Size);
+		memcpy(_To + 2 * _Stride, _From + 2 * _Size, _Size);
+		memcpy(_To + 3 * _Stride, _From + 3 * _Size, _Size);
+	}
+	for(; _Idx < _Count; ++_Idx)
+	{
+		memcpy(_Dst + _Idx * _Stride, _Src + _Idx * _Size, _Size);
+	}
+}
+
+// the bits of an arithmetic key, as an unsigned integer that sorts in the same order
+template<typename K>
+using _Radix_bits_t = typename ::std::conditional<sizeof(K) <= 4, uint32_t, uint64_t>::type;
+
+template<typename K>
+inline _Radix_bits_t<K> _Radix_key(const char* _Ptr) noexcept
+{
+	static_assert(::std::is_arithmetic<K>::value, "radix keys must be arithmetic");
+
+	K _Key;
+	memcpy(&_Key, _Ptr, sizeof(K));
+
+	if constexpr(::std::is_floating_point<K>::value)
+	{
+		static_assert(sizeof(K) == 4 || sizeof(K) == 8, "unsupported floating point key");
+		typedef typename ::std::conditional<sizeof(K) == 4, uint32_t, uint64_t>::type _Bits;
+
+		_Bits _Value;
+		memcpy(&_Value, &_Key, sizeof(K));
+
+		// negative values sort in reverse, and below all positive values
+		constexpr _Bits _SignBit = (_Bits)1 << (sizeof(K) * 8 - 1);
+		return (_Value & _SignBit) ? (_Bits)~_Value : (_Bits)(_Value | _SignBit);
+	}
+	else if constexpr(::std::is_signed<K>::value)
+	{
+		typedef typename ::std::make_unsigned<K>::type _Bits;
+		constexpr _Bits _SignBit = (_Bits)1 << (sizeof(K) * 8 - 1);
+		return (_Bits)((_Bits)_Key ^ _SignBit);
+	}
+	else
+	{
+		return _Key;
+	}
+}
+
+template<typename _Bits>
+struct _Radix_entry
+{
+	_Bits key;
+	uint32_t index;
+};
+
+// stable LSD radix sort on 11-bit digits; passes where every key has the same digit are skipped
+template<typename _Bits>
+inline void _Radix_sort(
+	_Radix_entry<_Bits>* _Data, _Radix_entry<_Bits>* _Scratch, size_t _Count) noexcept
+{
+	constexpr size_t _DigitBits = 11;
+	constexpr size_t _Buckets = (size_t)1 << _DigitBits;
+	constexpr size_t _Passes = (sizeof(_Bits) * 8 + _DigitBits - 1) / _DigitBits;
+
+	uint32_t _Counts[_Passes][_Buckets] = {};
+	for(size_t _Idx = 0; _Idx < _Count; ++_Idx)
+	{
+		const _Bits _Key = _Data[_Idx].key;
+		for(size_t _Pass = 0; _Pass < _Passes; ++_Pass)
+		{
+			++_Counts[_Pass][(_Key >> (_Pass * _DigitBits)) & (_Buckets - 1)];
+		}
+	}
+
+	_Radix_entry<_Bits>* _From = _Data;
+	_Radix_entry<_Bits>* _To = _Scratch;
+	for(size_t _Pass = 0; _Pass < _Passes; ++_Pass)
+	{
+		const size_t _Shift = _Pass * _DigitBits;
+		uint32_t* _Offsets = _Counts[_Pass];
+		if(_Offsets[(_From[0].key >> _Shift) & (_Buckets - 1)] == _Count)
+		{
+			continue;
+		}
+
+		uint32_t _Sum = 0;
+		for(size_t _Digit = 0; _Digit < _Buckets; ++_Digit)
+		{
+			const uint32_t _DigitCount = _Offsets[_Digit];
+			_Offsets[_Digit] = _Sum;
+			_Sum += _DigitCount;
+		}
+
+		for(size_t _Idx = 0; _Idx < _Count; ++_Idx)
+		{
+			_To[_Offsets[(_From[_Idx].key >> _Shift) & (_Buckets - 1)]++] = _From[_Idx];
+		}
+		::std::swap(_From, _To);
+	}
+
+	if(_From != _Data)
+	{
+		memcpy(_Data, _From, _Count * sizeof(_Radix_entry<_Bits>));
+	}
+}
+
+} // namespace _Details
+
+// Records of a runtime stride in one contiguous buffer.
+//
+// An empty map owns no memory, unless it was reserved. Capacity doubles when a push runs out of
+// room (starting at 64 bytes worth of records) and halves when fewer than a quarter of the
+// records are in use, but never below the capacity asked for by reserve(). reserve() and
+// shrink_to_fit() set it explicitly, clear() and shrink_to_fit() drop the reserved capacity.
+// A non-zero alignment rounds the stride up to a multiple of it and aligns the buffer, so every
+// record starts on that boundary.
+class stride_map
+{
+public:
+	explicit stride_map(size_t _Stride, size_t _InitSize = 0, size_t _Alignment = 0)
+		: _MyBegin(nullptr)
+		, _MyEnd(nullptr)
+		, _MyLast(nullptr)
+		, _MyStride(_alignstride(_Stride, _Alignment))
+		, _MyAlignment(_Alignment)
+		, _MyReserved(0)
+	{
+		_MyBegin = _realloc(_InitSize);
+		_MyLast = _MyEnd = _MyBegin + (_InitSize * _MyStride);
+	}
 	stride_map(const stride_map& _OtherMap)
-		: _MyBegin((char*)malloc(_OtherMap.size() * _OtherMap._MyStride))
-		, _MyEnd(_MyBegin + (_OtherMap.size() * _OtherMap._MyStride))
-		, _MyLast(_MyBegin + (_OtherMap.size() * _OtherMap._MyStride))
+		: _MyBegin(nullptr)
+		, _MyEnd(nullptr)
+		, _MyLast(nullptr)
 		, _MyStride(_OtherMap._MyStride)
+		, _MyAlignment(_OtherMap._MyAlignment)
+		, _MyReserved(0)
 	{
+		_MyBegin = _realloc(_OtherMap.size());
+		_MyLast = _MyEnd = _MyBegin + _OtherMap.data_size();
 #if MST_STRIDE_MAP_COPY_WARNING
 		WARNING_MESG("copying std::stride_map. this is slow, try moving it");
 #endif
@@ -187,11 +435,15 @@ public:
 
 	template<typename T>
 	stride_map(::std::initializer_list<T> initList)
-		: _MyBegin((char*)malloc(initList.size() * sizeof(T)))
-		, _MyEnd(_MyBegin + (initList.size() * sizeof(T)))
-		, _MyLast(_MyBegin + (initList.size() * sizeof(T)))
+		: _MyBegin(nullptr)
+		, _MyEnd(nullptr)
+		, _MyLast(nullptr)
 		, _MyStride(sizeof(T))
+		, _MyAlignment(0)
+		, _MyReserved(0)
 	{
+		_MyBegin = _realloc(initList.size());
+		_MyLast = _MyEnd = _MyBegin + (initList.size() * sizeof(T));
 		_copydata(initList);
 	}
 
@@ -201,8 +453,11 @@ public:
 		, _MyEnd(_OtherMap._MyEnd)
 		, _MyLast(_OtherMap._MyLast)
 		, _MyStride(_OtherMap._MyStride)
+		, _MyAlignment(_OtherMap._MyAlignment)
+		, _MyReserved(_OtherMap._MyReserved)
 	{
 		_OtherMap._MyBegin = _OtherMap._MyEnd = _OtherMap._MyLast = nullptr;
+		_OtherMap._MyReserved = 0;
 	}
 
 	~stride_map()
@@ -347,11 +602,9 @@ public:
 	{
 		MST_ASSERT(empty(), "cannot set stride when not empty");
 
-		_MyStride = _Stride;
-
-		_MyBegin = _realloc(1);
-		_MyEnd = _MyBegin;
-		_MyLast = _MyBegin + _Stride;
+		_orphan();
+		_MyReserved = 0;
+		_MyStride = _alignstride(_Stride, _MyAlignment);
 	}
 
 	template<typename T>
@@ -373,6 +626,174 @@ public:
 		return _MyStride;
 	}
 
+	// the alignment of every record, 0 when the map uses plain malloc alignment
+	inline size_t alignment() const
+	{
+		return _MyAlignment;
+	}
+
+	// a view of the T stored _Offset bytes into every record
+	template<typename T>
+	inline stride_map_column<T> column(size_t _Offset)
+	{
+		MST_ASSERT(_Offset + sizeof(T) <= _MyStride, "column does not fit inside the stride");
+		return stride_map_column<T>(_MyBegin + _Offset, _MyStride, size());
+	}
+
+	template<typename T>
+	inline stride_map_column<const T> column(size_t _Offset) const
+	{
+		MST_ASSERT(_Offset + sizeof(T) <= _MyStride, "column does not fit inside the stride");
+		return stride_map_column<const T>(_MyBegin + _Offset, _MyStride, size());
+	}
+
+	// copies the T stored _Offset bytes into every record to _Out, which holds size() elements
+	template<typename T>
+	inline void gather(size_t _Offset, T* _Out) const
+	{
+		static_assert(::std::is_trivially_copyable<T>::value, "T is not trivially copyable");
+		MST_ASSERT(_Offset + sizeof(T) <= _MyStride, "column does not fit inside the stride");
+
+		_Details::_Strided_gather(_MyBegin + _Offset, _MyStride, sizeof(T), size(), (char*)_Out);
+	}
+
+	// copies size() elements from _In to the T stored _Offset bytes into every record
+	template<typename T>
+	inline void scatter(size_t _Offset, const T* _In)
+	{
+		static_assert(::std::is_trivially_copyable<T>::value, "T is not trivially copyable");
+		MST_ASSERT(_Offset + sizeof(T) <= _MyStride, "column does not fit inside the stride");
+
+		_Details::_Strided_scatter(
+			(const char*)_In, _MyStride, sizeof(T), size(), _MyBegin + _Offset);
+	}
+
+	// Stable sort of the records by the arithmetic K stored _Offset bytes into each of them.
+	// The keys are radix sorted together with their record index, after which every record is
+	// moved once into a new buffer, so the cost per record doesn't depend on the stride.
+	template<typename K>
+	inline void sort_by_key(size_t _Offset)
+	{
+		static_assert(::std::is_arithmetic<K>::value,
+			"K is not arithmetic, use sort_by_key(offset, comp) instead");
+		MST_ASSERT(_Offset + sizeof(K) <= _MyStride, "key does not fit inside the stride");
+		MST_ASSERT(size() <= 0xFFFFFFFF, "too many records to sort");
+
+		typedef _Details::_Radix_entry<_Details::_Radix_bits_t<K>> _Entry;
+
+		const size_t _Count = size();
+		if(_Count < 2)
+		{
+			return;
+		}
+
+		::std::vector<_Entry> _Entries(_Count);
+		::std::vector<_Entry> _Scratch(_Count);
+		for(size_t _Idx = 0; _Idx < _Count; ++_Idx)
+		{
+			_Entries[_Idx].key = _Details::_Radix_key<K>(_MyBegin + _Idx * _MyStride + _Offset);
+			_Entries[_Idx].index = (uint32_t)_Idx;
+		}
+
+		_Details::_Radix_sort(_Entries.data(), _Scratch.data(), _Count);
+
+		_permute(_Entries.data());
+	}
+
+	// Stable sort of the records by the K stored _Offset bytes into each of them, ordered by
+	// _Comp(const K&, const K&). Like sort_by_key(offset), every record is moved once.
+	template<typename K, typename _Compare>
+	inline void sort_by_key(size_t _Offset, _Compare _Comp)
+	{
+		static_assert(::std::is_trivially_copyable<K>::value, "K is not trivially copyable");
+		MST_ASSERT(_Offset + sizeof(K) <= _MyStride, "key does not fit inside the stride");
+		MST_ASSERT(size() <= 0xFFFFFFFF, "too many records to sort");
+
+		typedef _Details::_Radix_entry<K> _Entry;
+
+		const size_t _Count = size();
+		if(_Count < 2)
+		{
+			return;
+		}
+
+		::std::vector<_Entry> _Entries(_Count);
+		for(size_t _Idx = 0; _Idx < _Count; ++_Idx)
+		{
+			memcpy(&_Entries[_Idx].key, _MyBegin + _Idx * _MyStride + _Offset, sizeof(K));
+			_Entries[_Idx].index = (uint32_t)_Idx;
+		}
+
+		::std::stable_sort(_Entries.begin(), _Entries.end(),
+			[&](const _Entry& _Left, const _Entry& _Right) {
+				return _Comp(_Left.key, _Right.key);
+			});
+
+		_permute(_Entries.data());
+	}
+
+	// Moves the records for which _Pred(const T&) is true in front of the others and returns
+	// how many there are. The order within either group is not kept.
+	template<typename T, typename _Predicate>
+	inline size_t partition(_Predicate _Pred)
+	{
+		MST_ASSERT(sizeof(T) <= _MyStride, "invalid size!");
+
+		char* _First = _MyBegin;
+		char* _Last = _MyEnd;
+		for(;;)
+		{
+			while(_First != _Last && _Pred(*(const T*)_First))
+			{
+				_First += _MyStride;
+			}
+			if(_First == _Last)
+			{
+				break;
+			}
+
+			do
+			{
+				_Last -= _MyStride;
+			} while(_Last != _First && !_Pred(*(const T*)_Last));
+			if(_First == _Last)
+			{
+				break;
+			}
+
+			_swaprecords(_First, _Last);
+			_First += _MyStride;
+		}
+
+		return (size_t)(_First - _MyBegin) / _MyStride;
+	}
+
+	// Calls _Func(T&) for every record, spread over the executor as contiguous chunks of whole
+	// records. The map must not be resized during the call.
+	template<typename T, typename _Executor, typename _Function>
+	inline void parallel_transform(_Executor&& _Exec, _Function _Func)
+	{
+		MST_ASSERT(sizeof(T) <= _MyStride, "invalid size!");
+
+		const size_t _Count = size();
+		if(_Count == 0)
+		{
+			return;
+		}
+
+		const size_t _Concurrency = _Exec.concurrency() == 0 ? 1 : _Exec.concurrency();
+		const size_t _TaskCount = _Count < _Concurrency * 4 ? _Count : _Concurrency * 4;
+
+		_Exec.execute(_TaskCount, [&](size_t _Task) {
+			char* _First = _MyBegin + (_Count * _Task / _TaskCount) * _MyStride;
+			char* const _Last = _MyBegin + (_Count * (_Task + 1) / _TaskCount) * _MyStride;
+			for(; _First != _Last; _First += _MyStride)
+			{
+				_Func(*(T*)_First);
+			}
+		});
+	}
+
 	template<typename T>
 	inline stride_map_iterator<T> begin()
 	{
@@ -411,42 +832,56 @@ public:
 
 	inline void pre_allocate(size_t _NumObjects)
 	{
-		size_t _Size = size();
-		size_t _AllocSize = _myallocsize();
-		if(_AllocSize - _Size < _NumObjects)
+		reserve(size() + _NumObjects);
+	}
+
+	// makes room for at least _Capacity records without further reallocation; removing records
+	// never shrinks the buffer below it again, only clear() and shrink_to_fit() release it
+	inline void reserve(size_t _Capacity)
+	{
+		if(_Capacity > _MyReserved)
+		{
+			_MyReserved = _Capacity;
+		}
+		if(_Capacity > _myallocsize())
 		{
-			_MyBegin = _realloc(_Size + _NumObjects);
-			_MyEnd = _MyBegin + (_Size * _MyStride);
-			_MyLast = _MyEnd + (_NumObjects * _MyStride);
+			_setcapacity(_Capacity);
 		}
 	}
 
+	inline size_t capacity() const
+	{
+		return _myallocsize();
+	}
+
 	inline void clear()
 	{
+		_MyReserved = 0;
 		_tidy();
 	}
 
 	inline void shrink_to_fit()
 	{
+		_MyReserved = 0;
+
 		size_t _Oldsize = size();
 		if(_Oldsize == 0)
 		{
 			_tidy();
 			return;
 		}
-		_MyBegin = _realloc(_Oldsize);
-		_MyLast = _MyEnd = _MyBegin + (_Oldsize * _MyStride);
+		_setcapacity(_Oldsize);
 	}
 
 	inline void resize(size_t _NewSize)
 	{
-		if(_NewSize == 0)
+		size_t _Myallocsize = _myallocsize();
+		if(_NewSize > _Myallocsize)
 		{
-			_tidy();
-			return;
+			_setcapacity(_NewSize < _Myallocsize * 2 ? _Myallocsize * 2 : _NewSize);
 		}
-		_MyBegin = _realloc(_NewSize);
-		_MyLast = _MyEnd = _MyBegin + (_NewSize * _MyStride);
+		_MyEnd = _MyBegin + (_NewSize * _MyStride);
+		_checkcollapse();
 	}
 
 	inline size_t size() const
@@ -463,9 +898,12 @@ public:
 	{
 		MST_ASSERT(_MyStride == _OtherMap._MyStride, "incompatible strides");
 
+		if(_OtherMap.empty())
+			return *this;
+
 		size_t _Size = size();
 		resize(_Size + _OtherMap.size());
-		memcpy(_MyBegin + (_Size * _MyStride), _OtherMap._MyBegin, _OtherMap.size() * _MyStride);
+		memcpy(_MyBegin + (_Size * _MyStride), _OtherMap._MyBegin, _OtherMap.data_size());
 
 		return *this;
 	}
@@ -481,6 +919,7 @@ public:
 		_MyBegin = _realloc(_OtherMap._myallocsize());
 		_MyEnd = _MyBegin + (_OtherMap.size() * _MyStride);
 		_MyLast = _MyBegin + (_OtherMap._myallocsize() * _MyStride);
+		_MyReserved = _OtherMap._MyReserved;
 
 		_copydata(_OtherMap);
 
@@ -496,8 +935,11 @@ public:
 		_MyBegin = _OtherMap._MyBegin;
 		_MyEnd = _OtherMap._MyEnd;
 		_MyLast = _OtherMap._MyLast;
+		_MyAlignment = _OtherMap._MyAlignment;
+		_MyReserved = _OtherMap._MyReserved;
 
 		_OtherMap._MyBegin = _OtherMap._MyEnd = _OtherMap._MyLast = nullptr;
+		_OtherMap._MyReserved = 0;
 
 		return *this;
 	}
@@ -526,58 +968,180 @@ private:
 		{
 			// grow geometrically; when the current capacity is 0 (e.g. right after construction
 			// with an initial size of 0, or after clear()) doubling would stay stuck at 0
-			size_t _Newallocsize = _Myallocsize == 0 ? 1 : _Myallocsize * 2;
-			_MyBegin = _realloc(_Newallocsize);
-			_MyEnd = _MyBegin + (_Mysize * _MyStride);
-			_MyLast = _MyBegin + (_Newallocsize * _MyStride);
+			_setcapacity(_Myallocsize == 0 ? _initialcapacity() : _Myallocsize * 2);
 		}
 	}
 
 	inline void _checkcollapse()
 	{
 		size_t _Mysize = size();
-		if(_Mysize == 0)
+		if(_Mysize == 0 && _MyReserved == 0)
 		{
 			_tidy();
 		}
-		else if(_Mysize < _myallocsize() / 4)
+		else if(_Mysize < _myallocsize() / 4 && _myallocsize() / 2 >= _MyReserved)
 		{
-			_MyBegin = _realloc(_Mysize);
-			_MyLast = _MyEnd = _MyBegin + (_Mysize * _MyStride);
+			// only halve, so alternating pushes and pops around the boundary don't reallocate
+			_setcapacity(_myallocsize() / 2);
 		}
 	}
 
 	inline void _tidy()
 	{
-		_MyLast = _MyEnd = _MyBegin = _realloc(1);
-		_MyLast += _MyStride;
+		_orphan();
 	}
 
 	inline void _orphan()
 	{
 		if(_MyBegin)
 		{
-			free(_MyBegin);
+			_deallocate(_MyBegin, (size_t)(_MyLast - _MyBegin));
 			_release();
 		}
 	}
 
+	inline size_t _initialcapacity() const
+	{
+		return _MyStride >= 64 ? 1 : 64 / _MyStride;
+	}
+
+	// reallocates to exactly _Capacity records, keeping size() records
+	inline void _setcapacity(size_t _Capacity)
+	{
+		MST_ASSERT(_Capacity >= size(), "capacity is smaller than the size");
+
+		size_t _Mysize = size();
+		_MyBegin = _realloc(_Capacity);
+		_MyEnd = _MyBegin + (_Mysize * _MyStride);
+		_MyLast = _MyBegin + (_Capacity * _MyStride);
+	}
+
+	// large maps live in their own pages, so growing them remaps instead of copying
+	inline bool _ismapped(size_t _Bytes) const
+	{
+#if MST_PLATFORM_LINUX
+		return _Bytes >= MST_STRIDE_MAP_MREMAP_THRESHOLD && _MyAlignment <= 4096;
+#else
+		_MST_UNUSED(_Bytes);
+		return false;
+#endif
+	}
+
+	inline char* _allocate(size_t _Bytes) const
+	{
+		if(_ismapped(_Bytes))
+			return (char*)::mst::_Details::allocate_pages_impl(_Bytes, false);
+		if(_MyAlignment != 0)
+			return (char*)::mst::aligned_malloc(_Bytes, _MyAlignment);
+		return (char*)malloc(_Bytes);
+	}
+
+	inline void _deallocate(char* _Ptr, size_t _Bytes) const
+	{
+		if(_ismapped(_Bytes))
+			::mst::_Details::free_pages_impl(_Ptr, _Bytes);
+		else if(_MyAlignment != 0)
+			::mst::aligned_free(_Ptr);
+		else
+			free(_Ptr);
+	}
+
+	// resizes the buffer to _Amount records; the old size is taken from _MyLast, so callers
+	// update _MyEnd and _MyLast afterwards
 	inline char* _realloc(size_t _Amount)
 	{
-		return (char*)realloc(_MyBegin, _Amount * _MyStride);
+		const size_t _Oldbytes = (size_t)(_MyLast - _MyBegin);
+		const size_t _Newbytes = _Amount * _MyStride;
+
+		if(_Newbytes == 0)
+		{
+			if(_MyBegin)
+				_deallocate(_MyBegin, _Oldbytes);
+			return nullptr;
+		}
+		if(_MyBegin == nullptr)
+		{
+			return _allocate(_Newbytes);
+		}
+
+		const bool _Wasmapped = _ismapped(_Oldbytes);
+		if(_Wasmapped && _ismapped(_Newbytes))
+		{
+			return (char*)::mst::_Details::reallocate_pages_impl(_MyBegin, _Oldbytes, _Newbytes);
+		}
+		if(!_Wasmapped && !_ismapped(_Newbytes))
+		{
+			if(_MyAlignment != 0)
+				return (char*)::mst::aligned_realloc(_MyBegin, _Newbytes, _MyAlignment);
+			return (char*)realloc(_MyBegin, _Newbytes);
+		}
+
+		// crossing the threshold moves between the heap and mapped pages
+		char* _Newptr = _allocate(_Newbytes);
+		memcpy(_Newptr, _MyBegin, _Oldbytes < _Newbytes ? _Oldbytes : _Newbytes);
+		_deallocate(_MyBegin, _Oldbytes);
+		return _Newptr;
+	}
+
+	// rebuilds the buffer with record i taken from record _Order[i].index
+	template<typename _Entry>
+	inline void _permute(const _Entry* _Order)
+	{
+		const size_t _Count = size();
+		const size_t _Bytes = (size_t)(_MyLast - _MyBegin);
+
+		char* _Newbegin = _allocate(_Bytes);
+		for(size_t _Idx = 0; _Idx < _Count; ++_Idx)
+		{
+			// the reads are random, so fetch a few records ahead, both ends of each
+			if(_Idx + 16 < _Count)
+			{
+				const char* _Ahead = _MyBegin + _Order[_Idx + 16].index * _MyStride;
+				_MST_PREFETCH(_Ahead);
+				_MST_PREFETCH(_Ahead + _MyStride - 1);
+			}
+			memcpy(_Newbegin + _Idx * _MyStride, _MyBegin + _Order[_Idx].index * _MyStride,
+				_MyStride);
+		}
+		_deallocate(_MyBegin, _Bytes);
+
+		_MyBegin = _Newbegin;
+		_MyEnd = _Newbegin + _Count * _MyStride;
+		_MyLast = _Newbegin + _Bytes;
+	}
+
+	inline void _swaprecords(char* _Left, char* _Right) noexcept
+	{
+		char _Tmp[256];
+		for(size_t _Done = 0; _Done < _MyStride; _Done += sizeof(_Tmp))
+		{
+			const size_t _Size =
+				_MyStride - _Done < sizeof(_Tmp) ? _MyStride - _Done : sizeof(_Tmp);
+			memcpy(_Tmp, _Left + _Done, _Size);
+			memcpy(_Left + _Done, _Right + _Done, _Size);
+			memcpy(_Right + _Done, _Tmp, _Size);
+		}
+	}
+
+	static inline size_t _alignstride(size_t _Stride, size_t _Alignment)
+	{
+		MST_ASSERT((_Alignment & (_Alignment - 1)) == 0, "alignment must be a power of 2");
+		return _Alignment == 0 ? _Stride : (_Stride + _Alignment - 1) & ~(_Alignment - 1);
 	}
 
 	// is plain old data, copy memory
 	inline void _copydata(const stride_map& _OtherMap)
 	{
-		memcpy(_MyBegin, _OtherMap._MyBegin, _OtherMap.size() * _MyStride);
+		if(!_OtherMap.empty())
+			memcpy(_MyBegin, _OtherMap._MyBegin, _OtherMap.data_size());
 	}
 
 	// is plain old data, copy memory
 	template<typename T>
 	inline void _copydata(const ::std::initializer_list<T>& initList)
 	{
-		memcpy(_MyBegin, initList.begin(), initList.size() * _MyStride);
+		if(initList.size() != 0)
+			memcpy(_MyBegin, initList.begin(), initList.size() * _MyStride);
 	}
 
 private:
@@ -585,6 +1149,9 @@ private:
 	char* _MyEnd;
 	char* _MyLast;
 	size_t _MyStride;
+	size_t _MyAlignment;
+	// the capacity asked for by reserve(), which removing records doesn't shrink below
+	size_t _MyReserved;
 
 }; // struct stride_map
 
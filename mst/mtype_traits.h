@@ -157,6 +157,20 @@ struct numeric_traits<unsigned long long>
 	static const size_t bits = 64;
 };
 
+// Specialize for types that can be moved to another address with a memcpy, without calling the
+// move constructor and destructor. Trivially copyable types are relocatable by default.
+template<typename T>
+struct is_trivially_relocatable : public std::is_trivially_copyable<T>::type
+{ };
+
+#if _MST_HAS_INLINE_VARIABLES
+
+template<typename T>
+_MST_INLINE_VAR constexpr const bool is_trivially_relocatable_v =
+	is_trivially_relocatable<T>::value;
+
+#endif // !_MST_HAS_INLINE_VARIABLES
+
 #if _MST_HAS_TEMPLATE_AUTO
 
 template<auto Value>
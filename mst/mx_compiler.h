@@ -226,6 +226,16 @@
 #define _MST_PERMUTE_PS(v, c) _mm_shuffle_ps((v), (v), c)
 #endif
 
+// Hint that *ptr will be read soon; never faults, whatever ptr points to
+#if !_MST_USING_VC_COMPILER
+#define _MST_PREFETCH(ptr) __builtin_prefetch(ptr)
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define _MST_PREFETCH(ptr) _mm_prefetch(reinterpret_cast<const char*>(ptr), _MM_HINT_T0)
+#else
+#define _MST_PREFETCH(ptr) ((void)(ptr))
+#endif
+
 #if defined(__x86_64__) || defined(_M_X64)
 #define _MST_HAS_X64   1
 #define _MST_HAS_64BIT 1
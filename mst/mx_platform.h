@@ -67,6 +67,12 @@ bool get_recycle_bin_folder_impl(char* path) noexcept;
 bool get_current_directory_impl(char* path) noexcept;
 bool set_current_directory_impl(const char* path) noexcept;
 uint32_t get_page_size_impl() noexcept;
+void* allocate_pages_impl(size_t size, bool hugePages) noexcept;
+void* reallocate_pages_impl(void* memory, size_t oldSize, size_t newSize) noexcept;
+void free_pages_impl(void* memory, size_t size, bool hugePages = false) noexcept;
+bool map_file_impl(const char* path, bool copyOnWrite, void** data, size_t* size) noexcept;
+void unmap_file_impl(void* data, size_t size) noexcept;
+void advise_mapped_impl(void* data, size_t size, uint32_t hint) noexcept;
 uint32_t get_processor_core_count_impl() noexcept;
 uint32_t get_processor_thread_count_impl() noexcept;
 uint64_t processor_features_impl() noexcept;
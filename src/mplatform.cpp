@@ -34,6 +34,8 @@
 
 #include <sys/utsname.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <fstream>
 #include <set>
@@ -210,6 +212,218 @@ uint32_t mst::_Details::get_page_size_impl() noexcept
 	return pageSize;
 }
 
+static constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+#ifdef MADV_HUGEPAGE
+static void* allocate_huge_page_range(size_t size) noexcept
+{
+	// transparent huge pages only back 2MB aligned ranges, so over-allocate and cut off the
+	// unaligned head and tail
+	const size_t allocSize = size + HugePageSize;
+
+	void* memory =
+		mmap(nullptr, allocSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if(memory == MAP_FAILED)
+	{
+		return nullptr;
+	}
+
+	const auto begin = reinterpret_cast<uintptr_t>(memory);
+	const auto aligned = (begin + HugePageSize - 1) & ~(uintptr_t)(HugePageSize - 1);
+	const auto end = begin + allocSize;
+
+	if(aligned != begin)
+	{
+		munmap(memory, aligned - begin);
+	}
+	if(end != aligned + size)
+	{
+		munmap(reinterpret_cast<void*>(aligned + size), end - (aligned + size));
+	}
+
+	// only a hint, the range is still usable when the kernel refuses
+	madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+
+	return reinterpret_cast<void*>(aligned);
+}
+
+// Allocations below the huge page size are carved out of shared 2MB arenas, so they are backed
+// by huge pages as well. An arena is unmapped once all of its allocations are freed, the current
+// arena is reused from the start instead.
+struct huge_page_arenas
+{
+	std::mutex mutex;
+	uintptr_t current = 0;
+	size_t used = 0;
+	// the number of live allocations of every arena
+	std::map<uintptr_t, size_t> allocationCounts;
+};
+
+static huge_page_arenas& get_huge_page_arenas() noexcept
+{
+	// never destroyed, pages may still be freed by static destructors
+	static huge_page_arenas* const arenas = new huge_page_arenas();
+
+	return *arenas;
+}
+
+static void* allocate_from_huge_page_arena(size_t size) noexcept
+{
+	auto& arenas = get_huge_page_arenas();
+
+	std::lock_guard<std::mutex> lock(arenas.mutex);
+
+	if(arenas.current == 0 || arenas.used + size > HugePageSize)
+	{
+		void* arena = allocate_huge_page_range(HugePageSize);
+		if(!arena)
+		{
+			return nullptr;
+		}
+
+		// the old arena is unmapped by the last free of its allocations
+		arenas.current = reinterpret_cast<uintptr_t>(arena);
+		arenas.used = 0;
+	}
+
+	void* memory = reinterpret_cast<void*>(arenas.current + arenas.used);
+
+	arenas.used += size;
+	++arenas.allocationCounts[arenas.current];
+
+	return memory;
+}
+
+static void free_to_huge_page_arena(void* memory) noexcept
+{
+	const auto arena = reinterpret_cast<uintptr_t>(memory) & ~(uintptr_t)(HugePageSize - 1);
+
+	auto& arenas = get_huge_page_arenas();
+
+	std::lock_guard<std::mutex> lock(arenas.mutex);
+
+	const auto it = arenas.allocationCounts.find(arena);
+	if(--it->second != 0)
+	{
+		return;
+	}
+
+	if(arena == arenas.current)
+	{
+		arenas.used = 0;
+		return;
+	}
+
+	arenas.allocationCounts.erase(it);
+	munmap(reinterpret_cast<void*>(arena), HugePageSize);
+}
+#endif
+
+void* mst::_Details::allocate_pages_impl(size_t size, bool hugePages) noexcept
+{
+#ifdef MADV_HUGEPAGE
+	if(hugePages)
+	{
+		return size < HugePageSize ? allocate_from_huge_page_arena(size)
+								   : allocate_huge_page_range(size);
+	}
+#else
+	_MST_UNUSED(hugePages);
+#endif
+
+	void* memory =
+		mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	return memory == MAP_FAILED ? nullptr : memory;
+}
+
+void* mst::_Details::reallocate_pages_impl(
+	void* memory, size_t oldSize, size_t newSize) noexcept
+{
+#ifdef MREMAP_MAYMOVE
+	// the kernel moves the page table entries, the contents are never copied
+	void* newMemory = mremap(memory, oldSize, newSize, MREMAP_MAYMOVE);
+
+	return newMemory == MAP_FAILED ? nullptr : newMemory;
+#else
+	void* newMemory = allocate_pages_impl(newSize, false);
+
+	if(newMemory)
+	{
+		memcpy(newMemory, memory, oldSize < newSize ? oldSize : newSize);
+		free_pages_impl(memory, oldSize);
+	}
+
+	return newMemory;
+#endif
+}
+
+void mst::_Details::free_pages_impl(void* memory, size_t size, bool hugePages) noexcept
+{
+#ifdef MADV_HUGEPAGE
+	if(hugePages && size < HugePageSize)
+	{
+		free_to_huge_page_arena(memory);
+		return;
+	}
+#else
+	_MST_UNUSED(hugePages);
+#endif
+
+	munmap(memory, size);
+}
+
+bool mst::_Details::map_file_impl(
+	const char* path, bool copyOnWrite, void** data, size_t* size) noexcept
+{
+	const int fd = open(path, O_RDONLY);
+	if(fd < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if(fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	*data = nullptr;
+	*size = static_cast<size_t>(info.st_size);
+
+	if(*size != 0)
+	{
+		// a private mapping never writes back, so copy-on-write only needs a read-only file
+		void* memory = mmap(nullptr, *size, copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ,
+			MAP_PRIVATE, fd, 0);
+
+		if(memory == MAP_FAILED)
+		{
+			close(fd);
+			return false;
+		}
+		*data = memory;
+	}
+
+	// the mapping keeps its own reference to the file
+	close(fd);
+	return true;
+}
+
+void mst::_Details::unmap_file_impl(void* data, size_t size) noexcept
+{
+	munmap(data, size);
+}
+
+void mst::_Details::advise_mapped_impl(void* data, size_t size, uint32_t hint) noexcept
+{
+	static constexpr int advice[] = { MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED };
+
+	madvise(data, size, advice[hint]);
+}
+
 struct ProcCpuInfo
 {
 	uint32_t coreCount;
@@ -558,6 +772,104 @@ uint32_t mst::_Details::get_page_size_impl() noexcept
 	return pageSize;
 }
 
+void* mst::_Details::allocate_pages_impl(size_t size, bool hugePages) noexcept
+{
+	// large pages require SeLockMemoryPrivilege, regular pages are used instead
+	_MST_UNUSED(hugePages);
+
+	return VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+}
+
+void* mst::_Details::reallocate_pages_impl(
+	void* memory, size_t oldSize, size_t newSize) noexcept
+{
+	void* newMemory = allocate_pages_impl(newSize, false);
+
+	if(newMemory)
+	{
+		memcpy(newMemory, memory, oldSize < newSize ? oldSize : newSize);
+		free_pages_impl(memory, oldSize);
+	}
+
+	return newMemory;
+}
+
+void mst::_Details::free_pages_impl(void* memory, size_t size, bool hugePages) noexcept
+{
+	_MST_UNUSED(size);
+	_MST_UNUSED(hugePages);
+
+	VirtualFree(memory, 0, MEM_RELEASE);
+}
+
+bool mst::_Details::map_file_impl(
+	const char* path, bool copyOnWrite, void** data, size_t* size) noexcept
+{
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	*data = nullptr;
+	*size = static_cast<size_t>(fileSize.QuadPart);
+
+	if(*size == 0)
+	{
+		CloseHandle(file);
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingA(
+		file, nullptr, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+
+	CloseHandle(file);
+
+	if(mapping == nullptr)
+	{
+		return false;
+	}
+
+	// the view keeps the mapping and the file alive
+	*data = MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+
+	CloseHandle(mapping);
+
+	return *data != nullptr;
+}
+
+void mst::_Details::unmap_file_impl(void* data, size_t size) noexcept
+{
+	_MST_UNUSED(size);
+
+	UnmapViewOfFile(data);
+}
+
+void mst::_Details::advise_mapped_impl(void* data, size_t size, uint32_t hint) noexcept
+{
+	// only prefetching has a Windows equivalent
+#if _WIN32_WINNT >= 0x0602
+	if(hint == 3)
+	{
+		WIN32_MEMORY_RANGE_ENTRY range{ data, size };
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+#else
+	_MST_UNUSED(data);
+	_MST_UNUSED(size);
+	_MST_UNUSED(hint);
+#endif
+}
+
 static uint32_t get_processor_core_count_init() noexcept
 {
 	DWORD size = 0;
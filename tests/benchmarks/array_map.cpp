@@ -0,0 +1,240 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//      MST Utility Library                                                                 //
+//      Copyright (c)2026 Martinus Terpstra                                                 //
+//                                                                                          //
+//      Permission is hereby granted, free of charge, to any person obtaining a copy        //
+//      of this software and associated documentation files (the "Software"), to deal       //
+//      in the Software without restriction, including without limitation the rights        //
+//      to use, copy, modify, merge, publish, distribute, sublicense, and/or sell           //
+//      copies of the Software, and to permit persons to whom the Software is               //
+//      furnished to do so, subject to the following conditions:                            //
+//                                                                                          //
+//      The above copyright notice and this permission notice shall be included in          //
+//      all copies or substantial portions of the Software.                                 //
+//                                                                                          //
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR          //
+//      IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,            //
+//      FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE         //
+//      AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER              //
+//      LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,       //
+//      OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN           //
+//      THE SOFTWARE.                                                                       //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <set_assertions.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include <marray_map.h>
+#include <mflat_soa_map.h>
+
+using mst::array_map;
+
+// Benchmarks are hidden, run them with: test_benchmarks_array_map "[benchmark]"
+
+namespace {
+
+std::vector<std::pair<uint64_t, uint64_t>> random_pairs(size_t count, uint32_t seed)
+{
+	std::mt19937_64 rng(seed);
+	std::vector<std::pair<uint64_t, uint64_t>> pairs(count);
+	for(auto& pair : pairs)
+		pair = { rng(), rng() };
+	return pairs;
+}
+
+template<size_t Size>
+struct payload
+{
+	uint64_t bytes[Size / 8];
+};
+
+template<size_t ValueSize>
+void benchmark_layouts()
+{
+	constexpr size_t count = 250'000;
+	constexpr size_t lookupCount = 1'000'000;
+
+	const auto pairs = random_pairs(count, 3);
+	std::vector<std::pair<uint64_t, payload<ValueSize>>> payloadPairs(count);
+	for(size_t i = 0; i < count; ++i)
+		payloadPairs[i] = { pairs[i].first, payload<ValueSize>{ { pairs[i].second } } };
+
+	std::vector<uint64_t> lookups(lookupCount);
+	std::mt19937 rng(4);
+	for(auto& key : lookups)
+		key = pairs[rng() % count].first;
+
+	const array_map<uint64_t, payload<ValueSize>> aos(payloadPairs);
+	const mst::flat_soa_map<uint64_t, payload<ValueSize>> soa(payloadPairs);
+
+	const auto suffix = " (8 byte keys, " + std::to_string(ValueSize) + " byte values)";
+
+	BENCHMARK("array_map::find" + suffix)
+	{
+		uint64_t sum = 0;
+		for(const auto key : lookups)
+			sum += aos.find(key)->second.bytes[0];
+		return sum;
+	};
+
+	BENCHMARK("flat_soa_map::find" + suffix)
+	{
+		uint64_t sum = 0;
+		for(const auto key : lookups)
+			sum += soa.find(key)->second.bytes[0];
+		return sum;
+	};
+}
+
+} // namespace
+
+TEST_CASE("array_map: building from random keys", "[.][benchmark][array_map]")
+{
+	for(size_t count : { 20'000, 50'000, 500'000 })
+	{
+		const auto pairs = random_pairs(count, 1);
+		const auto suffix = " (" + std::to_string(count) + " keys)";
+
+		// quadratic, only measured for the smaller sizes
+		if(count <= 50'000)
+		{
+			BENCHMARK("insert loop" + suffix)
+			{
+				array_map<uint64_t, uint64_t> map;
+				for(const auto& pair : pairs)
+					map.insert(pair);
+				return map.size();
+			};
+		}
+
+		BENCHMARK("insert(first, last)" + suffix)
+		{
+			array_map<uint64_t, uint64_t> map;
+			map.insert(pairs.begin(), pairs.end());
+			return map.size();
+		};
+
+		BENCHMARK("construction from the unsorted vector" + suffix)
+		{
+			array_map<uint64_t, uint64_t> map(pairs);
+			return map.size();
+		};
+
+		BENCHMARK("insert(first, last) of 10% into a full map" + suffix)
+		{
+			array_map<uint64_t, uint64_t> map(pairs);
+			map.insert(pairs.begin(), pairs.begin() + count / 10);
+			const auto extra = random_pairs(count / 10, 2);
+			map.insert(extra.begin(), extra.end());
+			return map.size();
+		};
+	}
+}
+
+TEST_CASE("array_map: pair layout vs flat_soa_map lookups", "[.][benchmark][array_map]")
+{
+	benchmark_layouts<8>();
+	benchmark_layouts<32>();
+	benchmark_layouts<64>();
+	benchmark_layouts<256>();
+}
+
+TEST_CASE("array_map: frozen lookups", "[.][benchmark][array_map]")
+{
+	constexpr size_t lookupCount = 1'000'000;
+
+	for(size_t count : { 10'000, 1'000'000, 4'000'000 })
+	{
+		const auto pairs = random_pairs(count, 5);
+
+		std::vector<uint64_t> lookups(lookupCount);
+		std::mt19937_64 rng(6);
+		for(auto& key : lookups)
+			key = rng() % 2 ? pairs[rng() % count].first : rng();
+
+		array_map<uint64_t, uint64_t> map(pairs);
+		const auto suffix = " (" + std::to_string(count) + " keys)";
+
+		BENCHMARK("binary search find" + suffix)
+		{
+			size_t found = 0;
+			for(const auto key : lookups)
+				found += map.find(key) != map.end();
+			return found;
+		};
+
+		BENCHMARK("freeze" + suffix)
+		{
+			map.thaw();
+			map.freeze();
+			return map.size();
+		};
+
+		BENCHMARK("frozen find" + suffix)
+		{
+			size_t found = 0;
+			for(const auto key : lookups)
+				found += map.find(key) != map.end();
+			return found;
+		};
+
+		BENCHMARK("frozen lower_bound" + suffix)
+		{
+			uint64_t sum = 0;
+			for(const auto key : lookups)
+				sum += map.lower_bound(key) - map.begin();
+			return sum;
+		};
+	}
+}
+
+TEST_CASE("array_map: buffered inserts", "[.][benchmark][array_map]")
+{
+	// bursts of inserts, each followed by a burst of lookups of the keys inserted so far
+	constexpr size_t burstSize = 1'000;
+	constexpr size_t lookupsPerBurst = 1'000;
+
+	for(size_t count : { 50'000, 200'000 })
+	{
+		const auto pairs = random_pairs(count, 7);
+		const auto suffix = " (" + std::to_string(count) + " keys)";
+
+		const auto run = [&](auto insertFn) {
+			array_map<uint64_t, uint64_t> map;
+			std::mt19937 rng(8);
+			size_t found = 0;
+			for(size_t first = 0; first < count; first += burstSize)
+			{
+				for(size_t i = first; i < first + burstSize; ++i)
+					insertFn(map, pairs[i]);
+				for(size_t i = 0; i < lookupsPerBurst; ++i)
+					found += map.contains(pairs[rng() % (first + burstSize)].first);
+			}
+			return found;
+		};
+
+		// quadratic, only measured for the smaller size
+		if(count <= 50'000)
+		{
+			BENCHMARK("insert" + suffix)
+			{
+				return run([](auto& map, const auto& pair) { map.insert(pair); });
+			};
+		}
+
+		BENCHMARK("insert_buffered" + suffix)
+		{
+			return run([](auto& map, const auto& pair) { map.insert_buffered(pair); });
+		};
+	}
+}
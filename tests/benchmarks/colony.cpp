@@ -0,0 +1,522 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//      MST Utility Library                                                                 //
+//      Copyright (c)2026 Martinus Terpstra                                                 //
+//                                                                                          //
+//      Permission is hereby granted, free of charge, to any person obtaining a copy        //
+//      of this software and associated documentation files (the "Software"), to deal       //
+//      in the Software without restriction, including without limitation the rights        //
+//      to use, copy, modify, merge, publish, distribute, sublicense, and/or sell           //
+//      copies of the Software, and to permit persons to whom the Software is               //
+//      furnished to do so, subject to the following conditions:                            //
+//                                                                                          //
+//      The above copyright notice and this permission notice shall be included in          //
+//      all copies or substantial portions of the Software.                                 //
+//                                                                                          //
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR          //
+//      IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,            //
+//      FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE         //
+//      AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER              //
+//      LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,       //
+//      OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN           //
+//      THE SOFTWARE.                                                                       //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <set_assertions.h>
+
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <random>
+#include <mutex>
+#include <unordered_map>
+#include <mcolony.h>
+#include <mconcurrent_colony.h>
+#include <msoa_colony.h>
+#include <mexecutor.h>
+#include <mallocator.h>
+
+using mst::colony;
+
+// Benchmarks are hidden, run them with: test_benchmarks_colony "[benchmark]"
+
+namespace {
+
+struct particle
+{
+	float position[3];
+	float velocity[3];
+	float age;
+	float padding[9];
+};
+
+static_assert(sizeof(particle) == 64, "particle should fill a cache line");
+
+} // namespace
+
+TEST_CASE("colony<T>: parallel_foreach scaling", "[.][benchmark][colony]")
+{
+	colony<particle> particles;
+
+	for(int32_t i = 0; i < 4'000'000; ++i)
+	{
+		particles.emplace(particle{ { 0, 0, 0 }, { 1, 2, 3 }, 0, {} });
+	}
+
+	const auto update = [](particle& p) {
+		for(int i = 0; i < 3; ++i)
+		{
+			p.position[i] += p.velocity[i] * 0.016f;
+		}
+		p.age += 0.016f;
+	};
+
+	BENCHMARK("foreach")
+	{
+		particles.foreach(update);
+		return particles.size();
+	};
+
+	const auto maxThreads = std::max(std::thread::hardware_concurrency(), 1U);
+
+	// 1, 2, 4, ... threads, always ending with every hardware thread
+	for(uint32_t threads = 1;; threads = std::min(threads * 2, maxThreads))
+	{
+		mst::threading::thread_executor executor{ threads };
+
+		BENCHMARK("parallel_foreach, " + std::to_string(threads) + " threads")
+		{
+			particles.parallel_foreach(executor, update);
+			return particles.size();
+		};
+
+		if(threads == maxThreads)
+		{
+			break;
+		}
+	}
+}
+
+TEST_CASE("colony<T>: emplace_n vs emplace", "[.][benchmark][colony]")
+{
+	constexpr int32_t elementCount = 100'000;
+
+	const particle value{ { 0, 0, 0 }, { 1, 2, 3 }, 0, {} };
+
+	BENCHMARK("emplace x " + std::to_string(elementCount))
+	{
+		colony<particle> particles;
+		for(int32_t i = 0; i < elementCount; ++i)
+		{
+			particles.emplace(value);
+		}
+		return particles.size();
+	};
+
+	BENCHMARK("emplace_n(" + std::to_string(elementCount) + ")")
+	{
+		colony<particle> particles;
+		return particles.emplace_n(elementCount, value).size();
+	};
+
+	std::vector<particle> values(elementCount, value);
+
+	BENCHMARK("insert(first, last) of " + std::to_string(elementCount))
+	{
+		colony<particle> particles;
+		return particles.insert(values.begin(), values.end()).size();
+	};
+}
+
+TEST_CASE("colony<T>: foreach on a fragmented vs a compacted colony", "[.][benchmark][colony]")
+{
+	colony<particle> particles;
+
+	particles.emplace_n(2'000'000, particle{ { 0, 0, 0 }, { 1, 2, 3 }, 0, {} });
+
+	// 50% fragmentation, in small holes of random length
+	std::mt19937 rand;
+	for(int32_t i = 0; i < 2'000'000; i += 2)
+	{
+		const auto length = std::uniform_int_distribution<int32_t>(1, 4)(rand);
+		for(int32_t j = i; j < std::min(i + length, 2'000'000); ++j)
+		{
+			particles.erase(j);
+		}
+		i += length + length - 2;
+	}
+
+	const auto update = [](particle& p) {
+		for(int i = 0; i < 3; ++i)
+		{
+			p.position[i] += p.velocity[i] * 0.016f;
+		}
+	};
+
+	BENCHMARK("foreach, fragmented")
+	{
+		particles.foreach(update);
+		return particles.size();
+	};
+
+	BENCHMARK("iterators, fragmented")
+	{
+		float sum = 0;
+		for(auto& p : particles)
+		{
+			sum += p.position[0];
+		}
+		return sum;
+	};
+
+	particles.compact([](int32_t, int32_t) { });
+	particles.trim();
+
+	BENCHMARK("foreach, compacted")
+	{
+		particles.foreach(update);
+		return particles.size();
+	};
+
+	BENCHMARK("iterators, compacted")
+	{
+		float sum = 0;
+		for(auto& p : particles)
+		{
+			sum += p.position[0];
+		}
+		return sum;
+	};
+}
+
+TEST_CASE("colony<T>: iteration over size 1 holes", "[.][benchmark][colony]")
+{
+	colony<int32_t> values;
+
+	values.emplace_n(4'000'000, 1);
+
+	// every other element erased, the worst case for following the skips one slot at a time
+	for(int32_t i = 0; i < 4'000'000; i += 2)
+	{
+		values.erase(i);
+	}
+
+	BENCHMARK("foreach")
+	{
+		int64_t sum = 0;
+		values.foreach([&](int32_t value) { sum += value; });
+		return sum;
+	};
+
+	BENCHMARK("iterators")
+	{
+		int64_t sum = 0;
+		for(auto value : values)
+		{
+			sum += value;
+		}
+		return sum;
+	};
+}
+
+namespace {
+
+template<typename Colony>
+void benchmark_foreach(const std::string& name)
+{
+	Colony particles;
+
+	particles.emplace_n(4'000'000, particle{ { 0, 0, 0 }, { 1, 2, 3 }, 0, {} });
+
+	BENCHMARK("foreach, " + name)
+	{
+		particles.foreach([](particle& p) {
+			for(int i = 0; i < 3; ++i)
+			{
+				p.position[i] += p.velocity[i] * 0.016f;
+			}
+			p.age += 0.016f;
+		});
+		return particles.size();
+	};
+}
+
+} // namespace
+
+TEST_CASE("colony<T>: foreach with OS page and huge page backed pages", "[.][benchmark][colony]")
+{
+	// 8192 particles of 64 bytes, so every colony page is 512KB
+	benchmark_foreach<colony<particle, 8192>>("std::allocator");
+	benchmark_foreach<colony<particle, 8192, mst::page_allocator<particle>>>("page_allocator");
+	benchmark_foreach<colony<particle, 8192, mst::page_allocator<particle, true>>>(
+		"page_allocator with huge pages");
+}
+
+TEST_CASE("colony<T>: iteration over a run of empty pages", "[.][benchmark][colony]")
+{
+	// the run of empty pages is crossed in a single jump, so every gap should take as long
+	for(int32_t gapPages : { 16, 1024, 65536 })
+	{
+		colony<int32_t, 16> values;
+
+		const auto elementCount = (gapPages + 2) * 16;
+		values.emplace_n(elementCount, 1);
+
+		// erase the middle of the colony, leaving one element on either side of the gap
+		for(int32_t i = 1; i < elementCount - 1; ++i)
+		{
+			values.erase(i);
+		}
+
+		BENCHMARK("iterators, gap of " + std::to_string(gapPages) + " pages")
+		{
+			int64_t sum = 0;
+			for(auto value : values)
+			{
+				sum += value;
+			}
+			return sum;
+		};
+
+		BENCHMARK("foreach, gap of " + std::to_string(gapPages) + " pages")
+		{
+			int64_t sum = 0;
+			values.foreach([&](int32_t value) { sum += value; });
+			return sum;
+		};
+
+		values.trim();
+
+		BENCHMARK("iterators, gap of " + std::to_string(gapPages) + " released pages")
+		{
+			int64_t sum = 0;
+			for(auto value : values)
+			{
+				sum += value;
+			}
+			return sum;
+		};
+	}
+}
+
+TEST_CASE("colony<T>: erase_if vs erase", "[.][benchmark][colony]")
+{
+	constexpr int32_t elementCount = 1'000'000;
+
+	const auto pred = [](const particle& p) { return static_cast<int32_t>(p.age) % 3 != 0; };
+
+	const auto fill = [](colony<particle>& particles) {
+		for(int32_t i = 0; i < elementCount; ++i)
+		{
+			particles.emplace(particle{ { 0, 0, 0 }, { 1, 2, 3 }, static_cast<float>(i), {} });
+		}
+	};
+
+	// both include filling the colony, the difference is the cost of erasing two thirds of it
+	BENCHMARK("erase in a loop")
+	{
+		colony<particle> particles;
+		fill(particles);
+
+		for(auto it = particles.begin(); it != particles.end();)
+		{
+			if(pred(*it))
+			{
+				it = particles.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+		return particles.size();
+	};
+
+	BENCHMARK("erase_if")
+	{
+		colony<particle> particles;
+		fill(particles);
+
+		return particles.erase_if(pred);
+	};
+}
+
+TEST_CASE("colony<T>: concurrent_colony vs colony behind a mutex", "[.][benchmark][colony]")
+{
+	constexpr int32_t rounds = 20'000;
+	constexpr int32_t batchSize = 16;
+
+	// every thread creates and destroys short lived objects in the shared pool
+	const auto churn = [](uint32_t threadCount, auto&& emplace, auto&& erase) {
+		std::vector<std::thread> threads;
+		for(uint32_t t = 0; t < threadCount; ++t)
+		{
+			threads.emplace_back([&] {
+				int32_t indices[batchSize];
+				for(int32_t round = 0; round < rounds; ++round)
+				{
+					for(auto& index : indices)
+					{
+						index = emplace(round);
+					}
+					for(const auto index : indices)
+					{
+						erase(index);
+					}
+				}
+			});
+		}
+		for(auto& thread : threads)
+		{
+			thread.join();
+		}
+	};
+
+	const auto maxThreads = std::max(std::thread::hardware_concurrency(), 1U);
+
+	for(uint32_t threads = 1;; threads = std::min(threads * 2, maxThreads))
+	{
+		BENCHMARK("colony + std::mutex, " + std::to_string(threads) + " threads")
+		{
+			colony<int64_t> pool;
+			std::mutex mutex;
+
+			churn(
+				threads,
+				[&](int64_t value) {
+					std::lock_guard<std::mutex> lock(mutex);
+					return pool.emplace(value).idx();
+				},
+				[&](int32_t index) {
+					std::lock_guard<std::mutex> lock(mutex);
+					pool.erase(index);
+				});
+
+			return pool.size();
+		};
+
+		BENCHMARK("concurrent_colony, " + std::to_string(threads) + " threads")
+		{
+			mst::concurrent_colony<int64_t> pool;
+
+			churn(
+				threads, [&](int64_t value) { return pool.emplace(value); },
+				[&](int32_t index) { pool.erase(index); });
+
+			return pool.size();
+		};
+
+		if(threads == maxThreads)
+		{
+			break;
+		}
+	}
+}
+
+TEST_CASE("colony<T>: handle lookup vs an id map", "[.][benchmark][colony]")
+{
+	constexpr int32_t elementCount = 1'000'000;
+
+	colony<particle> particles;
+
+	std::vector<colony<particle>::handle> handles;
+	std::vector<uint64_t> ids;
+	std::unordered_map<uint64_t, int32_t> idToIndex;
+
+	for(int32_t i = 0; i < elementCount; ++i)
+	{
+		const auto it = particles.emplace(particle{ { 0, 0, 0 }, { 1, 2, 3 }, 0, {} });
+
+		handles.push_back(particles.get_handle(it));
+		ids.push_back(uint64_t(i) * 2654435761u);
+		idToIndex.emplace(ids.back(), it.idx());
+	}
+
+	std::mt19937 rand;
+	std::shuffle(handles.begin(), handles.end(), rand);
+	std::shuffle(ids.begin(), ids.end(), rand);
+
+	BENCHMARK("unordered_map id -> index")
+	{
+		float sum = 0;
+		for(const auto id : ids)
+		{
+			const auto it = idToIndex.find(id);
+			if(it != idToIndex.end())
+			{
+				sum += particles[it->second].age;
+			}
+		}
+		return sum;
+	};
+
+	BENCHMARK("get(handle)")
+	{
+		float sum = 0;
+		for(const auto handle : handles)
+		{
+			if(const auto p = particles.get(handle))
+			{
+				sum += p->age;
+			}
+		}
+		return sum;
+	};
+}
+
+TEST_CASE("colony<T>: soa_colony vs colony updating a few fields", "[.][benchmark][colony]")
+{
+	constexpr int32_t elementCount = 2'000'000;
+
+	colony<particle> particles;
+	mst::soa_colony<float, float, float, float, float> columns; // x, vx, y, vy, age
+
+	for(int32_t i = 0; i < elementCount; ++i)
+	{
+		particles.emplace(particle{ { 0, 0, 0 }, { 1, 2, 3 }, 0, {} });
+		columns.emplace(0.0f, 1.0f, 0.0f, 2.0f, 0.0f);
+	}
+
+	// with holes, so the runs are not whole pages
+	for(int32_t i = 0; i < elementCount; i += 7)
+	{
+		particles.erase(i);
+		columns.erase(i);
+	}
+
+	BENCHMARK("colony, foreach")
+	{
+		particles.foreach([](particle& p) {
+			p.position[0] += p.velocity[0] * 0.016f;
+			p.position[1] += p.velocity[1] * 0.016f;
+		});
+		return particles.size();
+	};
+
+	BENCHMARK("soa_colony, foreach")
+	{
+		columns.foreach([](float& x, float vx, float& y, float vy, float) {
+			x += vx * 0.016f;
+			y += vy * 0.016f;
+		});
+		return columns.size();
+	};
+
+	BENCHMARK("soa_colony, foreach_run")
+	{
+		columns.foreach_run([](int32_t, int32_t count, float* x, float* vx, float* y, float* vy,
+								float*) {
+			for(int32_t i = 0; i < count; ++i)
+			{
+				x[i] += vx[i] * 0.016f;
+				y[i] += vy[i] * 0.016f;
+			}
+		});
+		return columns.size();
+	};
+}
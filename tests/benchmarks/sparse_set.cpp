@@ -0,0 +1,365 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//      MST Utility Library                                                                 //
+//      Copyright (c)2026 Martinus Terpstra                                                 //
+//                                                                                          //
+//      Permission is hereby granted, free of charge, to any person obtaining a copy        //
+//      of this software and associated documentation files (the "Software"), to deal       //
+//      in the Software without restriction, including without limitation the rights        //
+//      to use, copy, modify, merge, publish, distribute, sublicense, and/or sell           //
+//      copies of the Software, and to permit persons to whom the Software is               //
+//      furnished to do so, subject to the following conditions:                            //
+//                                                                                          //
+//      The above copyright notice and this permission notice shall be included in          //
+//      all copies or substantial portions of the Software.                                 //
+//                                                                                          //
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR          //
+//      IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,            //
+//      FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE         //
+//      AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER              //
+//      LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,       //
+//      OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN           //
+//      THE SOFTWARE.                                                                       //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <set_assertions.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include <msparse_set.h>
+#include <mexecutor.h>
+
+using mst::sparse_set;
+
+// Benchmarks are hidden, run them with: test_benchmarks_sparse_set "[benchmark]"
+
+namespace {
+
+struct vec3
+{
+	float x, y, z;
+};
+
+// emplaces a random fraction of the ids 0..count-1 in random order
+template<typename T>
+void fill_random(sparse_set<T, uint32_t>& set, uint32_t count, double fraction, uint32_t seed)
+{
+	std::vector<uint32_t> ids(count);
+	std::iota(ids.begin(), ids.end(), 0u);
+	std::mt19937 rng(seed);
+	std::shuffle(ids.begin(), ids.end(), rng);
+
+	ids.resize(static_cast<size_t>(count * fraction));
+	for(auto id : ids)
+		set.emplace(id, T{});
+}
+
+} // namespace
+
+TEST_CASE("sparse_set: batch emplace and erase of 100k random ids", "[.][benchmark][sparse_set]")
+{
+	constexpr size_t count = 100'000;
+
+	for(uint32_t idSpace : { 200'000u, 4'000'000u, 64'000'000u })
+	{
+		std::vector<uint32_t> ids(idSpace);
+		std::iota(ids.begin(), ids.end(), 0u);
+		std::mt19937 rng(7);
+		std::shuffle(ids.begin(), ids.end(), rng);
+		ids.resize(count);
+
+		const std::vector<vec3> values(count, vec3{ 1, 2, 3 });
+
+		const auto suffix = " (ids < " + std::to_string(idSpace) + ")";
+
+		BENCHMARK("emplace loop" + suffix)
+		{
+			sparse_set<vec3, uint32_t> set;
+			for(size_t i = 0; i < count; ++i)
+				set.emplace(ids[i], values[i]);
+			return set.size();
+		};
+
+		BENCHMARK("emplace_batch" + suffix)
+		{
+			sparse_set<vec3, uint32_t> set;
+			set.emplace_batch(ids, values);
+			return set.size();
+		};
+
+		sparse_set<vec3, uint32_t> filled;
+		filled.emplace_batch(ids, values);
+
+		BENCHMARK("emplace_batch + erase loop" + suffix)
+		{
+			sparse_set<vec3, uint32_t> set;
+			set.emplace_batch(ids, values);
+			for(auto id : ids)
+				set.erase(id);
+			return set.size();
+		};
+
+		BENCHMARK("emplace_batch + erase_batch" + suffix)
+		{
+			sparse_set<vec3, uint32_t> set;
+			set.emplace_batch(ids, values);
+			set.erase_batch(ids);
+			return set.size();
+		};
+	}
+}
+
+TEST_CASE("sparse_view: join over 1M entities", "[.][benchmark][sparse_set]")
+{
+	constexpr uint32_t entityCount = 1'000'000;
+
+	for(double overlap : { 1.0, 0.5, 0.1 })
+	{
+		sparse_set<vec3, uint32_t> positions;
+		sparse_set<vec3, uint32_t> velocities;
+		sparse_set<float, uint32_t> masses;
+
+		fill_random(positions, entityCount, 1.0, 1);
+		fill_random(velocities, entityCount, overlap, 2);
+		fill_random(masses, entityCount, std::min(1.0, overlap * 2), 3);
+
+		const auto suffix = " (overlap " + std::to_string(overlap).substr(0, 3) + ")";
+
+		BENCHMARK("contains/at loop" + suffix)
+		{
+			float sum = 0;
+			for(auto& [index, velocity] : velocities)
+			{
+				if(!positions.contains(index) || !masses.contains(index))
+					continue;
+
+				auto& position = positions.at(index);
+				position.x += velocity.x * masses.at(index);
+				sum += position.x;
+			}
+			return sum;
+		};
+
+		BENCHMARK("sparse_view::each" + suffix)
+		{
+			float sum = 0;
+			mst::sparse_view(positions, velocities, masses)
+				.each([&](uint32_t, vec3& position, const vec3& velocity, float mass) {
+					position.x += velocity.x * mass;
+					sum += position.x;
+				});
+			return sum;
+		};
+
+		BENCHMARK("sparse_view iterator" + suffix)
+		{
+			float sum = 0;
+			for(auto [index, position, velocity, mass] :
+				mst::sparse_view(positions, velocities, masses))
+			{
+				position.x += velocity.x * mass;
+				sum += position.x;
+			}
+			return sum;
+		};
+	}
+}
+
+TEST_CASE("sparse_group: join over 1M entities", "[.][benchmark][sparse_set]")
+{
+	constexpr uint32_t entityCount = 1'000'000;
+
+	for(double overlap : { 1.0, 0.5, 0.1 })
+	{
+		sparse_set<vec3, uint32_t> positions;
+		sparse_set<vec3, uint32_t> velocities;
+		sparse_set<float, uint32_t> masses;
+
+		fill_random(positions, entityCount, 1.0, 1);
+		fill_random(velocities, entityCount, overlap, 2);
+		fill_random(masses, entityCount, std::min(1.0, overlap * 2), 3);
+
+		const auto suffix = " (overlap " + std::to_string(overlap).substr(0, 3) + ")";
+
+		BENCHMARK("sparse_view::each" + suffix)
+		{
+			float sum = 0;
+			mst::sparse_view(positions, velocities, masses)
+				.each([&](uint32_t, vec3& position, const vec3& velocity, float mass) {
+					position.x += velocity.x * mass;
+					sum += position.x;
+				});
+			return sum;
+		};
+
+		mst::sparse_group group(positions, velocities, masses);
+
+		BENCHMARK("sparse_group::each" + suffix)
+		{
+			float sum = 0;
+			group.each([&](uint32_t, vec3& position, const vec3& velocity, float mass) {
+				position.x += velocity.x * mass;
+				sum += position.x;
+			});
+			return sum;
+		};
+
+		BENCHMARK("erase and emplace 1000 grouped entities" + suffix)
+		{
+			for(uint32_t index = 0; index < 1000; ++index)
+			{
+				if(velocities.contains(index))
+				{
+					velocities.erase(index);
+					velocities.emplace(index, vec3{});
+				}
+			}
+			return group.size();
+		};
+	}
+}
+
+TEST_CASE("sparse_set: lookups after sort and respect", "[.][benchmark][sparse_set]")
+{
+	constexpr uint32_t entityCount = 1'000'000;
+
+	sparse_set<vec3, uint32_t> positions;
+	sparse_set<vec3, uint32_t> velocities;
+	fill_random(positions, entityCount, 1.0, 1);
+	fill_random(velocities, entityCount, 1.0, 2);
+
+	const auto walk = [&] {
+		float sum = 0;
+		for(auto& [index, velocity] : velocities)
+		{
+			auto& position = positions.at(index);
+			position.x += velocity.x;
+			sum += position.x;
+		}
+		return sum;
+	};
+
+	BENCHMARK("insertion order")
+	{
+		return walk();
+	};
+
+	BENCHMARK("sort")
+	{
+		positions.sort();
+		return positions.size();
+	};
+
+	velocities.sort();
+
+	BENCHMARK("both sorted by index")
+	{
+		return walk();
+	};
+
+	BENCHMARK("respect")
+	{
+		positions.respect(velocities);
+		return positions.size();
+	};
+
+	BENCHMARK("lockstep after respect")
+	{
+		float sum = 0;
+		auto position = positions.begin();
+		for(auto& [index, velocity] : velocities)
+		{
+			position->second.x += velocity.x;
+			sum += position->second.x;
+			++position;
+		}
+		return sum;
+	};
+}
+
+TEST_CASE("sparse_set: parallel_for_each", "[.][benchmark][sparse_set]")
+{
+	constexpr uint32_t entityCount = 4'000'000;
+
+	sparse_set<vec3, uint32_t> positions;
+	fill_random(positions, entityCount, 1.0, 1);
+
+	const auto update = [](auto& elem) {
+		elem.second.x += elem.second.y * 0.5f;
+		elem.second.z += elem.second.x * 0.25f;
+	};
+
+	BENCHMARK("begin/end loop")
+	{
+		for(auto& elem : positions)
+			update(elem);
+		return positions.begin()->second.x;
+	};
+
+	BENCHMARK("for_each_chunk(4096)")
+	{
+		positions.for_each_chunk(4096, [&](auto range) {
+			for(auto& elem : range)
+				update(elem);
+		});
+		return positions.begin()->second.x;
+	};
+
+	mst::threading::thread_executor executor;
+
+	BENCHMARK("parallel_for_each(thread_executor)")
+	{
+		positions.parallel_for_each(executor, update);
+		return positions.begin()->second.x;
+	};
+}
+
+TEST_CASE("sparse_set: versioned lookups", "[.][benchmark][sparse_set]")
+{
+	constexpr uint32_t entityCount = 1'000'000;
+	const auto id = [](uint32_t index, uint32_t version) { return (version << 24) | index; };
+
+	std::vector<uint32_t> queries(entityCount);
+	std::vector<uint8_t> generations(entityCount);
+	sparse_set<vec3, uint32_t> unversioned;
+	sparse_set<vec3, uint32_t, 32768, mst::sparse_set_traits<8>> versioned;
+
+	std::mt19937 rng(11);
+	for(uint32_t i = 0; i < entityCount; ++i)
+	{
+		generations[i] = static_cast<uint8_t>(rng());
+		unversioned.emplace(i, vec3{});
+		versioned.emplace(id(i, generations[i]), vec3{});
+	}
+	// a quarter of the queries use a stale version
+	for(auto& query : queries)
+	{
+		const auto index = rng() % entityCount;
+		query = id(index, generations[index] + (rng() % 4 == 0));
+	}
+
+	BENCHMARK("contains + generation table")
+	{
+		size_t found = 0;
+		for(const auto query : queries)
+		{
+			const auto index = query & 0xFFFFFF;
+			found += unversioned.contains(index) && generations[index] == (query >> 24);
+		}
+		return found;
+	};
+
+	BENCHMARK("versioned contains")
+	{
+		size_t found = 0;
+		for(const auto query : queries)
+			found += versioned.contains(query);
+		return found;
+	};
+}
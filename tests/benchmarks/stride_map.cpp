@@ -0,0 +1,249 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//      MST Utility Library                                                                 //
+//      Copyright (c)2026 Martinus Terpstra                                                 //
+//                                                                                          //
+//      Permission is hereby granted, free of charge, to any person obtaining a copy        //
+//      of this software and associated documentation files (the "Software"), to deal       //
+//      in the Software without restriction, including without limitation the rights        //
+//      to use, copy, modify, merge, publish, distribute, sublicense, and/or sell           //
+//      copies of the Software, and to permit persons to whom the Software is               //
+//      furnished to do so, subject to the following conditions:                            //
+//                                                                                          //
+//      The above copyright notice and this permission notice shall be included in          //
+//      all copies or substantial portions of the Software.                                 //
+//                                                                                          //
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR          //
+//      IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,            //
+//      FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE         //
+//      AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER              //
+//      LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,       //
+//      OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN           //
+//      THE SOFTWARE.                                                                       //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <set_assertions.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <mstride_map.h>
+#include <mmapped_stride_map.h>
+#include <mplatform.h>
+#include <mexecutor.h>
+
+// Benchmarks are hidden, run them with: test_benchmarks_stride_map "[benchmark]"
+
+namespace {
+
+struct vertex
+{
+	float position[3];
+	float normal[3];
+	float uv[2];
+	int material;
+	float padding[7];
+};
+
+static_assert(sizeof(vertex) == 64, "vertex should fill a cache line");
+
+} // namespace
+
+TEST_CASE("stride_map: gather a field vs a per element loop", "[.][benchmark][stride_map]")
+{
+	constexpr size_t count = 1'000'000;
+
+	mst::stride_map vertices(sizeof(vertex), count);
+	for(size_t i = 0; i < count; ++i)
+		vertices.index<vertex>(i).material = (int)i;
+
+	std::vector<int> materials(count);
+
+	BENCHMARK("index<vertex>(i).material loop")
+	{
+		for(size_t i = 0; i < count; ++i)
+			materials[i] = vertices.index<vertex>(i).material;
+		return materials.back();
+	};
+
+	BENCHMARK("gather(offsetof(vertex, material))")
+	{
+		vertices.gather(offsetof(vertex, material), materials.data());
+		return materials.back();
+	};
+
+	BENCHMARK("scatter(offsetof(vertex, material))")
+	{
+		vertices.scatter(offsetof(vertex, material), materials.data());
+		return vertices.back<vertex>().material;
+	};
+
+	std::vector<double> uvs(count);
+
+	BENCHMARK("index<vertex>(i).uv loop")
+	{
+		for(size_t i = 0; i < count; ++i)
+			memcpy(&uvs[i], vertices.index<vertex>(i).uv, sizeof(double));
+		return uvs.back();
+	};
+
+	BENCHMARK("gather(offsetof(vertex, uv))")
+	{
+		vertices.gather(offsetof(vertex, uv), uvs.data());
+		return uvs.back();
+	};
+}
+
+TEST_CASE("stride_map: push_back growth of a large map", "[.][benchmark][stride_map]")
+{
+	// past MST_STRIDE_MAP_MREMAP_THRESHOLD every doubling is a remap instead of a copy
+	constexpr size_t count = 4'000'000;
+
+	BENCHMARK("push_back<vertex> x 4M")
+	{
+		mst::stride_map vertices(sizeof(vertex));
+		for(size_t i = 0; i < count; ++i)
+			vertices.push_back();
+		return vertices.size();
+	};
+
+	BENCHMARK("64 byte aligned push_back<vertex> x 4M")
+	{
+		mst::stride_map vertices(sizeof(vertex), 0, 64);
+		for(size_t i = 0; i < count; ++i)
+			vertices.push_back();
+		return vertices.size();
+	};
+
+	BENCHMARK("reserve + push_back<vertex> x 4M")
+	{
+		mst::stride_map vertices(sizeof(vertex));
+		vertices.reserve(count);
+		for(size_t i = 0; i < count; ++i)
+			vertices.push_back();
+		return vertices.size();
+	};
+}
+
+TEST_CASE("stride_map: loading a record file vs mapping it", "[.][benchmark][stride_map]")
+{
+	constexpr size_t count = 1'000'000;
+
+	const std::string path = mst::platform::temp_path() + mst::platform::directory_separator() +
+		"mst_stride_map_benchmark.bin";
+	{
+		std::vector<vertex> vertices(count);
+		FILE* file = fopen(path.c_str(), "wb");
+		REQUIRE(file != nullptr);
+		fwrite(vertices.data(), sizeof(vertex), count, file);
+		fclose(file);
+	}
+
+	BENCHMARK("fread into a stride_map")
+	{
+		mst::stride_map vertices(sizeof(vertex), count);
+		FILE* file = fopen(path.c_str(), "rb");
+		const size_t read = fread(vertices.data(), sizeof(vertex), count, file);
+		fclose(file);
+		return read;
+	};
+
+	BENCHMARK("mapped_stride_map open")
+	{
+		mst::mapped_stride_map vertices(path.c_str(), sizeof(vertex));
+		return vertices.size();
+	};
+
+	BENCHMARK("mapped_stride_map open + read every record")
+	{
+		mst::mapped_stride_map vertices(path.c_str(), sizeof(vertex), mst::map_mode::read_only,
+			mst::map_access_hint::sequential);
+		int sum = 0;
+		for(const vertex& v : mst::range<vertex>(vertices))
+			sum += v.material;
+		return sum;
+	};
+
+	std::remove(path.c_str());
+}
+
+namespace {
+
+struct sort_record
+{
+	uint32_t key;
+	float data[11];
+};
+
+static_assert(sizeof(sort_record) == 48, "sort_record should be 48 bytes");
+
+} // namespace
+
+TEST_CASE("stride_map: sort_by_key vs std::sort", "[.][benchmark][stride_map]")
+{
+	constexpr size_t count = 1'000'000;
+
+	std::mt19937 rng(42);
+	std::vector<sort_record> source(count);
+	for(auto& record : source)
+		record.key = rng();
+
+	BENCHMARK("std::sort std::vector<48 byte record> by key")
+	{
+		auto records = source;
+		std::sort(records.begin(), records.end(),
+			[](const sort_record& a, const sort_record& b) { return a.key < b.key; });
+		return records.front().key;
+	};
+
+	BENCHMARK("stride_map::sort_by_key<uint32_t>")
+	{
+		mst::stride_map records(sizeof(sort_record), count);
+		memcpy(records.data(), source.data(), records.data_size());
+		records.sort_by_key<uint32_t>(offsetof(sort_record, key));
+		return records.front<sort_record>().key;
+	};
+
+	BENCHMARK("stride_map::sort_by_key<uint32_t>(offset, less)")
+	{
+		mst::stride_map records(sizeof(sort_record), count);
+		memcpy(records.data(), source.data(), records.data_size());
+		records.sort_by_key<uint32_t>(
+			offsetof(sort_record, key), [](uint32_t a, uint32_t b) { return a < b; });
+		return records.front<sort_record>().key;
+	};
+}
+
+TEST_CASE("stride_map: parallel_transform", "[.][benchmark][stride_map]")
+{
+	constexpr size_t count = 4'000'000;
+
+	mst::stride_map vertices(sizeof(vertex), count);
+	memset(vertices.data(), 0, vertices.data_size());
+
+	const auto update = [](vertex& v) {
+		for(int i = 0; i < 3; ++i)
+			v.position[i] += v.normal[i] * 0.5f;
+	};
+
+	BENCHMARK("begin/end loop")
+	{
+		for(auto it = vertices.begin<vertex>(); it != vertices.end<vertex>(); ++it)
+			update(*it);
+		return vertices.front<vertex>().position[0];
+	};
+
+	mst::threading::thread_executor executor;
+
+	BENCHMARK("parallel_transform(thread_executor)")
+	{
+		vertices.parallel_transform<vertex>(executor, update);
+		return vertices.front<vertex>().position[0];
+	};
+}
@@ -526,3 +526,229 @@ TEST_CASE("array_map<K,V>: many out-of-order insertions produce a sorted map", "
 		REQUIRE(am.at(key) == key * 2);
 	}
 }
+
+TEST_CASE("array_map<K,V>: insert(first, last) merges a range in one pass", "[array_map]")
+{
+	array_map<int, int> am = {
+		{ 10, 100 },
+		{ 20, 200 },
+	};
+
+	std::vector<std::pair<int, int>> pairs = {
+		{ 30, 300 }, { 5, 50 }, { 20, -1 }, { 15, 150 }, { 5, -1 }, { 25, 250 },
+	};
+	am.insert(pairs.begin(), pairs.end());
+
+	// existing keys and the first of duplicate keys win, like with insert()
+	REQUIRE(am.size() == 6);
+	REQUIRE(am.at(5) == 50);
+	REQUIRE(am.at(20) == 200);
+	REQUIRE(am.at(30) == 300);
+	for(size_t i = 1; i < am.size(); ++i)
+	{
+		REQUIRE(am.get_key(i - 1) < am.get_key(i));
+	}
+
+	am.insert(pairs.begin(), pairs.begin());
+	REQUIRE(am.size() == 6);
+}
+
+TEST_CASE("array_map<K,V>: insert_sorted_unique and appending past the last key", "[array_map]")
+{
+	array_map<int, int> am;
+
+	std::vector<std::pair<int, int>> low = { { 1, 1 }, { 3, 3 }, { 5, 5 } };
+	std::vector<std::pair<int, int>> high = { { 7, 7 }, { 9, 9 } };
+	std::vector<std::pair<int, int>> mixed = { { 2, 2 }, { 3, -1 }, { 8, 8 }, { 10, 10 } };
+
+	am.insert_sorted_unique(low.begin(), low.end());
+	am.insert_sorted_unique(high.begin(), high.end());
+	am.insert_sorted_unique(mixed.begin(), mixed.end());
+
+	REQUIRE(am.size() == 8);
+	REQUIRE(am.at(3) == 3);
+	const int expected[] = { 1, 2, 3, 5, 7, 8, 9, 10 };
+	for(size_t i = 0; i < am.size(); ++i)
+	{
+		REQUIRE(am.get_key(i) == expected[i]);
+	}
+}
+
+TEST_CASE("array_map<K,V>: construction from an unsorted vector", "[array_map]")
+{
+	std::mt19937 rng(99);
+	std::vector<std::pair<int, int>> pairs;
+	for(int i = 0; i < 1000; ++i)
+	{
+		const int key = (int)(rng() % 500);
+		pairs.emplace_back(key, i);
+	}
+
+	array_map<int, int> am(pairs);
+
+	std::vector<int> firstValue(500, -1);
+	for(const auto& [key, value] : pairs)
+	{
+		if(firstValue[key] == -1)
+			firstValue[key] = value;
+	}
+
+	size_t expectedSize = 0;
+	for(int key = 0; key < 500; ++key)
+	{
+		if(firstValue[key] == -1)
+		{
+			REQUIRE(!am.contains(key));
+			continue;
+		}
+		REQUIRE(am.at(key) == firstValue[key]);
+		++expectedSize;
+	}
+	REQUIRE(am.size() == expectedSize);
+}
+
+TEST_CASE("array_map<K,V>: frozen lookups match the binary search", "[array_map]")
+{
+	for(size_t count : { 0, 1, 2, 7, 8, 9, 100, 1000 })
+	{
+		std::vector<std::pair<int, int>> pairs;
+		for(size_t i = 0; i < count; ++i)
+			pairs.emplace_back((int)i * 3, (int)i);
+
+		array_map<int, int> plain(pairs);
+		array_map<int, int> frozen(pairs);
+		frozen.freeze();
+		REQUIRE(frozen.is_frozen());
+
+		const auto& cfrozen = frozen;
+		for(int key = -2; key < (int)count * 3 + 2; ++key)
+		{
+			const auto lower = plain.lower_bound(key) - plain.begin();
+			const auto upper = plain.upper_bound(key) - plain.begin();
+			REQUIRE(frozen.lower_bound(key) - frozen.begin() == lower);
+			REQUIRE(cfrozen.upper_bound(key) - cfrozen.begin() == upper);
+			REQUIRE(frozen.contains(key) == plain.contains(key));
+			REQUIRE((cfrozen.find(key) == cfrozen.end()) == (plain.find(key) == plain.end()));
+		}
+	}
+}
+
+TEST_CASE("array_map<K,V>: a frozen map stays frozen through mutations", "[array_map]")
+{
+	array_map<int, int, std::greater<int>> am = {
+		{ 1, 10 },
+		{ 3, 30 },
+	};
+	am.freeze();
+
+	am[2] = 20;
+	am.insert(std::make_pair(5, 50));
+	std::vector<std::pair<int, int>> more = { { 4, 40 }, { 0, 0 } };
+	am.insert(more.begin(), more.end());
+	am.erase(3);
+
+	REQUIRE(am.is_frozen());
+	for(int key : { 0, 1, 2, 4, 5 })
+	{
+		REQUIRE(am.contains(key));
+		REQUIRE(am.at(key) == key * 10);
+	}
+	REQUIRE(!am.contains(3));
+	REQUIRE(am.lower_bound(3)->first == 2);
+
+	auto copy = am;
+	REQUIRE(copy.is_frozen());
+	REQUIRE(copy.at(4) == 40);
+
+	am.clear();
+	REQUIRE(am.is_frozen());
+	REQUIRE(!am.contains(1));
+	REQUIRE(am.find(1) == am.end());
+
+	copy.thaw();
+	REQUIRE(!copy.is_frozen());
+	REQUIRE(copy.at(5) == 50);
+}
+
+TEST_CASE("array_map<K,V>: buffered inserts", "[array_map]")
+{
+	array_map<int, int> am = {
+		{ 10, 100 },
+		{ 30, 300 },
+	};
+
+	am.insert_buffered(std::make_pair(20, 200));
+	am.insert_buffered(std::make_pair(5, 50));
+	am.insert_buffered(std::make_pair(10, 0)); // already in the map
+	am.insert_buffered(std::make_pair(5, 0)); // already buffered
+
+	REQUIRE(am.size() == 4);
+	REQUIRE(am.buffered_size() == 2);
+	REQUIRE(am.at(20) == 200);
+	REQUIRE(am.at(5) == 50);
+	REQUIRE(am.at(10) == 100);
+	REQUIRE(am.contains(30));
+	REQUIRE(!am.contains(15));
+	REQUIRE(am.find(15) == am.end());
+	REQUIRE(am.find(20)->second == 200);
+
+	am.erase(5);
+	REQUIRE(am.buffered_size() == 1);
+	am.erase(30);
+	REQUIRE(am.buffered_size() == 1);
+	REQUIRE(am.at(20) == 200);
+
+	am.consolidate();
+	REQUIRE(am.buffered_size() == 0);
+	std::vector<int> keys;
+	for(const auto& pair : am)
+		keys.push_back(pair.first);
+	REQUIRE(keys == std::vector<int>{ 10, 20 });
+
+	// plain inserts merge the buffer first
+	am.insert_buffered(std::make_pair(15, 150));
+	am[12] = 120;
+	REQUIRE(am.buffered_size() == 0);
+	REQUIRE(am.begin()[1].first == 12);
+	REQUIRE(am.begin()[2].first == 15);
+}
+
+TEST_CASE("array_map<K,V>: buffered inserts merge as the buffer grows", "[array_map]")
+{
+	array_map<int, int> am;
+	array_map<int, int> frozen;
+	frozen.freeze();
+
+	std::vector<int> keys;
+	for(int i = 0; i < 5000; ++i)
+		keys.push_back((i * 7919) % 5000);
+
+	size_t maxBuffered = 0;
+	for(size_t i = 0; i < keys.size(); ++i)
+	{
+		am.insert_buffered(std::make_pair(keys[i], keys[i] * 2));
+		frozen.insert_buffered(std::make_pair(keys[i], keys[i] * 2));
+		maxBuffered = std::max(maxBuffered, am.buffered_size());
+
+		if(i % 97 == 0)
+		{
+			REQUIRE(am.contains(keys[i]));
+			REQUIRE(frozen.at(keys[i]) == keys[i] * 2);
+			REQUIRE(frozen.at(keys[i / 2]) == keys[i / 2] * 2);
+			REQUIRE(!frozen.contains(5000 + (int)i));
+		}
+	}
+
+	REQUIRE(maxBuffered > 32);
+	REQUIRE(maxBuffered * maxBuffered <= 2 * am.size());
+
+	frozen.freeze();
+	REQUIRE(frozen.buffered_size() == 0);
+	am.consolidate();
+	REQUIRE(am.size() == 5000);
+	for(int i = 0; i < 5000; ++i)
+	{
+		REQUIRE(am.get_key((size_t)i) == i);
+		REQUIRE(frozen.lower_bound(i)->second == i * 2);
+	}
+}
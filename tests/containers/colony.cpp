@@ -28,8 +28,17 @@
 #include <set_assertions.h>
 #include <random_data_generator.h>
 
+#include <set>
+#include <atomic>
 #include <vector>
+#include <string>
+#include <sstream>
+#include <iterator>
+#include <stdexcept>
 #include <mcolony.h>
+#include <mexecutor.h>
+#include <mallocator.h>
+#include <mplatform.h>
 
 using mst::colony;
 using namespace mst::test_util;
@@ -230,4 +239,997 @@ TEST_CASE("colony<T>: clear and expand", "[colony]")
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+
+TEST_CASE("colony<T>: iteration and erase across page boundaries", "[colony]")
+{
+	random_data_generator rdg{ true };
+	INFO("Seed" << rdg.seed());
+
+	colony<int32_t, 16> container;
+	std::set<int32_t> indices;
+
+	for(int32_t i = 0; i < 16 * 8; ++i)
+	{
+		const auto it = container.emplace(i);
+		REQUIRE(it.idx() == i);
+		indices.insert(i);
+	}
+
+	REQUIRE(container.capacity() == 16 * 8);
+
+	// empty out page 2 and 3 entirely, and punch holes in the page boundaries of the others
+	for(int32_t i = 32; i < 64; ++i)
+	{
+		container.erase(i);
+		indices.erase(i);
+	}
+
+	for(int32_t page = 0; page < 8; ++page)
+	{
+		const auto first = page * 16;
+		if(indices.count(first))
+		{
+			container.erase(first);
+			indices.erase(first);
+		}
+		if(indices.count(first + 15))
+		{
+			container.erase(first + 15);
+			indices.erase(first + 15);
+		}
+	}
+
+	for(int i = 0; i < 20; ++i)
+	{
+		const auto index = *std::next(
+			indices.begin(), (ptrdiff_t)rdg.scalar_int<size_t>(0, indices.size() - 1));
+
+		const auto next = indices.upper_bound(index);
+		const auto nextIndex = container.erase(index);
+
+		REQUIRE(nextIndex == (next == indices.end() ? (int32_t)container.capacity() : *next));
+
+		indices.erase(index);
+	}
+
+	REQUIRE(container.size() == indices.size());
+
+	std::vector<int32_t> forward;
+	for(auto it = container.begin(); it != container.end(); ++it)
+	{
+		REQUIRE(*it == it.idx());
+		forward.push_back(it.idx());
+	}
+
+	REQUIRE(forward == std::vector<int32_t>(indices.begin(), indices.end()));
+
+	std::vector<int32_t> visited;
+	container.foreach([&](int32_t value) { visited.push_back(value); });
+
+	REQUIRE(visited == forward);
+
+	std::vector<int32_t> backward;
+	auto it = container.end();
+	while(it != container.begin())
+	{
+		--it;
+		backward.push_back(it.idx());
+	}
+
+	REQUIRE(backward == std::vector<int32_t>(indices.rbegin(), indices.rend()));
+
+	// refilling must reuse the free slots before growing
+	const auto freeSlots = container.capacity() - container.size();
+	for(size_t i = 0; i < freeSlots; ++i)
+	{
+		container.emplace(-1);
+	}
+
+	REQUIRE(container.capacity() == 16 * 8);
+	REQUIRE(container.size() == 16 * 8);
+}
+
+TEST_CASE("colony<T>: runs of empty pages", "[colony]")
+{
+	constexpr int32_t pageCount = 64;
+	constexpr int32_t lastPage = 16 * (pageCount - 1);
+
+	colony<int32_t, 16> container;
+
+	for(int32_t i = 0; i < 16 * pageCount; ++i)
+	{
+		container.emplace(i);
+	}
+
+	// empty every page but the first and the last
+	for(int32_t i = 16; i < lastPage; ++i)
+	{
+		REQUIRE(container.erase(i) == i + 1);
+	}
+
+	REQUIRE(container.size() == 32);
+	REQUIRE(container.empty_page_count() == pageCount - 2);
+
+	// the elements of the given pages, in order
+	const auto pages = [](std::initializer_list<int32_t> pageIndices) {
+		std::vector<int32_t> indices;
+		for(auto pageIndex : pageIndices)
+		{
+			for(int32_t i = 0; i < 16; ++i)
+			{
+				indices.push_back(pageIndex * 16 + i);
+			}
+		}
+		return indices;
+	};
+
+	const auto check = [&](const std::vector<int32_t>& expected) {
+		std::vector<int32_t> forward, values;
+		for(auto it = container.begin(); it != container.end(); ++it)
+		{
+			forward.push_back(it.idx());
+			values.push_back(*it);
+		}
+
+		REQUIRE(forward == expected);
+
+		std::vector<int32_t> backward;
+		auto it = container.end();
+		while(it != container.begin())
+		{
+			--it;
+			backward.push_back(it.idx());
+		}
+
+		REQUIRE(backward == std::vector<int32_t>(expected.rbegin(), expected.rend()));
+
+		std::vector<int32_t> visited;
+		container.foreach([&](int32_t value) { visited.push_back(value); });
+
+		REQUIRE(visited == values);
+	};
+
+	check(pages({ 0, pageCount - 1 }));
+
+	SECTION("erasing next to a run jumps over it")
+	{
+		for(int32_t i = 0; i < 15; ++i)
+		{
+			container.erase(i);
+		}
+
+		REQUIRE(container.erase(15) == lastPage);
+		REQUIRE(container.empty_page_count() == pageCount - 1);
+
+		for(int32_t i = lastPage; i < 16 * pageCount; ++i)
+		{
+			container.erase(i);
+		}
+
+		REQUIRE(container.empty_page_count() == pageCount);
+		check({});
+	}
+
+	SECTION("empty pages are refilled in order")
+	{
+		for(int32_t i = 16; i < lastPage; ++i)
+		{
+			REQUIRE(container.emplace(i).idx() == i);
+		}
+
+		REQUIRE(container.capacity() == 16 * pageCount);
+		REQUIRE(container.empty_page_count() == 0);
+	}
+
+	SECTION("a page between two runs")
+	{
+		for(int32_t i = 16; i < 16 * 32; ++i)
+		{
+			REQUIRE(container.emplace(i).idx() == i);
+		}
+
+		// empty pages 1 to 30 again, page 31 splits the empty pages in two runs
+		for(int32_t i = 16; i < 16 * 31; ++i)
+		{
+			container.erase(i);
+		}
+
+		check(pages({ 0, 31, pageCount - 1 }));
+		REQUIRE(container.empty_page_count() == pageCount - 3);
+
+		// the first run is refilled first
+		REQUIRE(container.emplace(16).idx() == 16);
+		container.erase(16);
+
+		// emptying page 31 merges the runs
+		for(int32_t i = 16 * 31; i < 16 * 32 - 1; ++i)
+		{
+			container.erase(i);
+		}
+		REQUIRE(container.erase(16 * 32 - 1) == lastPage);
+
+		check(pages({ 0, pageCount - 1 }));
+		REQUIRE(container.empty_page_count() == pageCount - 2);
+	}
+
+	SECTION("erase_if")
+	{
+		for(int32_t i = 16; i < 16 * 4; ++i)
+		{
+			container.emplace(i);
+		}
+
+		REQUIRE(container.erase_if([](int32_t value) { return value >= 16 && value < 48; }) == 32);
+
+		check(pages({ 0, 3, pageCount - 1 }));
+		REQUIRE(container.empty_page_count() == pageCount - 3);
+
+		// the emptied pages are taken again first
+		REQUIRE(container.emplace(16).idx() == 16);
+	}
+
+	SECTION("trim")
+	{
+		container.trim();
+
+		REQUIRE(container.page_count() == 2);
+		REQUIRE(container.capacity() == 32);
+		check(pages({ 0, pageCount - 1 }));
+
+		// the released pages are brought back from the front
+		REQUIRE(container.emplace(16).idx() == 16);
+		REQUIRE(container.page_count() == 3);
+
+		container.reserve(16 * pageCount);
+		REQUIRE(container.page_count() == pageCount);
+
+		auto expected = pages({ 0, pageCount - 1 });
+		expected.insert(expected.begin() + 16, 16);
+		check(expected);
+
+		for(int32_t i = 17; i < lastPage; ++i)
+		{
+			REQUIRE(container.emplace(i).idx() == i);
+		}
+	}
+
+	SECTION("compact")
+	{
+		const auto remap = container.compact();
+
+		REQUIRE(remap[lastPage] == 31);
+		REQUIRE(remap[16 * pageCount - 1] == 16);
+
+		check(pages({ 0, 1 }));
+		REQUIRE(container.empty_page_count() == pageCount - 2);
+
+		for(int32_t i = 32; i < 16 * pageCount; ++i)
+		{
+			REQUIRE(container.emplace(i).idx() == i);
+		}
+	}
+
+	SECTION("parallel_foreach_chunked")
+	{
+		mst::threading::thread_executor executor{ 4 };
+
+		std::atomic<size_t> visited{ 0 };
+
+		container.parallel_foreach_chunked(executor, [&](auto first, auto last) {
+			for(; first != last; ++first)
+			{
+				++visited;
+			}
+		});
+
+		REQUIRE(visited == container.size());
+	}
+}
+
+TEST_CASE("colony<T>: parallel_foreach visits every element once", "[colony]")
+{
+	colony<int32_t, 64> container;
+
+	for(int32_t i = 0; i < 64 * 37; ++i)
+	{
+		container.emplace(0);
+	}
+
+	// leave a few pages empty and the others half filled
+	for(int32_t i = 0; i < 64 * 37; ++i)
+	{
+		if((i / 64) % 5 == 0 || (i & 1))
+		{
+			container.erase(i);
+		}
+	}
+
+	mst::threading::thread_executor executor{ 4 };
+
+	SECTION("parallel_foreach")
+	{
+		container.parallel_foreach(executor, [](int32_t& value) { ++value; });
+
+		size_t visited = 0;
+		for(auto& value : container)
+		{
+			REQUIRE(value == 1);
+			++visited;
+		}
+
+		REQUIRE(visited == container.size());
+	}
+
+	SECTION("parallel_foreach_chunked")
+	{
+		std::atomic<size_t> visited{ 0 };
+		std::atomic<size_t> misalignedChunks{ 0 };
+
+		// Catch2 assertions are not thread-safe, so only count inside the workers
+		container.parallel_foreach_chunked(executor, [&](auto first, auto last) {
+			// every chunk starts at the first element of one of its pages
+			if((first.idx() & 63) > 1)
+			{
+				++misalignedChunks;
+			}
+
+			for(; first != last; ++first)
+			{
+				++*first;
+				++visited;
+			}
+		});
+
+		REQUIRE(misalignedChunks == 0);
+		REQUIRE(visited == container.size());
+
+		const auto& cref = container;
+		cref.foreach([](const int32_t& value) { REQUIRE(value == 1); });
+	}
+}
+
+TEST_CASE("colony<T>: emplace_n and insert fill free blocks before growing", "[colony]")
+{
+	colony<int32_t, 16> container;
+
+	for(int32_t i = 0; i < 16 * 4; ++i)
+	{
+		container.emplace(i);
+	}
+
+	// free blocks of 1, 3 and a full page
+	container.erase(5);
+	for(int32_t i = 20; i < 23; ++i)
+	{
+		container.erase(i);
+	}
+	for(int32_t i = 32; i < 48; ++i)
+	{
+		container.erase(i);
+	}
+
+	SECTION("emplace_n")
+	{
+		// 20 free slots, so exactly one page has to be added
+		const auto indices = container.emplace_n(20 + 16, -1);
+
+		REQUIRE(indices.size() == 36);
+		REQUIRE(container.size() == 16 * 5);
+		REQUIRE(container.capacity() == 16 * 5);
+
+		std::set<int32_t> unique(indices.begin(), indices.end());
+		REQUIRE(unique.size() == indices.size());
+		REQUIRE(unique.count(5));
+		REQUIRE(unique.count(21));
+
+		for(const auto index : indices)
+		{
+			REQUIRE(container[index] == -1);
+		}
+
+		size_t elemsEncountered = 0;
+		for(auto& item : container)
+		{
+			_MST_UNUSED(item);
+			++elemsEncountered;
+		}
+
+		REQUIRE(elemsEncountered == container.size());
+
+		// the colony must still be usable afterwards
+		container.erase(indices.front());
+		container.emplace(7);
+		REQUIRE(container.size() == 16 * 5);
+	}
+
+	SECTION("insert from a forward range")
+	{
+		std::vector<int32_t> values(12);
+		for(int32_t i = 0; i < 12; ++i)
+		{
+			values[(size_t)i] = 1000 + i;
+		}
+
+		const auto indices = container.insert(values.begin(), values.end());
+
+		REQUIRE(indices.size() == values.size());
+		REQUIRE(container.capacity() == 16 * 4);
+
+		for(size_t i = 0; i < values.size(); ++i)
+		{
+			REQUIRE(container[indices[i]] == values[i]);
+		}
+	}
+
+	SECTION("insert from an input range")
+	{
+		std::istringstream stream("7 8 9");
+
+		const auto indices = container.insert(
+			std::istream_iterator<int32_t>(stream), std::istream_iterator<int32_t>());
+
+		REQUIRE(indices.size() == 3);
+		REQUIRE(container[indices[0]] == 7);
+		REQUIRE(container[indices[2]] == 9);
+	}
+}
+
+namespace {
+
+// counts the live instances, copying a negative value throws
+struct throwing_copy
+{
+	static int liveCount;
+
+	int32_t value;
+
+	explicit throwing_copy(int32_t v)
+		: value(v)
+	{
+		++liveCount;
+	}
+
+	throwing_copy(const throwing_copy& other)
+		: value(other.value)
+	{
+		if(value < 0)
+		{
+			throw std::runtime_error("negative value");
+		}
+		++liveCount;
+	}
+
+	~throwing_copy()
+	{
+		--liveCount;
+	}
+};
+
+int throwing_copy::liveCount = 0;
+
+} // namespace
+
+TEST_CASE("colony<T>: insert keeps the colony valid when a constructor throws", "[colony]")
+{
+	{
+		colony<throwing_copy, 16> container;
+
+		for(int32_t i = 0; i < 20; ++i)
+		{
+			container.emplace(i);
+		}
+
+		// a free block of 4 and the rest of the second page
+		for(int32_t i = 4; i < 8; ++i)
+		{
+			container.erase(i);
+		}
+
+		// reserved, so the vector never copies the elements itself
+		std::vector<throwing_copy> values;
+		values.reserve(24);
+		for(int32_t i = 0; i < 24; ++i)
+		{
+			values.emplace_back(i == 10 ? -1 : 100 + i);
+		}
+
+		REQUIRE_THROWS_AS(
+			container.insert(values.begin(), values.end()), std::runtime_error);
+
+		// the 10 elements constructed before the throw are kept
+		REQUIRE(container.size() == 16 + 10);
+		REQUIRE(throwing_copy::liveCount == (int)(container.size() + values.size()));
+
+		size_t elemsEncountered = 0;
+		for(auto& item : container)
+		{
+			REQUIRE(item.value >= 0);
+			++elemsEncountered;
+		}
+
+		REQUIRE(elemsEncountered == container.size());
+
+		// the slots after the throw are free again, next to the page reserved up front
+		REQUIRE(container.capacity() == 16 * 3);
+		for(int32_t i = 0; i < 16 * 3 - 26; ++i)
+		{
+			container.emplace(-2);
+		}
+
+		REQUIRE(container.capacity() == 16 * 3);
+		REQUIRE(container.size() == 16 * 3);
+	}
+
+	REQUIRE(throwing_copy::liveCount == 0);
+}
+
+TEST_CASE("colony<T>: reserve, trim and shrink_to_fit", "[colony]")
+{
+	colony<int32_t, 16> container;
+
+	container.reserve(16 * 6 - 3);
+
+	REQUIRE(container.capacity() == 16 * 6);
+	REQUIRE(container.page_count() == 6);
+	REQUIRE(container.empty_page_count() == 6);
+	REQUIRE(container.free_slot_count() == 16 * 6);
+
+	for(int32_t i = 0; i < 16 * 6; ++i)
+	{
+		container.emplace(i);
+	}
+
+	REQUIRE(container.capacity() == 16 * 6);
+	REQUIRE(container.free_slot_count() == 0);
+
+	// empty page 1, 2 and the last two pages, keep a single element in page 3
+	for(int32_t i = 16; i < 16 * 6; ++i)
+	{
+		if(i < 48 || (i >= 64 && i != 50))
+		{
+			container.erase(i);
+		}
+	}
+	for(int32_t i = 48; i < 64; ++i)
+	{
+		if(i != 50)
+		{
+			container.erase(i);
+		}
+	}
+
+	REQUIRE(container.size() == 17);
+	REQUIRE(container.empty_page_count() == 4);
+
+	container.trim();
+
+	REQUIRE(container.page_count() == 2);
+	REQUIRE(container.empty_page_count() == 0);
+	REQUIRE(container.capacity() == 16 * 2);
+	REQUIRE(container.free_slot_count() == 15);
+
+	// the remaining elements keep their index
+	REQUIRE(container[50] == 50);
+	for(int32_t i = 0; i < 16; ++i)
+	{
+		REQUIRE(container[i] == i);
+	}
+
+	std::vector<int32_t> visited;
+	for(auto it = container.begin(); it != container.end(); ++it)
+	{
+		visited.push_back(it.idx());
+	}
+
+	REQUIRE(visited.size() == 17);
+	REQUIRE(visited.back() == 50);
+
+	auto last = container.end();
+	--last;
+	REQUIRE(last.idx() == 50);
+	--last;
+	REQUIRE(last.idx() == 15);
+
+	SECTION("growing reuses the released pages first")
+	{
+		for(int32_t i = 0; i < 15 + 16 * 2; ++i)
+		{
+			container.emplace(-1);
+		}
+
+		REQUIRE(container.page_count() == 4);
+		REQUIRE(container.capacity() == 16 * 4);
+		REQUIRE(container[50] == 50);
+
+		container.emplace(-1);
+		REQUIRE(container.page_count() == 5);
+	}
+
+	SECTION("shrink_to_fit after clear releases everything")
+	{
+		container.clear();
+		container.shrink_to_fit();
+
+		REQUIRE(container.page_count() == 0);
+		REQUIRE(container.capacity() == 0);
+		REQUIRE(container.begin() == container.end());
+
+		container.emplace(1);
+		REQUIRE(container.size() == 1);
+	}
+}
+
+TEST_CASE("colony<T>: compact packs the elements into the first pages", "[colony]")
+{
+	random_data_generator rdg{ true };
+	INFO("Seed" << rdg.seed());
+
+	SECTION("trivially relocatable elements with a remap table")
+	{
+		colony<int32_t, 16> container;
+
+		for(int32_t i = 0; i < 16 * 8; ++i)
+		{
+			container.emplace(i);
+		}
+
+		// erase about half, and all of the second page so it gets released in the middle
+		for(int32_t i = 0; i < 16 * 8; ++i)
+		{
+			if((i >= 16 && i < 32) || rdg.scalar_int(0, 1) == 0)
+			{
+				container.erase(i);
+			}
+		}
+
+		container.trim();
+
+		const auto elementCount = container.size();
+		const auto oldCapacity = container.capacity();
+
+		const auto remap = container.compact();
+
+		REQUIRE(container.size() == elementCount);
+		REQUIRE(container.capacity() == oldCapacity);
+
+		size_t remapped = 0;
+		for(size_t oldIndex = 0; oldIndex < remap.size(); ++oldIndex)
+		{
+			if(remap[oldIndex] != -1)
+			{
+				REQUIRE(container[remap[oldIndex]] == (int32_t)oldIndex);
+				++remapped;
+			}
+		}
+
+		REQUIRE(remapped == elementCount);
+
+		// the elements are dense, apart from the released second page
+		int32_t expected = 0;
+		for(auto it = container.begin(); it != container.end(); ++it)
+		{
+			if(expected == 16)
+			{
+				expected = 32;
+			}
+			REQUIRE(it.idx() == expected);
+			++expected;
+		}
+
+		container.trim();
+		REQUIRE(container.page_count() == (elementCount + 15) / 16);
+
+		container.emplace_n((int32_t)container.free_slot_count() + 1, 0);
+		REQUIRE(container.size() == container.capacity() - 15);
+	}
+
+	SECTION("move constructed elements with a callback")
+	{
+		colony<std::string, 16> container;
+
+		for(int32_t i = 0; i < 16 * 4; ++i)
+		{
+			container.emplace(std::to_string(i) + " is a long string to force an allocation");
+		}
+
+		for(int32_t i = 0; i < 16 * 4; i += 3)
+		{
+			container.erase(i);
+		}
+
+		std::vector<std::pair<int32_t, int32_t>> moves;
+		container.compact([&](int32_t oldIndex, int32_t newIndex) {
+			moves.emplace_back(oldIndex, newIndex);
+		});
+
+		REQUIRE(!moves.empty());
+
+		for(const auto& move : moves)
+		{
+			REQUIRE(move.second < move.first);
+			REQUIRE(container[move.second].find(std::to_string(move.first) + " is") == 0);
+		}
+
+		size_t elemsEncountered = 0;
+		for(auto it = container.begin(); it != container.end(); ++it)
+		{
+			REQUIRE(it.idx() == (int32_t)elemsEncountered);
+			++elemsEncountered;
+		}
+
+		REQUIRE(elemsEncountered == container.size());
+	}
+}
+
+template<int32_t ElementsPerPage>
+static void check_erase_if(random_data_generator& rdg)
+{
+	colony<int32_t, ElementsPerPage> container;
+	std::set<int32_t> values;
+
+	const auto count = ElementsPerPage * 6;
+	for(int32_t i = 0; i < count; ++i)
+	{
+		container.emplace(i);
+		values.insert(i);
+	}
+
+	// existing free blocks that the erased slots have to merge with
+	for(int32_t i = 0; i < count / 4; ++i)
+	{
+		const auto index = rdg.scalar_int<int32_t>(0, count - 1);
+		if(values.erase(index))
+		{
+			container.erase(index);
+		}
+	}
+
+	const auto pred = [&](int32_t value) {
+		return value % 3 == 0 || (value >= count / 3 && value < count / 2);
+	};
+
+	size_t expectedErased = 0;
+	for(auto it = values.begin(); it != values.end();)
+	{
+		if(pred(*it))
+		{
+			it = values.erase(it);
+			++expectedErased;
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	REQUIRE(container.erase_if(pred) == expectedErased);
+	REQUIRE(container.size() == values.size());
+
+	std::vector<int32_t> forward;
+	for(auto it = container.begin(); it != container.end(); ++it)
+	{
+		REQUIRE(*it == it.idx());
+		forward.push_back(*it);
+	}
+
+	REQUIRE(forward == std::vector<int32_t>(values.begin(), values.end()));
+
+	std::vector<int32_t> backward;
+	auto it = container.end();
+	while(it != container.begin())
+	{
+		--it;
+		backward.push_back(*it);
+	}
+
+	REQUIRE(backward == std::vector<int32_t>(values.rbegin(), values.rend()));
+
+	// the rebuilt free list must hand out exactly the free slots
+	const auto capacity = container.capacity();
+	while(container.size() != capacity)
+	{
+		const auto index = container.emplace(-1).idx();
+		REQUIRE(values.count(index) == 0);
+		values.insert(index);
+	}
+
+	REQUIRE(container.capacity() == capacity);
+
+	REQUIRE(container.erase_if([](int32_t) { return true; }) == capacity);
+	REQUIRE(container.empty());
+	REQUIRE(container.begin() == container.end());
+	REQUIRE(container.empty_page_count() == container.page_count());
+}
+
+TEST_CASE("colony<T>: erase_if", "[colony]")
+{
+	random_data_generator rdg{ true };
+	INFO("Seed" << rdg.seed());
+
+	SECTION("pages wider than the scan window")
+	{
+		check_erase_if<64>(rdg);
+	}
+
+	SECTION("pages as wide as the scan window")
+	{
+		check_erase_if<16>(rdg);
+	}
+
+	SECTION("pages narrower than the scan window")
+	{
+		check_erase_if<4>(rdg);
+	}
+
+	SECTION("destructors")
+	{
+		colony<std::string, 16> container;
+
+		for(int32_t i = 0; i < 16 * 3; ++i)
+		{
+			container.emplace(std::to_string(i) + " is a long string to force an allocation");
+		}
+
+		REQUIRE(container.erase_if([](const std::string& str) { return str[0] == '1'; }) == 11);
+		REQUIRE(container.size() == 16 * 3 - 11);
+
+		container.foreach([](const std::string& str) { REQUIRE(str[0] != '1'); });
+	}
+}
+
+TEST_CASE("colony<T>: custom allocators", "[colony]")
+{
+	SECTION("aligned_allocator")
+	{
+		colony<std::string, 16, mst::aligned_allocator<std::string, 64>> container;
+
+		for(int32_t i = 0; i < 16 * 3; ++i)
+		{
+			container.emplace(std::to_string(i));
+		}
+
+		for(int32_t i = 0; i < 16 * 3; i += 16)
+		{
+			REQUIRE(reinterpret_cast<uintptr_t>(&container[i]) % 64 == 0);
+		}
+
+		container.erase(0);
+		container.trim();
+
+		REQUIRE(container.size() == 16 * 3 - 1);
+		REQUIRE(container[17] == "17");
+	}
+
+	SECTION("page_allocator")
+	{
+		colony<int32_t, 1024, mst::page_allocator<int32_t>> container;
+
+		for(int32_t i = 0; i < 1024 * 3; ++i)
+		{
+			container.emplace(i);
+		}
+
+		const auto pageSize = mst::platform::page_size();
+
+		for(int32_t i = 0; i < 1024 * 3; i += 1024)
+		{
+			REQUIRE(reinterpret_cast<uintptr_t>(&container[i]) % pageSize == 0);
+		}
+
+		int32_t sum = 0;
+		container.foreach([&](int32_t value) { sum += value; });
+		REQUIRE(sum == (1024 * 3 - 1) * 1024 * 3 / 2);
+	}
+
+	SECTION("page_allocator with huge pages")
+	{
+		// 2MB pages, so every page can be backed by a transparent huge page
+		colony<int32_t, 512 * 1024, mst::page_allocator<int32_t, true>> container;
+
+		container.reserve(512 * 1024 * 2);
+		for(int32_t i = 0; i < 512 * 1024 * 2; i += 1024)
+		{
+			container.emplace(i);
+		}
+
+		REQUIRE(reinterpret_cast<uintptr_t>(&container[0]) % (2 * 1024 * 1024) == 0);
+		REQUIRE(container.size() == 1024);
+	}
+}
+
+TEST_CASE("colony<T>: handles detect erased elements", "[colony]")
+{
+	colony<int32_t, 16> container;
+
+	std::vector<colony<int32_t, 16>::handle> handles;
+	for(int32_t i = 0; i < 16 * 3; ++i)
+	{
+		handles.push_back(container.get_handle(container.emplace(i)));
+	}
+
+	for(int32_t i = 0; i < 16 * 3; ++i)
+	{
+		REQUIRE(container.get(handles[(size_t)i]) != nullptr);
+		REQUIRE(*container.get(handles[(size_t)i]) == i);
+	}
+
+	REQUIRE(container.get(colony<int32_t, 16>::handle{}) == nullptr);
+
+	SECTION("erase and reuse")
+	{
+		container.erase(5);
+
+		REQUIRE(container.get(handles[5]) == nullptr);
+
+		// the slot is reused, the old handle stays stale
+		const auto it = container.emplace(100);
+		REQUIRE(it.idx() == 5);
+		REQUIRE(container.get(handles[5]) == nullptr);
+
+		const auto handle = container.get_handle(it);
+		REQUIRE(handle != handles[5]);
+		REQUIRE(*container.get(handle) == 100);
+	}
+
+	SECTION("erase_if and clear")
+	{
+		container.erase_if([](int32_t value) { return value % 2 == 0; });
+
+		for(int32_t i = 0; i < 16 * 3; ++i)
+		{
+			REQUIRE((container.get(handles[(size_t)i]) == nullptr) == (i % 2 == 0));
+		}
+
+		container.clear();
+		container.emplace_n(16 * 3, -1);
+
+		for(const auto& handle : handles)
+		{
+			REQUIRE(container.get(handle) == nullptr);
+		}
+	}
+
+	SECTION("compact")
+	{
+		for(int32_t i = 0; i < 16; ++i)
+		{
+			container.erase(i);
+		}
+
+		const auto remap = container.compact();
+
+		for(int32_t i = 16; i < 16 * 3; ++i)
+		{
+			if(remap[(size_t)i] == i)
+			{
+				REQUIRE(*container.get(handles[(size_t)i]) == i);
+			}
+			else
+			{
+				REQUIRE(container.get(handles[(size_t)i]) == nullptr);
+				REQUIRE(*container.get(container.get_handle(remap[(size_t)i])) == i);
+			}
+		}
+	}
+
+	SECTION("trimmed pages")
+	{
+		for(int32_t i = 16; i < 16 * 3; ++i)
+		{
+			container.erase(i);
+		}
+
+		// the last two pages are dropped from the index range, and added again
+		container.trim();
+		REQUIRE(container.capacity() == 16);
+
+		container.emplace_n(16 * 2, -1);
+		REQUIRE(container.capacity() == 16 * 3);
+
+		for(int32_t i = 16; i < 16 * 3; ++i)
+		{
+			REQUIRE(container.get(handles[(size_t)i]) == nullptr);
+		}
+	}
+}
@@ -0,0 +1,249 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//      MST Utility Library                                                                 //
+//      Copyright (c)2026 Martinus Terpstra                                                 //
+//                                                                                          //
+//      Permission is hereby granted, free of charge, to any person obtaining a copy        //
+//      of this software and associated documentation files (the "Software"), to deal       //
+//      in the Software without restriction, including without limitation the rights        //
+//      to use, copy, modify, merge, publish, distribute, sublicense, and/or sell           //
+//      copies of the Software, and to permit persons to whom the Software is               //
+//      furnished to do so, subject to the following conditions:                            //
+//                                                                                          //
+//      The above copyright notice and this permission notice shall be included in          //
+//      all copies or substantial portions of the Software.                                 //
+//                                                                                          //
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR          //
+//      IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,            //
+//      FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE         //
+//      AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER              //
+//      LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,       //
+//      OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN           //
+//      THE SOFTWARE.                                                                       //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <set_assertions.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <mconcurrent_colony.h>
+
+using mst::concurrent_colony;
+
+TEST_CASE("concurrent_colony<T>: single thread", "[concurrent_colony]")
+{
+	concurrent_colony<int32_t, 16> container;
+
+	REQUIRE(container.empty());
+
+	std::vector<int32_t> indices;
+	for(int32_t i = 0; i < 16 * 4; ++i)
+	{
+		indices.push_back(container.emplace(i));
+		REQUIRE(container[indices.back()] == i);
+	}
+
+	REQUIRE(container.size() == 16 * 4);
+	REQUIRE(container.capacity() == 16 * 4);
+
+	for(int32_t i = 0; i < 16 * 4; i += 2)
+	{
+		container.erase(indices[(size_t)i]);
+	}
+
+	REQUIRE(container.size() == 16 * 2);
+
+	std::vector<int32_t> values;
+	container.foreach([&](int32_t value) { values.push_back(value); });
+
+	REQUIRE(values.size() == 16 * 2);
+	for(const auto value : values)
+	{
+		REQUIRE(value % 2 == 1);
+	}
+
+	// the freed slots are reused before a page is added
+	for(int32_t i = 0; i < 16 * 2; ++i)
+	{
+		container.emplace(-1);
+	}
+
+	REQUIRE(container.capacity() == 16 * 4);
+
+	container.clear();
+
+	REQUIRE(container.empty());
+	REQUIRE(container.capacity() == 16 * 4);
+
+	container.foreach([](int32_t) { FAIL("cleared container should be empty"); });
+}
+
+TEST_CASE("concurrent_colony<T>: multi-producer stress test", "[concurrent_colony]")
+{
+	constexpr int32_t threadCount = 4;
+	constexpr int32_t elementsPerThread = 20000;
+
+	struct entry
+	{
+		int32_t index;
+		int32_t value;
+	};
+
+	concurrent_colony<int32_t, 256> container;
+
+	std::vector<std::vector<entry>> published(threadCount);
+	std::vector<std::vector<entry>> created(threadCount);
+	std::vector<std::vector<int32_t>> erasedByOthers(threadCount);
+
+	std::atomic<int32_t> arrived{ 0 };
+
+	std::vector<std::thread> threads;
+	for(int32_t t = 0; t < threadCount; ++t)
+	{
+		threads.emplace_back([&, t] {
+			std::vector<entry> mine;
+
+			// phase 1: emplace, and erase a third of our own elements again
+			for(int32_t i = 0; i < elementsPerThread; ++i)
+			{
+				const auto value = t * elementsPerThread + i;
+				const auto index = container.emplace(value);
+				if(i % 3 == 0)
+				{
+					container.erase(index);
+				}
+				else
+				{
+					mine.push_back({ index, value });
+				}
+			}
+
+			published[(size_t)t] = mine;
+
+			arrived.fetch_add(1);
+			while(arrived.load() != threadCount)
+			{
+				std::this_thread::yield();
+			}
+
+			// phase 2: erase half of the elements of the next thread, while emplacing new ones
+			// that reuse our own free slots and the ones the previous thread erased
+			const auto& neighbour = published[(size_t)((t + 1) % threadCount)];
+			for(size_t i = 0; i < neighbour.size(); ++i)
+			{
+				if(i % 2 == 0)
+				{
+					container.erase(neighbour[i].index);
+					erasedByOthers[(size_t)((t + 1) % threadCount)].push_back(neighbour[i].value);
+				}
+
+				const auto value = (threadCount + t) * elementsPerThread + (int32_t)i;
+				created[(size_t)t].push_back({ container.emplace(value), value });
+			}
+		});
+	}
+
+	for(auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	std::vector<entry> expected;
+	for(int32_t t = 0; t < threadCount; ++t)
+	{
+		const auto& erased = erasedByOthers[(size_t)t];
+		for(const auto& e : published[(size_t)t])
+		{
+			if(std::find(erased.begin(), erased.end(), e.value) == erased.end())
+			{
+				expected.push_back(e);
+			}
+		}
+		expected.insert(expected.end(), created[(size_t)t].begin(), created[(size_t)t].end());
+	}
+
+	REQUIRE(container.size() == expected.size());
+
+	std::vector<int32_t> indices;
+	std::vector<int32_t> expectedValues;
+	for(const auto& e : expected)
+	{
+		REQUIRE(container[e.index] == e.value);
+		indices.push_back(e.index);
+		expectedValues.push_back(e.value);
+	}
+
+	// no slot was handed out twice
+	std::sort(indices.begin(), indices.end());
+	REQUIRE(std::adjacent_find(indices.begin(), indices.end()) == indices.end());
+
+	std::vector<int32_t> values;
+	container.foreach([&](int32_t value) { values.push_back(value); });
+
+	std::sort(values.begin(), values.end());
+	std::sort(expectedValues.begin(), expectedValues.end());
+
+	REQUIRE(values == expectedValues);
+}
+
+namespace {
+
+// counts the live instances, constructing from a negative value throws
+struct throwing_value
+{
+	static std::atomic<int> liveCount;
+
+	int32_t value;
+
+	explicit throwing_value(int32_t v)
+		: value(v)
+	{
+		if(value < 0)
+		{
+			throw std::runtime_error("negative value");
+		}
+		++liveCount;
+	}
+
+	~throwing_value()
+	{
+		--liveCount;
+	}
+};
+
+std::atomic<int> throwing_value::liveCount{ 0 };
+
+} // namespace
+
+TEST_CASE("concurrent_colony<T>: a throwing constructor frees its slot", "[concurrent_colony]")
+{
+	{
+		concurrent_colony<throwing_value, 16> container;
+
+		REQUIRE(container.emplace(1) == 0);
+
+		REQUIRE_THROWS_AS(container.emplace(-1), std::runtime_error);
+
+		REQUIRE(container.size() == 1);
+		REQUIRE(throwing_value::liveCount == 1);
+
+		// the slot is reused
+		REQUIRE(container.emplace(2) == 1);
+
+		size_t visited = 0;
+		container.foreach([&](throwing_value& elem) {
+			REQUIRE(elem.value > 0);
+			++visited;
+		});
+		REQUIRE(visited == 2);
+	}
+
+	REQUIRE(throwing_value::liveCount == 0);
+}
@@ -0,0 +1,232 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//      MST Utility Library                                                                 //
+//      Copyright (c)2026 Martinus Terpstra                                                 //
+//                                                                                          //
+//      Permission is hereby granted, free of charge, to any person obtaining a copy        //
+//      of this software and associated documentation files (the "Software"), to deal       //
+//      in the Software without restriction, including without limitation the rights        //
+//      to use, copy, modify, merge, publish, distribute, sublicense, and/or sell           //
+//      copies of the Software, and to permit persons to whom the Software is               //
+//      furnished to do so, subject to the following conditions:                            //
+//                                                                                          //
+//      The above copyright notice and this permission notice shall be included in          //
+//      all copies or substantial portions of the Software.                                 //
+//                                                                                          //
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR          //
+//      IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,            //
+//      FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE         //
+//      AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER              //
+//      LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,       //
+//      OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN           //
+//      THE SOFTWARE.                                                                       //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <set_assertions.h>
+
+#include <mflat_soa_map.h>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using mst::flat_soa_map;
+
+TEST_CASE("flat_soa_map<K,V>: creation", "[flat_soa_map]")
+{
+	flat_soa_map<int, std::string> map;
+
+	map[100] = "hundred";
+
+	REQUIRE(map.size() == 1);
+	REQUIRE(map.contains(100));
+	REQUIRE(map.at(100) == "hundred");
+	REQUIRE(map.begin()->first == 100);
+	REQUIRE(map.begin()->second == "hundred");
+	REQUIRE(map.end() - map.begin() == 1);
+
+	map.clear();
+
+	REQUIRE(map.empty());
+	REQUIRE(!map.contains(100));
+}
+
+TEST_CASE("flat_soa_map<K,V>: matches std::map", "[flat_soa_map]")
+{
+	flat_soa_map<int, int> map;
+	std::map<int, int> expected;
+
+	std::mt19937 rng(7);
+	for(int i = 0; i < 2000; ++i)
+	{
+		const int key = (int)(rng() % 500);
+		switch(rng() % 3)
+		{
+		case 0:
+			map.insert(std::make_pair(key, i));
+			expected.insert(std::make_pair(key, i));
+			break;
+		case 1:
+			map[key] = i;
+			expected[key] = i;
+			break;
+		default:
+			if(expected.erase(key))
+				map.erase(key);
+			break;
+		}
+	}
+
+	REQUIRE(map.size() == expected.size());
+	REQUIRE(std::equal(map.begin(), map.end(), expected.begin(), expected.end(),
+		[](const auto& left, const auto& right) {
+			return left.first == right.first && left.second == right.second;
+		}));
+
+	for(int key = 0; key < 500; ++key)
+	{
+		REQUIRE(map.contains(key) == (expected.count(key) == 1));
+		const auto lower = map.lower_bound(key);
+		const auto upper = map.upper_bound(key);
+		REQUIRE((lower == map.end()) == (expected.lower_bound(key) == expected.end()));
+		REQUIRE((upper == map.end()) == (expected.upper_bound(key) == expected.end()));
+		if(lower != map.end())
+			REQUIRE(lower->first == expected.lower_bound(key)->first);
+		if(upper != map.end())
+			REQUIRE(upper->first == expected.upper_bound(key)->first);
+	}
+}
+
+TEST_CASE("flat_soa_map<K,V>: iterators write through to the value array", "[flat_soa_map]")
+{
+	flat_soa_map<int, int> map = {
+		{ 3, 30 },
+		{ 1, 10 },
+		{ 2, 20 },
+	};
+
+	for(auto [key, value] : map)
+		value = key * 100;
+	map.find(2)->second = -2;
+
+	REQUIRE(map.values() == std::vector<int>{ 100, -2, 300 });
+	REQUIRE(map.keys() == std::vector<int>{ 1, 2, 3 });
+
+	const auto& cmap = map;
+	flat_soa_map<int, int>::const_iterator it = map.begin();
+	REQUIRE(it == cmap.cbegin());
+	REQUIRE(it[2].second == 300);
+	REQUIRE(cmap.find(4) == cmap.end());
+	REQUIRE_THROWS_AS(cmap.at(4), std::out_of_range);
+
+	const auto next = map.erase(map.find(2));
+	REQUIRE(next->first == 3);
+	REQUIRE(map.size() == 2);
+}
+
+TEST_CASE("flat_soa_map<K,V>: bulk insert and construction", "[flat_soa_map]")
+{
+	std::vector<std::pair<int, int>> pairs = {
+		{ 30, 300 }, { 5, 50 }, { 20, 200 }, { 15, 150 }, { 5, -1 }, { 25, 250 },
+	};
+
+	flat_soa_map<int, int> map(pairs);
+	REQUIRE(map.size() == 5);
+	REQUIRE(map.at(5) == 50);
+
+	std::vector<std::pair<int, int>> more = { { 1, 1 }, { 20, -1 }, { 40, 40 } };
+	map.insert(more.begin(), more.end());
+	REQUIRE(map.size() == 7);
+	REQUIRE(map.at(20) == 200);
+	REQUIRE(map.at(40) == 40);
+
+	std::vector<std::pair<int, int>> tail = { { 50, 50 }, { 60, 60 } };
+	map.insert_sorted_unique(tail.begin(), tail.end());
+	REQUIRE(map.keys() == std::vector<int>{ 1, 5, 15, 20, 25, 30, 40, 50, 60 });
+
+	auto copy = map;
+	copy[5] = 0;
+	REQUIRE(map.at(5) == 50);
+	auto moved = std::move(copy);
+	REQUIRE(moved.at(5) == 0);
+}
+
+TEST_CASE("flat_soa_map<K,V>: custom comparator reverses iteration order", "[flat_soa_map]")
+{
+	flat_soa_map<int, int, std::greater<int>> map = {
+		{ 1, 10 },
+		{ 3, 30 },
+		{ 2, 20 },
+	};
+
+	REQUIRE(map.keys() == std::vector<int>{ 3, 2, 1 });
+	REQUIRE(map.lower_bound(2)->first == 2);
+}
+
+namespace {
+
+// copying a negative value throws, moving never does
+struct throwing_copy
+{
+	int value = 0;
+
+	throwing_copy() = default;
+
+	throwing_copy(int v)
+		: value(v)
+	{ }
+
+	throwing_copy(const throwing_copy& other)
+		: value(other.value)
+	{
+		if(value < 0)
+		{
+			throw std::runtime_error("negative value");
+		}
+	}
+
+	throwing_copy(throwing_copy&&) noexcept = default;
+	throwing_copy& operator=(const throwing_copy&) = default;
+	throwing_copy& operator=(throwing_copy&&) noexcept = default;
+
+	bool operator<(const throwing_copy& other) const
+	{
+		return value < other.value;
+	}
+};
+
+} // namespace
+
+TEST_CASE("flat_soa_map<K,V>: a throwing insert keeps keys and values in step", "[flat_soa_map]")
+{
+	flat_soa_map<throwing_copy, throwing_copy> map;
+	for(int i = 0; i < 8; ++i)
+	{
+		map[i * 2] = i;
+	}
+
+	// the value throws
+	const std::pair<throwing_copy, throwing_copy> badValue = { 5, -1 };
+	REQUIRE_THROWS_AS(map.insert(badValue), std::runtime_error);
+	REQUIRE(map.keys().size() == 8);
+	REQUIRE(map.values().size() == 8);
+
+	// the key throws after the value went in
+	const std::pair<throwing_copy, throwing_copy> badKey = { -3, 5 };
+	REQUIRE_THROWS_AS(map.insert(badKey), std::runtime_error);
+	REQUIRE_THROWS_AS(map[throwing_copy(-5)], std::runtime_error);
+	REQUIRE(map.keys().size() == 8);
+	REQUIRE(map.values().size() == 8);
+
+	for(int i = 0; i < 8; ++i)
+	{
+		REQUIRE(map.keys()[(size_t)i].value == i * 2);
+		REQUIRE(map.values()[(size_t)i].value == i);
+	}
+}
@@ -0,0 +1,157 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//      MST Utility Library                                                                 //
+//      Copyright (c)2026 Martinus Terpstra                                                 //
+//                                                                                          //
+//      Permission is hereby granted, free of charge, to any person obtaining a copy        //
+//      of this software and associated documentation files (the "Software"), to deal       //
+//      in the Software without restriction, including without limitation the rights        //
+//      to use, copy, modify, merge, publish, distribute, sublicense, and/or sell           //
+//      copies of the Software, and to permit persons to whom the Software is               //
+//      furnished to do so, subject to the following conditions:                            //
+//                                                                                          //
+//      The above copyright notice and this permission notice shall be included in          //
+//      all copies or substantial portions of the Software.                                 //
+//                                                                                          //
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR          //
+//      IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,            //
+//      FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE         //
+//      AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER              //
+//      LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,       //
+//      OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN           //
+//      THE SOFTWARE.                                                                       //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <set_assertions.h>
+
+#include <mmapped_stride_map.h>
+#include <mplatform.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct mapped_test_record
+{
+	float position[3];
+	int id;
+};
+
+std::string write_records(const char* name, size_t count, size_t trailingBytes = 0)
+{
+	const std::string path = mst::platform::temp_path() + mst::platform::directory_separator() +
+		name;
+
+	std::vector<mapped_test_record> records(count);
+	for(size_t i = 0; i < count; ++i)
+		records[i] = { { (float)i, 0, 0 }, (int)i };
+
+	FILE* file = fopen(path.c_str(), "wb");
+	REQUIRE(file != nullptr);
+	if(count)
+		fwrite(records.data(), sizeof(mapped_test_record), count, file);
+	for(size_t i = 0; i < trailingBytes; ++i)
+		fputc(0xFF, file);
+	fclose(file);
+
+	return path;
+}
+
+} // namespace
+
+TEST_CASE("mst::mapped_stride_map: read-only mapping", "[stride_map]")
+{
+	const auto path = write_records("mst_mapped_stride_map_ro.bin", 1000, 5);
+
+	mst::mapped_stride_map map(
+		path.c_str(), sizeof(mapped_test_record), mst::map_mode::read_only,
+		mst::map_access_hint::sequential);
+
+	REQUIRE(map.is_open());
+	REQUIRE(!map.writable());
+	// the 5 trailing bytes don't form a record
+	REQUIRE(map.size() == 1000);
+	REQUIRE(map.data_size() == 1000 * sizeof(mapped_test_record));
+
+	const mst::mapped_stride_map& cmap = map;
+	REQUIRE(cmap.index<mapped_test_record>(999).id == 999);
+
+	int expected = 0;
+	for(const auto& record : mst::range<mapped_test_record>(cmap))
+	{
+		REQUIRE(record.id == expected);
+		REQUIRE(record.position[0] == (float)expected);
+		++expected;
+	}
+	REQUIRE(expected == 1000);
+
+	std::vector<int> ids(map.size());
+	map.gather(offsetof(mapped_test_record, id), ids.data());
+	REQUIRE(ids[500] == 500);
+
+	auto ids2 = cmap.column<int>(offsetof(mapped_test_record, id));
+	REQUIRE(ids2[42] == 42);
+
+	map.advise(mst::map_access_hint::will_need);
+
+	mst::stride_map copy = map.to_stride_map();
+	REQUIRE(copy.size() == 1000);
+	REQUIRE(copy.index<mapped_test_record>(123).id == 123);
+
+	mst::mapped_stride_map moved = std::move(map);
+	REQUIRE(moved.is_open());
+	REQUIRE(moved.size() == 1000);
+	REQUIRE(!map.is_open()); // NOLINT: intentionally inspecting the moved-from state
+
+	moved.close();
+	REQUIRE(!moved.is_open());
+	REQUIRE(moved.empty());
+
+	std::remove(path.c_str());
+}
+
+TEST_CASE("mst::mapped_stride_map: copy-on-write leaves the file untouched", "[stride_map]")
+{
+	const auto path = write_records("mst_mapped_stride_map_cow.bin", 64);
+
+	{
+		mst::mapped_stride_map map(
+			path.c_str(), sizeof(mapped_test_record), mst::map_mode::copy_on_write);
+		REQUIRE(map.writable());
+
+		for(auto it = map.begin<mapped_test_record>(); it != map.end<mapped_test_record>(); ++it)
+			it->id = -1;
+		REQUIRE(map.index<mapped_test_record>(10).id == -1);
+	}
+
+	mst::mapped_stride_map reread(path.c_str(), sizeof(mapped_test_record));
+	REQUIRE(reread.size() == 64);
+	REQUIRE(reread.index<mapped_test_record>(10).id == 10);
+	reread.close();
+
+	std::remove(path.c_str());
+}
+
+TEST_CASE("mst::mapped_stride_map: empty and missing files", "[stride_map]")
+{
+	const auto path = write_records("mst_mapped_stride_map_empty.bin", 0);
+
+	mst::mapped_stride_map map;
+	REQUIRE(!map.is_open());
+
+	REQUIRE(map.open(path.c_str(), sizeof(mapped_test_record)));
+	REQUIRE(map.is_open());
+	REQUIRE(map.empty());
+	REQUIRE(map.size() == 0);
+
+	std::remove(path.c_str());
+
+	REQUIRE(!map.open(path.c_str(), sizeof(mapped_test_record)));
+	REQUIRE(!map.is_open());
+}
@@ -0,0 +1,193 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//      MST Utility Library                                                                 //
+//      Copyright (c)2026 Martinus Terpstra                                                 //
+//                                                                                          //
+//      Permission is hereby granted, free of charge, to any person obtaining a copy        //
+//      of this software and associated documentation files (the "Software"), to deal       //
+//      in the Software without restriction, including without limitation the rights        //
+//      to use, copy, modify, merge, publish, distribute, sublicense, and/or sell           //
+//      copies of the Software, and to permit persons to whom the Software is               //
+//      furnished to do so, subject to the following conditions:                            //
+//                                                                                          //
+//      The above copyright notice and this permission notice shall be included in          //
+//      all copies or substantial portions of the Software.                                 //
+//                                                                                          //
+//      THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR          //
+//      IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,            //
+//      FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE         //
+//      AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER              //
+//      LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,       //
+//      OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN           //
+//      THE SOFTWARE.                                                                       //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <set_assertions.h>
+
+#include <set>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <msoa_colony.h>
+
+using mst::basic_soa_colony;
+
+TEST_CASE("soa_colony<Fields...>: emplace, get and erase", "[soa_colony]")
+{
+	basic_soa_colony<16, int32_t, float, std::string> container;
+
+	REQUIRE(container.empty());
+
+	for(int32_t i = 0; i < 16 * 3; ++i)
+	{
+		REQUIRE(container.emplace(i, i * 0.5f, std::to_string(i)) == i);
+	}
+
+	REQUIRE(container.size() == 16 * 3);
+	REQUIRE(container.capacity() == 16 * 3);
+
+	REQUIRE(container.get<0>(20) == 20);
+	REQUIRE(container.get<1>(20) == 10.0f);
+	REQUIRE(container.get<2>(20) == "20");
+
+	// every column starts on a cache line
+	REQUIRE(reinterpret_cast<uintptr_t>(&container.get<0>(16)) % 64 == 0);
+	REQUIRE(reinterpret_cast<uintptr_t>(&container.get<1>(16)) % 64 == 0);
+	REQUIRE(reinterpret_cast<uintptr_t>(&container.get<2>(16)) % 64 == 0);
+
+	REQUIRE(container.erase(5) == 6);
+	REQUIRE(container.erase(6) == 7);
+	REQUIRE(container.erase(15) == 16);
+	REQUIRE(container.erase(47) == 48);
+
+	REQUIRE(container.size() == 16 * 3 - 4);
+
+	std::set<int32_t> visited;
+	container.foreach([&](int32_t value, float half, const std::string& str) {
+		REQUIRE(half == value * 0.5f);
+		REQUIRE(str == std::to_string(value));
+		visited.insert(value);
+	});
+
+	REQUIRE(visited.size() == 16 * 3 - 4);
+	REQUIRE(visited.count(5) == 0);
+	REQUIRE(visited.count(47) == 0);
+
+	// the erased slots are reused before a page is added
+	std::set<int32_t> reused;
+	for(int i = 0; i < 4; ++i)
+	{
+		reused.insert(container.emplace(-1, 0.0f, std::string()));
+	}
+
+	REQUIRE(reused == std::set<int32_t>{ 5, 6, 15, 47 });
+	REQUIRE(container.capacity() == 16 * 3);
+
+	container.clear();
+
+	REQUIRE(container.empty());
+	REQUIRE(container.emplace(1, 1.0f, "1") == 0);
+}
+
+TEST_CASE("soa_colony<Fields...>: foreach_run hands out contiguous live runs", "[soa_colony]")
+{
+	basic_soa_colony<16, float, float> container;
+
+	for(int32_t i = 0; i < 16 * 4; ++i)
+	{
+		container.emplace(float(i), 1.0f);
+	}
+
+	// runs are split by the holes and by the page boundaries
+	container.erase(3);
+	container.erase(4);
+	container.erase(40);
+
+	for(int32_t i = 16; i < 32; ++i)
+	{
+		container.erase(i);
+	}
+
+	std::vector<std::pair<int32_t, int32_t>> runs;
+	container.foreach_run([&](int32_t firstIndex, int32_t count, float* position, float* speed) {
+		runs.emplace_back(firstIndex, count);
+		for(int32_t i = 0; i < count; ++i)
+		{
+			position[i] += speed[i];
+		}
+	});
+
+	const std::vector<std::pair<int32_t, int32_t>> expected = {
+		{ 0, 3 }, { 5, 11 }, { 32, 8 }, { 41, 7 }, { 48, 16 }
+	};
+
+	REQUIRE(runs == expected);
+
+	const auto& constContainer = container;
+	constContainer.foreach_run([&](int32_t firstIndex, int32_t count, const float* position,
+								   const float*) {
+		for(int32_t i = 0; i < count; ++i)
+		{
+			REQUIRE(position[i] == float(firstIndex + i) + 1.0f);
+		}
+	});
+}
+
+namespace {
+
+// counts the live instances, constructing from a negative value throws
+struct throwing_field
+{
+	static int liveCount;
+
+	int32_t value;
+
+	explicit throwing_field(int32_t v)
+		: value(v)
+	{
+		if(value < 0)
+		{
+			throw std::runtime_error("negative value");
+		}
+		++liveCount;
+	}
+
+	~throwing_field()
+	{
+		--liveCount;
+	}
+};
+
+int throwing_field::liveCount = 0;
+
+} // namespace
+
+TEST_CASE("soa_colony<Fields...>: a throwing field leaves the colony valid", "[soa_colony]")
+{
+	{
+		basic_soa_colony<16, throwing_field, throwing_field, throwing_field> container;
+
+		REQUIRE(container.emplace(1, 2, 3) == 0);
+
+		// the first two fields are built before the third one throws
+		REQUIRE_THROWS_AS(container.emplace(4, 5, -1), std::runtime_error);
+		REQUIRE_THROWS_AS(container.emplace(-1, 5, 6), std::runtime_error);
+
+		REQUIRE(container.size() == 1);
+		REQUIRE(throwing_field::liveCount == 3);
+
+		// the slot stayed free
+		REQUIRE(container.emplace(4, 5, 6) == 1);
+		REQUIRE(container.get<2>(1).value == 6);
+
+		container.erase(0);
+		REQUIRE(throwing_field::liveCount == 3);
+	}
+
+	REQUIRE(throwing_field::liveCount == 0);
+}
@@ -28,8 +28,14 @@
 
 #include <set_assertions.h>
 
+#include <mexecutor.h>
 #include <msparse_set.h>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <random>
+#include <set>
+#include <string>
 
 using mst::sparse_set;
 
@@ -78,4 +84,531 @@ TEST_CASE("sparse_set<E,I>: erasion", "[sparse_set]")
 
 	REQUIRE(intint.size() == 0);
 	REQUIRE(!intint.contains(100));
-}
\ No newline at end of file
+}
+
+TEST_CASE("sparse_set<E,I>: page recycling", "[sparse_set]")
+{
+	constexpr size_t pageSize = 1024;
+	constexpr size_t pageBytes = pageSize * sizeof(uint32_t);
+	sparse_set<int, uint32_t, pageSize> set;
+
+	const auto emptyUsage = set.memory_usage();
+	REQUIRE(emptyUsage == 0);
+
+	// ids churning through a large id space only keep a few pages alive
+	for(uint32_t page = 0; page < 64; ++page)
+	{
+		for(uint32_t i = 0; i < 10; ++i)
+			set.emplace(page * pageSize + i, (int)i);
+		for(uint32_t i = 0; i < 10; ++i)
+			set.erase(page * pageSize + i);
+	}
+	REQUIRE(set.empty());
+	REQUIRE(set.memory_usage() < 64 * pageBytes);
+
+	SECTION("pooled pages are reused")
+	{
+		set.emplace(100 * pageSize + 5, 5);
+		REQUIRE(set.contains(100 * pageSize + 5));
+		REQUIRE(!set.contains(100 * pageSize + 6));
+		REQUIRE(!set.contains(63 * pageSize + 5));
+		REQUIRE(set.at(100 * pageSize + 5) == 5);
+	}
+	SECTION("shrink_to_fit releases everything unused")
+	{
+		set.shrink_to_fit();
+		REQUIRE(set.memory_usage() == emptyUsage);
+	}
+	SECTION("a partially used page is kept")
+	{
+		set.emplace(3, 3);
+		set.emplace(4, 4);
+		set.emplace(5 * pageSize, 5);
+		set.erase(3);
+		set.erase(5 * pageSize);
+		set.shrink_to_fit();
+		REQUIRE(set.contains(4));
+		REQUIRE(set.memory_usage() >= pageBytes);
+		REQUIRE(set.memory_usage() < 2 * pageBytes);
+
+		auto copy = set;
+		REQUIRE(copy.size() == 1);
+		REQUIRE(copy.at(4) == 4);
+		copy.erase(4);
+		REQUIRE(copy.empty());
+		REQUIRE(set.contains(4));
+	}
+}
+
+TEST_CASE("sparse_set<E,I>: batch emplace and erase", "[sparse_set]")
+{
+	constexpr size_t pageSize = 256;
+	sparse_set<int, uint32_t, pageSize> set;
+	std::set<uint32_t> expected;
+
+	std::vector<uint32_t> ids(2000);
+	for(uint32_t i = 0; i < 2000; ++i)
+		ids[i] = i * 7;
+	std::mt19937 rng(42);
+	std::shuffle(ids.begin(), ids.end(), rng);
+
+	std::vector<int> values(ids.size());
+	for(size_t i = 0; i < ids.size(); ++i)
+		values[i] = (int)ids[i] + 1;
+
+	set.emplace(3, 4);
+	set.emplace_batch(ids, values);
+	expected.insert(ids.begin(), ids.end());
+	expected.insert(3);
+
+	auto verify = [&] {
+		REQUIRE(set.size() == expected.size());
+		for(const auto& [index, value] : set)
+		{
+			REQUIRE(expected.count(index) == 1);
+			REQUIRE(value == (int)index + 1);
+		}
+		for(const auto index : expected)
+			REQUIRE(set.contains(index));
+	};
+	verify();
+
+	SECTION("erase a random half")
+	{
+		std::vector<uint32_t> erased(ids.begin(), ids.begin() + 1000);
+		set.erase_batch(erased);
+		for(const auto index : erased)
+			expected.erase(index);
+		verify();
+		for(const auto index : erased)
+			REQUIRE(!set.contains(index));
+	}
+	SECTION("erase the tail of the dense array")
+	{
+		std::vector<uint32_t> erased(ids.end() - 10, ids.end());
+		set.erase_batch(erased);
+		for(const auto index : erased)
+			expected.erase(index);
+		verify();
+	}
+	SECTION("erase everything releases the pages")
+	{
+		set.erase_batch(ids);
+		set.erase(3);
+		REQUIRE(set.empty());
+		set.shrink_to_fit();
+		REQUIRE(set.memory_usage() == 0);
+	}
+	SECTION("empty batches")
+	{
+		set.emplace_batch({}, {});
+		set.erase_batch({});
+		verify();
+	}
+}
+
+TEST_CASE("sparse_set<E,I>: sort and respect", "[sparse_set]")
+{
+	sparse_set<int, uint32_t> a;
+	sparse_set<std::string, uint32_t, 1024> b;
+
+	std::vector<uint32_t> ids(1000);
+	for(uint32_t i = 0; i < 1000; ++i)
+		ids[i] = i * 13;
+	std::mt19937 rng(5);
+	std::shuffle(ids.begin(), ids.end(), rng);
+
+	for(const auto id : ids)
+	{
+		a.emplace(id, (int)(id % 97));
+		if(id % 2 == 0)
+			b.emplace(id, std::to_string(id));
+	}
+	b.emplace(1, "1");
+
+	auto verify = [&] {
+		for(const auto& [index, value] : a)
+			REQUIRE(a.at(index) == value);
+		for(const auto& [index, value] : b)
+			REQUIRE(b.at(index) == value);
+	};
+
+	SECTION("by index")
+	{
+		a.sort();
+		verify();
+		REQUIRE(std::is_sorted(a.begin(), a.end(),
+			[](const auto& left, const auto& right) { return left.first < right.first; }));
+	}
+	SECTION("by element")
+	{
+		a.sort([](const auto& left, const auto& right) { return left.second > right.second; });
+		verify();
+		REQUIRE(std::is_sorted(a.begin(), a.end(),
+			[](const auto& left, const auto& right) { return left.second > right.second; }));
+	}
+	SECTION("respect")
+	{
+		a.sort();
+		b.respect(a);
+		verify();
+
+		// the shared indices lead b, in the order of a
+		auto it = b.begin();
+		for(const auto& elem : a)
+		{
+			if(elem.first % 2 == 0)
+			{
+				REQUIRE(it->first == elem.first);
+				++it;
+			}
+		}
+		REQUIRE(it->first == 1);
+		REQUIRE(it + 1 == b.end());
+
+		// respect() is only noexcept when moving the elements can't throw
+		struct throwing_move
+		{
+			throwing_move() = default;
+			throwing_move(throwing_move&&) { }
+		};
+		sparse_set<throwing_move, uint32_t> c;
+		static_assert(noexcept(b.respect(a)));
+		static_assert(!noexcept(c.respect(a)));
+	}
+}
+
+TEST_CASE("sparse_set<E,I>: chunked and parallel iteration", "[sparse_set]")
+{
+	sparse_set<uint64_t, uint32_t> set;
+	for(uint32_t i = 0; i < 10'000; ++i)
+		set.emplace(i * 3, 0);
+
+	SECTION("for_each_chunk")
+	{
+		for(size_t chunkSize : { 1, 7, 4096, 100'000 })
+		{
+			size_t chunks = 0;
+			auto expected = set.begin();
+			set.for_each_chunk(chunkSize, [&](auto range) {
+				size_t count = 0;
+				for(auto& [index, value] : range)
+				{
+					REQUIRE(index == expected->first);
+					++value;
+					++expected;
+					++count;
+				}
+				REQUIRE(count <= chunkSize);
+				++chunks;
+			});
+			REQUIRE(expected == set.end());
+			REQUIRE(chunks == (set.size() + chunkSize - 1) / chunkSize);
+		}
+		for(const auto& [index, value] : set)
+			REQUIRE(value == 4);
+
+		const auto& cset = set;
+		size_t count = 0;
+		cset.for_each_chunk(1000, [&](auto range) {
+			for(const auto& elem : range)
+				count += elem.second == 4;
+		});
+		REQUIRE(count == set.size());
+	}
+	SECTION("parallel_for_each")
+	{
+		mst::threading::thread_executor executor(4);
+		set.parallel_for_each(executor, [](auto& elem) { elem.second += elem.first; });
+		set.parallel_for_each(mst::threading::inline_executor(),
+			[](auto& elem) { elem.second *= 2; });
+
+		for(const auto& [index, value] : set)
+			REQUIRE(value == index * 2);
+
+		std::atomic<uint64_t> sum = 0;
+		const auto& cset = set;
+		cset.parallel_for_each(executor, [&](const auto& elem) { sum += elem.second; });
+		REQUIRE(sum == 3ull * 9'999 * 10'000);
+	}
+	SECTION("empty set")
+	{
+		sparse_set<int, uint32_t> empty;
+		empty.for_each_chunk(16, [](auto) { FAIL("no chunks"); });
+		empty.parallel_for_each(mst::threading::inline_executor(), [](auto&) { FAIL("nothing"); });
+	}
+}
+
+TEST_CASE("sparse_set<E,I>: versioned indices", "[sparse_set]")
+{
+	typedef sparse_set<int, uint32_t, 1024, mst::sparse_set_traits<8>> versioned_set;
+	const auto id = [](uint32_t index, uint32_t version) { return (version << 24) | index; };
+
+	versioned_set set;
+	set.emplace(id(5, 1), 51);
+	set.emplace(id(2000, 255), 2000);
+
+	REQUIRE(set.contains(id(5, 1)));
+	REQUIRE(!set.contains(id(5, 0)));
+	REQUIRE(!set.contains(id(5, 2)));
+	REQUIRE(!set.contains(id(6, 1)));
+	REQUIRE(set.contains(id(2000, 255)));
+	REQUIRE(!set.contains(id(2000, 254)));
+	REQUIRE(set.at(id(5, 1)) == 51);
+
+	// the version bits don't select pages
+	REQUIRE(set.memory_usage() < 4 * 1024 * sizeof(uint32_t));
+
+	SECTION("iteration yields the full ids")
+	{
+		std::set<uint32_t> ids;
+		for(const auto& [index, value] : set)
+			ids.insert(index);
+		REQUIRE(ids == std::set<uint32_t>{ id(5, 1), id(2000, 255) });
+	}
+	SECTION("reusing an index with a new version")
+	{
+		set.erase(id(5, 1));
+		REQUIRE(!set.contains(id(5, 1)));
+		set.emplace(id(5, 2), 52);
+		REQUIRE(!set.contains(id(5, 1)));
+		REQUIRE(set.contains(id(5, 2)));
+		REQUIRE(set.at(id(5, 2)) == 52);
+		REQUIRE(set.at(id(2000, 255)) == 2000);
+	}
+	SECTION("reordering keeps the versions")
+	{
+		for(uint32_t i = 0; i < 100; ++i)
+			set.emplace(id(100 + i, i), (int)i);
+		set.erase(id(5, 1));
+		set.sort();
+
+		auto copy = set;
+		for(uint32_t i = 0; i < 100; ++i)
+		{
+			REQUIRE(set.contains(id(100 + i, i)));
+			REQUIRE(!set.contains(id(100 + i, i + 1)));
+			REQUIRE(copy.at(id(100 + i, i)) == (int)i);
+		}
+
+		std::vector<uint32_t> erased;
+		for(uint32_t i = 0; i < 100; i += 2)
+			erased.push_back(id(100 + i, i));
+		set.erase_batch(erased);
+		for(uint32_t i = 0; i < 100; ++i)
+			REQUIRE(set.contains(id(100 + i, i)) == (i % 2 == 1));
+	}
+	SECTION("views and groups match versions")
+	{
+		versioned_set other;
+		other.emplace(id(5, 1), 0);
+		other.emplace(id(2000, 254), 0);
+
+		size_t count = 0;
+		mst::sparse_view(set, other).each([&](uint32_t index, int&, int&) {
+			REQUIRE(index == id(5, 1));
+			++count;
+		});
+		REQUIRE(count == 1);
+
+		mst::sparse_group group(set, other);
+		REQUIRE(group.size() == 1);
+		REQUIRE(group.contains(id(5, 1)));
+		REQUIRE(!group.contains(id(2000, 254)));
+	}
+}
+
+TEST_CASE("sparse_view<Sets...>: intersection of several sets", "[sparse_set]")
+{
+	sparse_set<int, uint32_t> a;
+	sparse_set<float, uint32_t> b;
+	sparse_set<std::string, uint32_t> c;
+
+	for(uint32_t i = 0; i < 1000; ++i)
+	{
+		a.emplace(i, (int)i);
+		if(i % 2 == 0)
+			b.emplace(i, (float)i * 0.5f);
+		if(i % 3 == 0)
+			c.emplace(i, std::to_string(i));
+	}
+	// an index far outside the pages of the other sets
+	c.emplace(1'000'000, "far");
+
+	std::set<uint32_t> expected;
+	for(uint32_t i = 0; i < 1000; i += 6)
+		expected.insert(i);
+
+	SECTION("each")
+	{
+		std::set<uint32_t> visited;
+		mst::sparse_view view(a, b, c);
+		view.each([&](uint32_t index, int& x, float& y, std::string& z) {
+			REQUIRE(x == (int)index);
+			REQUIRE(y == (float)index * 0.5f);
+			REQUIRE(z == std::to_string(index));
+			x = -x;
+			visited.insert(index);
+		});
+		REQUIRE(visited == expected);
+		REQUIRE(a.at(6) == -6);
+		REQUIRE(a.at(7) == 7);
+	}
+	SECTION("iterator")
+	{
+		std::set<uint32_t> visited;
+		const auto& cb = b;
+		for(auto [index, z, y, x] : mst::sparse_view(c, cb, a))
+		{
+			static_assert(std::is_same<decltype(y), const float&>::value, "const set, const refs");
+			REQUIRE(x == (int)index);
+			REQUIRE(y == (float)index * 0.5f);
+			REQUIRE(z == std::to_string(index));
+			visited.insert(index);
+		}
+		REQUIRE(visited == expected);
+	}
+	SECTION("a single set visits everything")
+	{
+		size_t count = 0;
+		mst::sparse_view(b).each([&](uint32_t, float&) { ++count; });
+		REQUIRE(count == b.size());
+	}
+	SECTION("an empty set visits nothing")
+	{
+		sparse_set<int, uint32_t> empty;
+		mst::sparse_view view(a, empty);
+		REQUIRE(view.size_hint() == 0);
+		REQUIRE(view.begin() == view.end());
+		view.each([](uint32_t, int&, int&) { FAIL("nothing to visit"); });
+	}
+}
+
+TEST_CASE("sparse_set<E,I>: sparse_group", "[sparse_set]")
+{
+	sparse_set<int, uint32_t> a;
+	sparse_set<float, uint32_t> b;
+	sparse_set<std::string, uint32_t> c;
+
+	for(uint32_t i = 0; i < 300; ++i)
+	{
+		a.emplace(i, (int)i);
+		if(i % 2 == 0)
+			b.emplace(i, (float)i);
+		if(i % 3 == 0)
+			c.emplace(i, std::to_string(i));
+	}
+
+	// the grouped indices are the intersection, at the front of each set, in the same order
+	auto verify = [&](const auto& group) {
+		std::set<uint32_t> expected;
+		for(const auto& elem : a)
+		{
+			if(b.contains(elem.first) && c.contains(elem.first))
+				expected.insert(elem.first);
+		}
+		REQUIRE(group.size() == expected.size());
+
+		std::set<uint32_t> grouped;
+		for(size_t i = 0; i < group.size(); ++i)
+		{
+			const auto index = (a.begin() + i)->first;
+			REQUIRE((b.begin() + i)->first == index);
+			REQUIRE((c.begin() + i)->first == index);
+			REQUIRE(group.contains(index));
+			grouped.insert(index);
+		}
+		REQUIRE(grouped == expected);
+	};
+
+	mst::sparse_group group(a, b, c);
+	verify(group);
+	REQUIRE(group.size() == 50);
+
+	SECTION("each")
+	{
+		size_t count = 0;
+		group.each([&](uint32_t index, int& x, float& y, std::string& z) {
+			REQUIRE(x == (int)index);
+			REQUIRE(y == (float)index);
+			REQUIRE(z == std::to_string(index));
+			++count;
+		});
+		REQUIRE(count == group.size());
+
+		for(auto [index, x, y, z] : group)
+		{
+			REQUIRE(x == (int)index);
+			REQUIRE(z == std::to_string(index));
+		}
+	}
+	SECTION("random access iterator")
+	{
+		const auto first = group.begin();
+		const auto last = group.end();
+
+		REQUIRE(last - first == (ptrdiff_t)group.size());
+		REQUIRE(first < last);
+		REQUIRE(last > first);
+		REQUIRE(first <= first);
+		REQUIRE(last >= first);
+		REQUIRE(!(last < first));
+
+		REQUIRE(2 + first == first + 2);
+		REQUIRE(std::get<0>(first[5]) == std::get<0>(*(first + 5)));
+		REQUIRE(std::get<1>(first[5]) == (int)std::get<0>(first[5]));
+
+		// std::reverse_iterator goes through operator[] and the comparisons
+		const auto rfirst = std::make_reverse_iterator(last);
+		REQUIRE(std::get<0>(rfirst[0]) == std::get<0>(*(last - 1)));
+		REQUIRE(rfirst < std::make_reverse_iterator(first));
+	}
+	SECTION("random emplace and erase")
+	{
+		std::mt19937 rng(1234);
+		for(int i = 0; i < 5000; ++i)
+		{
+			const uint32_t index = rng() % 400;
+			const auto set = rng() % 3;
+			if(set == 0)
+			{
+				if(a.contains(index))
+					a.erase(index);
+				else
+					a.emplace(index, (int)index);
+			}
+			else if(set == 1)
+			{
+				if(b.contains(index))
+					b.erase(index);
+				else
+					b.emplace(index, (float)index);
+			}
+			else
+			{
+				if(c.contains(index))
+					c.erase(index);
+				else
+					REQUIRE(c.emplace(index, std::to_string(index)).first == index);
+			}
+
+			if(i % 100 == 0)
+				verify(group);
+		}
+		verify(group);
+
+		group.each([&](uint32_t index, int& x, float& y, std::string& z) {
+			REQUIRE(x == (int)index);
+			REQUIRE(y == (float)index);
+			REQUIRE(z == std::to_string(index));
+		});
+	}
+	SECTION("clear")
+	{
+		b.clear();
+		REQUIRE(group.empty());
+		b.emplace(6, 6.0f);
+		verify(group);
+		REQUIRE(group.size() == 1);
+	}
+}
@@ -28,6 +28,12 @@
 #include <set_assertions.h>
 
 #include <mstride_map.h>
+#include <mexecutor.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
 
 namespace {
 
@@ -584,3 +590,357 @@ TEST_CASE("mst::stride_map_iterator<T>: operator-> gives member access", "[strid
 	REQUIRE(it->x == 3);
 	REQUIRE(it->y == 4);
 }
+
+namespace {
+
+struct stride_map_test_vertex
+{
+	float position[3];
+	int id;
+	double weight;
+	char tag;
+};
+
+} // namespace
+
+TEST_CASE("mst::stride_map: column views one field of every record", "[stride_map]")
+{
+	mst::stride_map sm(sizeof(stride_map_test_vertex), 5);
+	for(size_t i = 0; i < 5; ++i)
+	{
+		auto& v = sm.index<stride_map_test_vertex>(i);
+		v.id = (int)i * 10;
+		v.weight = (double)i;
+	}
+
+	auto ids = sm.column<int>(offsetof(stride_map_test_vertex, id));
+	REQUIRE(ids.size() == 5);
+	for(size_t i = 0; i < 5; ++i)
+		REQUIRE(ids[i] == (int)i * 10);
+
+	for(int& id : ids)
+		id += 1;
+	for(size_t i = 0; i < 5; ++i)
+		REQUIRE(sm.index<stride_map_test_vertex>(i).id == (int)i * 10 + 1);
+
+	const mst::stride_map& csm = sm;
+	auto weights = csm.column<double>(offsetof(stride_map_test_vertex, weight));
+	REQUIRE(weights.end() - weights.begin() == 5);
+	REQUIRE(weights[3] == 3.0);
+}
+
+TEST_CASE("mst::stride_map: gather and scatter round trip a field", "[stride_map]")
+{
+	// odd sizes exercise both the wide and the remainder paths
+	for(size_t count : { 0, 1, 3, 4, 7, 8, 9, 17, 100 })
+	{
+		mst::stride_map sm(sizeof(stride_map_test_vertex), count);
+		for(auto& position : sm.column<float>(offsetof(stride_map_test_vertex, position)))
+			position = 0.0f;
+
+		std::vector<int> ids(count);
+		std::vector<double> weights(count);
+		std::vector<char> tags(count);
+		for(size_t i = 0; i < count; ++i)
+		{
+			ids[i] = (int)(i * 7 + 1);
+			weights[i] = (double)i * 0.5;
+			tags[i] = (char)('a' + i % 26);
+		}
+
+		sm.scatter(offsetof(stride_map_test_vertex, id), ids.data());
+		sm.scatter(offsetof(stride_map_test_vertex, weight), weights.data());
+		sm.scatter(offsetof(stride_map_test_vertex, tag), tags.data());
+
+		for(size_t i = 0; i < count; ++i)
+		{
+			const auto& v = sm.index<stride_map_test_vertex>(i);
+			REQUIRE(v.id == ids[i]);
+			REQUIRE(v.weight == weights[i]);
+			REQUIRE(v.tag == tags[i]);
+			REQUIRE(v.position[0] == 0.0f);
+		}
+
+		std::vector<int> outIds(count + 1, -1);
+		std::vector<double> outWeights(count);
+		std::vector<char> outTags(count);
+		sm.gather(offsetof(stride_map_test_vertex, id), outIds.data());
+		sm.gather(offsetof(stride_map_test_vertex, weight), outWeights.data());
+		sm.gather(offsetof(stride_map_test_vertex, tag), outTags.data());
+
+		REQUIRE(std::equal(ids.begin(), ids.end(), outIds.begin()));
+		REQUIRE(outIds[count] == -1);
+		REQUIRE(outWeights == weights);
+		REQUIRE(outTags == tags);
+	}
+}
+
+TEST_CASE("mst::stride_map: reserve and geometric growth", "[stride_map]")
+{
+	mst::stride_map sm(sizeof(int));
+	REQUIRE(sm.capacity() == 0);
+	REQUIRE(sm.data() == nullptr);
+
+	sm.reserve(100);
+	REQUIRE(sm.capacity() == 100);
+	REQUIRE(sm.empty());
+
+	// reserve never shrinks
+	sm.reserve(10);
+	REQUIRE(sm.capacity() == 100);
+
+	const void* data = sm.data();
+	for(int i = 0; i < 100; ++i)
+		sm.push_back<int>(i);
+	REQUIRE(sm.data() == data);
+
+	sm.push_back<int>(100);
+	REQUIRE(sm.capacity() == 200);
+
+	sm.shrink_to_fit();
+	REQUIRE(sm.capacity() == 101);
+
+	// dropping below a quarter of the capacity halves it
+	sm.resize(20);
+	REQUIRE(sm.capacity() == 50);
+	for(int i = 0; i < 20; ++i)
+		REQUIRE(sm.index<int>((size_t)i) == i);
+}
+
+TEST_CASE("mst::stride_map: removing records keeps the reserved capacity", "[stride_map]")
+{
+	mst::stride_map sm(sizeof(int));
+
+	sm.reserve(100000);
+	const void* data = sm.data();
+
+	sm.push_back<int>(1);
+	sm.pop_back();
+	REQUIRE(sm.empty());
+	REQUIRE(sm.capacity() == 100000);
+	REQUIRE(sm.data() == data);
+
+	for(int i = 0; i < 1000; ++i)
+		sm.push_back<int>(i);
+	sm.resize(10);
+	sm.erase(sm.begin<int>());
+	REQUIRE(sm.capacity() == 100000);
+
+	// growing past the reservation can still collapse back down to it
+	sm.resize(200001);
+	sm.resize(10);
+	REQUIRE(sm.capacity() >= 100000);
+	REQUIRE(sm.capacity() < 200001);
+
+	// clear() and shrink_to_fit() release the reservation
+	sm.shrink_to_fit();
+	REQUIRE(sm.capacity() == 10);
+	sm.resize(1);
+	REQUIRE(sm.capacity() == 5);
+
+	sm.reserve(1000);
+	sm.clear();
+	REQUIRE(sm.capacity() == 0);
+	sm.push_back<int>(1);
+	sm.pop_back();
+	REQUIRE(sm.capacity() == 0);
+}
+
+TEST_CASE("mst::stride_map: aligned records", "[stride_map]")
+{
+	mst::stride_map sm(sizeof(stride_map_test_point) + 4, 3, 32);
+	REQUIRE(sm.stride() == 32);
+	REQUIRE(sm.alignment() == 32);
+
+	for(int i = 0; i < 200; ++i)
+	{
+		sm.push_back();
+		sm.back<stride_map_test_point>().x = i;
+		REQUIRE((reinterpret_cast<uintptr_t>(sm.data()) & 31) == 0);
+	}
+	REQUIRE(sm.index<stride_map_test_point>(202).x == 199);
+
+	mst::stride_map copy = sm;
+	REQUIRE((reinterpret_cast<uintptr_t>(copy.data()) & 31) == 0);
+	REQUIRE(copy.index<stride_map_test_point>(103).x == 100);
+
+	sm.shrink_to_fit();
+	REQUIRE((reinterpret_cast<uintptr_t>(sm.data()) & 31) == 0);
+
+	sm.clear();
+	sm.set_stride(40);
+	REQUIRE(sm.stride() == 64);
+}
+
+TEST_CASE("mst::stride_map: large maps keep their contents across the mapped threshold",
+	"[stride_map]")
+{
+	const size_t count = 2 * MST_STRIDE_MAP_MREMAP_THRESHOLD / sizeof(uint64_t);
+
+	mst::stride_map sm(sizeof(uint64_t));
+	for(size_t i = 0; i < count; ++i)
+		sm.push_back<uint64_t>(i);
+
+	for(size_t i = 0; i < count; i += 997)
+		REQUIRE(sm.index<uint64_t>(i) == i);
+	REQUIRE(sm.back<uint64_t>() == count - 1);
+
+	mst::stride_map copy = sm;
+	REQUIRE(copy.index<uint64_t>(count / 2) == count / 2);
+
+	while(sm.size() > 16)
+		sm.pop_back();
+	sm.shrink_to_fit();
+	for(size_t i = 0; i < 16; ++i)
+		REQUIRE(sm.index<uint64_t>(i) == i);
+}
+
+namespace {
+
+struct stride_map_test_sort_record
+{
+	uint32_t key;
+	int32_t signedKey;
+	float floatKey;
+	double doubleKey;
+	uint32_t order;
+	char payload[20];
+};
+
+mst::stride_map make_sort_records(size_t count)
+{
+	std::mt19937 rng(1234);
+	mst::stride_map sm(sizeof(stride_map_test_sort_record), count);
+	for(size_t i = 0; i < count; ++i)
+	{
+		auto& r = sm.index<stride_map_test_sort_record>(i);
+		// few distinct keys, so stability is observable
+		r.key = rng() % 64 + (rng() % 2 ? 0x10000 : 0);
+		r.signedKey = (int32_t)(rng() % 2001) - 1000;
+		r.floatKey = (float)r.signedKey * 0.25f;
+		r.doubleKey = -(double)r.signedKey * 1e10;
+		r.order = (uint32_t)i;
+		memset(r.payload, (int)(i & 0x7F), sizeof(r.payload));
+	}
+	return sm;
+}
+
+template<typename K, typename Less>
+void check_sorted(const mst::stride_map& sm, K stride_map_test_sort_record::*member, Less less)
+{
+	for(size_t i = 0; i < sm.size(); ++i)
+	{
+		const auto& r = sm.index<stride_map_test_sort_record>(i);
+		// every record moved as a whole
+		REQUIRE(r.payload[19] == (char)(r.order & 0x7F));
+		if(i == 0)
+			continue;
+
+		const auto& prev = sm.index<stride_map_test_sort_record>(i - 1);
+		REQUIRE(!less(r.*member, prev.*member));
+		if(!less(prev.*member, r.*member))
+			REQUIRE(prev.order < r.order);
+	}
+}
+
+} // namespace
+
+TEST_CASE("mst::stride_map: sort_by_key is a stable radix sort", "[stride_map]")
+{
+	const auto less = [](auto a, auto b) { return a < b; };
+
+	SECTION("unsigned keys")
+	{
+		auto sm = make_sort_records(5000);
+		sm.sort_by_key<uint32_t>(offsetof(stride_map_test_sort_record, key));
+		check_sorted(sm, &stride_map_test_sort_record::key, less);
+	}
+	SECTION("signed keys")
+	{
+		auto sm = make_sort_records(5000);
+		sm.sort_by_key<int32_t>(offsetof(stride_map_test_sort_record, signedKey));
+		check_sorted(sm, &stride_map_test_sort_record::signedKey, less);
+	}
+	SECTION("float keys")
+	{
+		auto sm = make_sort_records(5000);
+		sm.sort_by_key<float>(offsetof(stride_map_test_sort_record, floatKey));
+		check_sorted(sm, &stride_map_test_sort_record::floatKey, less);
+	}
+	SECTION("double keys")
+	{
+		auto sm = make_sort_records(5000);
+		sm.sort_by_key<double>(offsetof(stride_map_test_sort_record, doubleKey));
+		check_sorted(sm, &stride_map_test_sort_record::doubleKey, less);
+	}
+	SECTION("custom comparison")
+	{
+		const auto greater = [](uint32_t a, uint32_t b) { return a > b; };
+
+		auto sm = make_sort_records(5000);
+		sm.sort_by_key<uint32_t>(offsetof(stride_map_test_sort_record, key), greater);
+		check_sorted(sm, &stride_map_test_sort_record::key, greater);
+	}
+	SECTION("tiny maps")
+	{
+		mst::stride_map sm(sizeof(int));
+		sm.sort_by_key<int>(0);
+		REQUIRE(sm.empty());
+
+		sm.push_back<int>(3);
+		sm.sort_by_key<int>(0);
+		REQUIRE(sm.index<int>(0) == 3);
+
+		sm.push_back<int>(-3);
+		sm.sort_by_key<int>(0);
+		REQUIRE(sm.index<int>(0) == -3);
+		REQUIRE(sm.index<int>(1) == 3);
+	}
+}
+
+TEST_CASE("mst::stride_map: partition", "[stride_map]")
+{
+	for(size_t count : { 0, 1, 2, 7, 100, 1001 })
+	{
+		auto sm = make_sort_records(count);
+		const auto isSmall = [](const stride_map_test_sort_record& r) { return r.key < 32; };
+
+		const auto records = mst::range<stride_map_test_sort_record>(sm);
+		const size_t expected = (size_t)std::count_if(records.begin(), records.end(), isSmall);
+
+		const size_t split = sm.partition<stride_map_test_sort_record>(isSmall);
+		REQUIRE(split == expected);
+		REQUIRE(sm.size() == count);
+
+		for(size_t i = 0; i < count; ++i)
+		{
+			const auto& r = sm.index<stride_map_test_sort_record>(i);
+			REQUIRE(isSmall(r) == (i < split));
+			REQUIRE(r.payload[0] == (char)(r.order & 0x7F));
+		}
+	}
+}
+
+TEST_CASE("mst::stride_map: parallel_transform visits every record once", "[stride_map]")
+{
+	auto sm = make_sort_records(10007);
+
+	SECTION("inline_executor")
+	{
+		sm.parallel_transform<stride_map_test_sort_record>(
+			mst::threading::inline_executor(), [](stride_map_test_sort_record& r) { ++r.key; });
+	}
+	SECTION("thread_executor")
+	{
+		mst::threading::thread_executor executor(4);
+		sm.parallel_transform<stride_map_test_sort_record>(
+			executor, [](stride_map_test_sort_record& r) { ++r.key; });
+	}
+
+	auto reference = make_sort_records(10007);
+	for(size_t i = 0; i < sm.size(); ++i)
+	{
+		REQUIRE(sm.index<stride_map_test_sort_record>(i).key ==
+			reference.index<stride_map_test_sort_record>(i).key + 1);
+	}
+}
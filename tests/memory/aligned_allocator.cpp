@@ -87,4 +87,49 @@ TEST_CASE("aligned_allocator<T>: vector", "[memory][allocator]")
 	const auto alignment = 64;
 
 	REQUIRE((intValue & (alignment - 1)) == 0);
-}
\ No newline at end of file
+}
+
+TEST_CASE("page_allocator<T>: huge pages below 2MB share an arena", "[memory][allocator]")
+{
+	constexpr size_t hugePageSize = 2 * 1024 * 1024;
+	constexpr size_t blockSize = 256 * 1024;
+
+	mst::page_allocator<char, true> alloc;
+
+	std::vector<char*> blocks;
+	for(size_t i = 0; i < 16; ++i)
+	{
+		blocks.push_back(alloc.allocate(blockSize));
+		blocks.back()[blockSize - 1] = 1;
+	}
+
+#if MST_PLATFORM_LINUX
+	// every block follows the one before it, or starts a new 2MB aligned arena
+	for(size_t i = 1; i < blocks.size(); ++i)
+	{
+		const auto address = reinterpret_cast<uintptr_t>(blocks[i]);
+
+		REQUIRE((blocks[i] == blocks[i - 1] + blockSize || address % hugePageSize == 0));
+	}
+#endif
+
+	for(auto block : blocks)
+	{
+		alloc.deallocate(block, blockSize);
+	}
+
+	// the emptied current arena, the one of the last block, is reused from its start
+	auto block = alloc.allocate(blockSize);
+	block[0] = 1;
+#if MST_PLATFORM_LINUX
+	const auto lastAddress = reinterpret_cast<uintptr_t>(blocks.back());
+	REQUIRE(reinterpret_cast<uintptr_t>(block) == lastAddress - lastAddress % hugePageSize);
+#endif
+	alloc.deallocate(block, blockSize);
+
+	auto hugeBlock = alloc.allocate(hugePageSize);
+#if MST_PLATFORM_LINUX
+	REQUIRE(reinterpret_cast<uintptr_t>(hugeBlock) % hugePageSize == 0);
+#endif
+	alloc.deallocate(hugeBlock, hugePageSize);
+}